@@ -0,0 +1,180 @@
+#ifndef INC_AUTOTUNE_H_
+#define INC_AUTOTUNE_H_
+
+#include "stm32f7xx_hal.h"
+#include "pid.h"
+#include <stddef.h>
+
+/**
+ * @file autotune.h
+ * @brief Automatyczny dobór nastaw PID metodą przekaźnikową (Åström-Hägglund).
+ *
+ * Na czas strojenia wyjście PID zastępowane jest przekaźnikiem z histerezą wokół temperatury
+ * zadanej: bias + d poniżej (zadana - histereza), bias - d powyżej (zadana + histereza).
+ * Obiekt wchodzi w cykl graniczny, którego okres Tu i amplituda a wyznaczają wzmocnienie
+ * krytyczne Ku = 4d / (pi * sqrt(a^2 - histereza^2)). Pomiar jest ciągły i ma stałą pamięć:
+ * ekstrema i suma wyjścia bieżącego cyklu oraz średnie poprzednich cykli. Bias jest po każdym
+ * cyklu korygowany tak, aby czasy grzania i chłodzenia były równe (symetryczny cykl);
+ * d zmniejszane jest przy braku miejsca w zakresie wyjścia tylko przed serią zgodnych cykli,
+ * a Ku liczone jest ze średniego d tych samych cykli, z których wyznaczono a.
+ * Strojenie kończy się po AUTOTUNE_STABLE_CYCLES kolejnych cyklach zgodnych z dokładnością
+ * AUTOTUNE_TOLERANCE.
+ *
+ * Przekazanie do PID następuje przy przejściu temperatury przez wartość zadaną: integrator
+ * ustawiany jest tak, aby pierwsze wyjście PID było równe średniemu wyjściu przekaźnika
+ * (ustalone wypełnienie), więc przełączenie nie powoduje skoku sterowania. Przerwanie
+ * lub błąd strojenia przywraca poprzednie nastawy w ten sam sposób.
+ *
+ * Nastawy przeliczane są na postać PID z pid.c: składowa całkująca sumuje uchyb raz na
+ * (delay_samples + 1) taktów, a różniczkująca liczona jest ze zmiany temperatury (nie
+ * uchybu), dlatego tłumiące Kd ma znak ujemny.
+ */
+
+#define AUTOTUNE_HYSTERESIS       0.1     /**< Histereza przekaźnika [°C] */
+#define AUTOTUNE_AMPLITUDE        5.0     /**< Amplituda przekaźnika d (jednostki wyjścia PID) */
+#define AUTOTUNE_TOLERANCE        0.05    /**< Dopuszczalna względna zmiana okresu i amplitudy */
+#define AUTOTUNE_STABLE_CYCLES    3u      /**< Kolejne zgodne cykle kończące pomiar */
+#define AUTOTUNE_MAX_DEVIATION    10.0    /**< Maksymalny uchyb w czasie strojenia [°C] */
+#define AUTOTUNE_MAX_TICKS        28800u  /**< Limit czasu strojenia (1 h przy 125 ms) [takty] */
+#define AUTOTUNE_SETPOINT_TOLERANCE 0.05  /**< Zmiana zadanej przerywająca strojenie [°C] */
+
+/**
+ * @brief Stan strojenia.
+ */
+typedef enum {
+    AUTOTUNE_IDLE = 0,          /**< Regulacja PID, strojenie nie było uruchomione */
+    AUTOTUNE_RELAY,             /**< Przekaźnik, pomiar cyklu granicznego */
+    AUTOTUNE_HANDOVER,          /**< Nastawy wyznaczone, oczekiwanie na przejście przez zadaną */
+    AUTOTUNE_DONE,              /**< Nowe nastawy w użyciu */
+    AUTOTUNE_FAILED             /**< Strojenie przerwane, poprzednie nastawy w użyciu */
+} AUTOTUNE_State;
+
+/**
+ * @brief Reguła doboru nastaw z Ku i Tu.
+ */
+typedef enum {
+    AUTOTUNE_RULE_ZN_PID = 0,   /**< Ziegler-Nichols PID: 0,6Ku, Ti = Tu/2, Td = Tu/8 */
+    AUTOTUNE_RULE_TYREUS_LUYBEN,/**< Tyreus-Luyben: Ku/2,2, Ti = 2,2Tu, Td = Tu/6,3 */
+    AUTOTUNE_RULE_NO_OVERSHOOT, /**< Ziegler-Nichols bez przeregulowania: 0,2Ku, Ti = Tu/2, Td = Tu/3 */
+    AUTOTUNE_RULE_ZN_PI,        /**< Ziegler-Nichols PI: 0,45Ku, Ti = Tu/1,2 */
+    AUTOTUNE_RULES
+} AUTOTUNE_Rule;
+
+/**
+ * @brief Przyczyna przerwania strojenia.
+ */
+typedef enum {
+    AUTOTUNE_ERR_NONE = 0,
+    AUTOTUNE_ERR_ABORTED,       /**< Przerwane poleceniem */
+    AUTOTUNE_ERR_SETPOINT,      /**< Zmiana temperatury zadanej */
+    AUTOTUNE_ERR_DEVIATION,     /**< Uchyb większy niż AUTOTUNE_MAX_DEVIATION */
+    AUTOTUNE_ERR_TIMEOUT,       /**< Brak ustalonego cyklu w AUTOTUNE_MAX_TICKS */
+    AUTOTUNE_ERR_AMPLITUDE,     /**< Amplituda cyklu nie większa od histerezy */
+    AUTOTUNE_ERR_SENSOR         /**< Tryb bezpieczny toru pomiarowego */
+} AUTOTUNE_Error;
+
+/**
+ * @brief Stan strojenia przekaźnikowego.
+ */
+typedef struct {
+    PID *pid;                   /**< Strojony regulator */
+    volatile AUTOTUNE_State state;
+    volatile uint8_t abort_request; /**< Przerwanie zgłoszone spoza przerwania regulatora */
+    AUTOTUNE_Rule rule;
+    AUTOTUNE_Error error;
+
+    double setpoint;            /**< Temperatura zadana z chwili startu */
+    double bias;                /**< Środek przekaźnika */
+    double amplitude;           /**< Amplituda przekaźnika d */
+    uint8_t high;               /**< Stan przekaźnika (1 - grzanie) */
+    uint8_t started;            /**< Czy wykonano pierwszy takt */
+    uint8_t in_cycle;           /**< Czy trwa pełny cykl (od przełączenia na grzanie) */
+    uint32_t ticks;             /**< Takty od startu */
+    uint32_t phase_ticks;       /**< Takty w bieżącym stanie przekaźnika */
+    uint32_t high_ticks;        /**< Czas grzania w bieżącym cyklu [takty] */
+    uint32_t cycle_ticks;       /**< Takty bieżącego cyklu */
+    double y_max;               /**< Maksimum temperatury w cyklu */
+    double y_min;               /**< Minimum temperatury w cyklu */
+    double output_sum;          /**< Suma wyjścia w cyklu */
+    double prev_error;          /**< Uchyb z poprzedniego taktu */
+
+    uint16_t cycles;            /**< Zakończone pełne cykle */
+    uint16_t stable;            /**< Kolejne cykle zgodne ze średnią */
+    double period;              /**< Średni okres cyklu Tu [s] */
+    double amp;                 /**< Średnia amplituda temperatury a [°C] */
+    double relay_amp;           /**< Średnia amplituda przekaźnika d w tych samych cyklach */
+    double output_avg;          /**< Średnie wyjście przekaźnika w ostatnim cyklu */
+    double Ku;                  /**< Wzmocnienie krytyczne */
+
+    double Kp, Ki, Kd;          /**< Nastawy wyznaczone (postać pid.c) */
+    double saved_Kp, saved_Ki, saved_Kd;    /**< Nastawy sprzed strojenia */
+    double saved_integral_min, saved_integral_max;
+} AUTOTUNE;
+
+extern AUTOTUNE autotune;
+
+/**
+ * @brief Inicjalizuje strojenie.
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ * @param pid Strojony regulator.
+ */
+void AUTOTUNE_Init(AUTOTUNE *at, PID *pid);
+
+/**
+ * @brief Uruchamia strojenie wokół bieżącej temperatury zadanej regulatora.
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ * @param rule Reguła doboru nastaw.
+ * @return 1, jeżeli strojenie zostało uruchomione, 0 gdy już trwa lub reguła jest nieznana.
+ */
+uint8_t AUTOTUNE_Start(AUTOTUNE *at, AUTOTUNE_Rule rule);
+
+/**
+ * @brief Zgłasza przerwanie strojenia (wykonywane w najbliższym AUTOTUNE_Update).
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ */
+void AUTOTUNE_Abort(AUTOTUNE *at);
+
+/**
+ * @brief Przerywa strojenie natychmiast, bez przekazania sterowania do PID.
+ *        Wywoływać z przerwania regulatora, gdy wyjście wyznacza co innego (tryb bezpieczny).
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ * @param error Przyczyna.
+ */
+void AUTOTUNE_Cancel(AUTOTUNE *at, AUTOTUNE_Error error);
+
+/**
+ * @brief Czy strojenie zastępuje regulator PID.
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ */
+uint8_t AUTOTUNE_IsActive(const AUTOTUNE *at);
+
+/**
+ * @brief Krok strojenia - wywoływać w takcie regulatora zamiast PID_ComputeWithRate.
+ *
+ * Po zakończeniu strojenia wykonuje pierwszy krok PID z nowymi nastawami.
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ * @param input Estymata temperatury [°C].
+ * @param rate Estymata szybkości zmian temperatury [°C/s].
+ * @return Wyjście regulatora.
+ */
+double AUTOTUNE_Update(AUTOTUNE *at, double input, double rate);
+
+/**
+ * @brief Zapisuje stan strojenia w postaci jednej linii tekstu.
+ *
+ * Format: "A<stan> <reguła> <błąd> <cykle> <Tu> <a> <Ku> <Kp> <Ki> <Kd>\n".
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ * @param line Bufor na linię.
+ * @param size Rozmiar bufora.
+ * @return Długość linii (bez znaku końca napisu).
+ */
+int AUTOTUNE_Format(const AUTOTUNE *at, char *line, size_t size);
+
+#endif /* INC_AUTOTUNE_H_ */
@@ -0,0 +1,194 @@
+/**
+  ******************************************************************************
+  * @file    bmp2_array.h
+  * @brief   Array of BMP2xx sensors sharing one SPI bus;
+  *          DMA-chained read sequence and fused outputs.
+  *
+  ******************************************************************************
+  */
+#ifndef INC_BMP2_ARRAY_H_
+#define INC_BMP2_ARRAY_H_
+
+/* Includes ------------------------------------------------------------------*/
+#include "bmp2_config.h"
+
+/* Typedef -------------------------------------------------------------------*/
+typedef enum {
+  BMP2_FUSION_MEAN = 0,   //! Mean of all valid sensors
+  BMP2_FUSION_MEDIAN,     //! Median of all valid sensors
+  BMP2_FUSION_VOTE        //! Mean of the majority agreeing with the median within tolerance
+} BMP2_FusionTypeDef;
+
+typedef enum {
+  BMP2_ACQ_NORMAL = 0,    //! Free-running conversions (normal mode), read whenever due
+  BMP2_ACQ_FORCED         //! One conversion per BMP2_Array_StartConversion() (forced mode)
+} BMP2_AcqModeTypeDef;
+
+typedef struct {
+  struct bmp2_dev*   Dev[BMP2_NUM_OF_SENSORS];
+  uint8_t            Count;
+  uint8_t            ActiveMask;        //! Sensors found during initialization
+  uint8_t            ValidMask;         //! Sensors with valid data in the last sequence
+  BMP2_FusionTypeDef Fusion;
+  double             VoteTolTemp;       //! Vote tolerance [degC]
+  double             VoteTolPress;      //! Vote tolerance [hPa]
+  double             Temp[BMP2_NUM_OF_SENSORS];   //! Last temperature per sensor [degC]
+  double             Press[BMP2_NUM_OF_SENSORS];  //! Last pressure per sensor [hPa]
+  double             FusedTemp;         //! Fused temperature [degC], NAN if no valid sensor
+  double             FusedPress;        //! Fused pressure [hPa], NAN if no valid sensor
+  uint32_t           SequenceCount;
+  uint32_t           ErrorCount;        //! SPI/DMA errors
+  uint32_t           TimeoutCount;      //! Sequences aborted with BMP2_Array_Abort()
+  volatile uint8_t   Busy;
+  uint8_t            Current;
+  BMP2_AcqModeTypeDef AcqMode;
+  uint32_t           MeasTime;          //! Longest conversion time of active sensors [us]
+  uint8_t            Trigger;           //! Sequence in progress writes ctrl_meas instead of reading
+  uint32_t           TriggerCount;      //! Completed conversion triggers (forced mode)
+  uint32_t           StaleCount;        //! Sensors read while still converting (forced mode)
+  volatile uint8_t   Reconfig;          //! Blocking reconfiguration in progress, sequences are refused
+  uint32_t           ReconfigSkipCount; //! Triggers and reads skipped by the caller during Reconfig
+  uint8_t            TxBuffer[BMP2_REG_ADDR_LEN + BMP2_BURST_LEN];
+  uint8_t            RxBuffer[BMP2_NUM_OF_SENSORS][BMP2_REG_ADDR_LEN + BMP2_BURST_LEN];
+  uint8_t            TriggerBuffer[BMP2_NUM_OF_SENSORS][BMP2_REG_ADDR_LEN + 1];  //! ctrl_meas write per sensor
+  uint8_t            TriggerRxBuffer[BMP2_REG_ADDR_LEN + 1];
+} BMP2_ArrayTypeDef;
+
+/* Define --------------------------------------------------------------------*/
+#define BMP2_ARRAY_VOTE_TOL_TEMP   0.5   //! [degC]
+#define BMP2_ARRAY_VOTE_TOL_PRESS  1.0   //! [hPa]
+#define BMP2_ARRAY_TRIGGER_MARGIN_US  500  //! Trigger lead reserve for SPI and interrupt latency [us]
+
+/* Public variables ----------------------------------------------------------*/
+extern BMP2_ArrayTypeDef bmp2array;
+
+/* Public function prototypes ------------------------------------------------*/
+
+/*!
+ *  @brief Sensor array initialization function.
+ *  @note Configures chip-select lines of all sensors, initializes every sensor with
+ *        BMP2_Init() and marks the ones that respond as active. All sensors must
+ *        share the same SPI bus.
+ *  @param[in] arr   : Sensor array structure
+ *  @param[in] devs  : Table of BMP2xx device structures
+ *  @param[in] count : Number of sensors (<= BMP2_NUM_OF_SENSORS)
+ *  @param[in] fusion: Fusion method for FusedTemp/FusedPress
+ *
+ *  @return Number of active sensors
+ */
+uint8_t BMP2_Array_Init(BMP2_ArrayTypeDef* arr, struct bmp2_dev* const devs[], uint8_t count, BMP2_FusionTypeDef fusion);
+
+/*!
+ *  @brief Starts the DMA-chained read of all active sensors.
+ *  @note Sensors are read back-to-back, one chip select at a time; the CPU is only
+ *        involved between transfers. BMP2_Array_ReadCpltCallback() is called
+ *        when the whole sequence is done.
+ *  @param[in] arr : Sensor array structure
+ *
+ *  @retval HAL_OK   -> Sequence started.
+ *  @retval HAL_BUSY -> Previous sequence or reconfiguration still in progress.
+ *  @retval HAL_ERROR-> No active sensor.
+ */
+HAL_StatusTypeDef BMP2_Array_StartRead(BMP2_ArrayTypeDef* arr);
+
+/*!
+ *  @brief Switches all active sensors to forced mode.
+ *  @note Oversampling and filter settings are kept. From now on every conversion has
+ *        to be started with BMP2_Array_StartConversion(), at least
+ *        BMP2_Array_GetTriggerLead() microseconds before BMP2_Array_StartRead().
+ *        The first conversion is started by this function. Blocking SPI is used.
+ *  @param[in] arr : Sensor array structure
+ *
+ *  @retval HAL_OK   -> All active sensors switched.
+ *  @retval HAL_BUSY -> Sequence in progress, nothing changed.
+ *  @retval HAL_ERROR-> No active sensor or a sensor did not accept the settings
+ *                      (it is removed from ActiveMask).
+ */
+HAL_StatusTypeDef BMP2_Array_SetForcedMode(BMP2_ArrayTypeDef* arr);
+
+/*!
+ *  @brief Starts a forced-mode conversion on all active sensors.
+ *  @note ctrl_meas is written to the sensors back-to-back with the same DMA chain as
+ *        the read sequence; BMP2_Array_ReadCpltCallback() is not called for it.
+ *        May be called from interrupt context.
+ *  @param[in] arr : Sensor array structure
+ *
+ *  @retval HAL_OK   -> Triggers started.
+ *  @retval HAL_BUSY -> Sequence or reconfiguration in progress.
+ *  @retval HAL_ERROR-> No active sensor or array not in forced mode.
+ */
+HAL_StatusTypeDef BMP2_Array_StartConversion(BMP2_ArrayTypeDef* arr);
+
+/*!
+ *  @brief Changes oversampling and IIR filter settings of all active sensors.
+ *  @note Uses blocking SPI (about 2 ms per sensor, see BMP2_SetOversampling()). Reconfig is
+ *        set for the duration and sequences requested meanwhile are refused with HAL_BUSY;
+ *        interrupt handlers should check Reconfig and skip the trigger or read instead of
+ *        aborting. MeasTime is updated - in forced mode the trigger lead has to be
+ *        recomputed with BMP2_Array_GetTriggerLead().
+ *  @param[in] arr     : Sensor array structure
+ *  @param[in] os_mode : BMP2_OS_MODE_...
+ *  @param[in] filter  : BMP2_FILTER_...
+ *
+ *  @retval HAL_OK   -> All active sensors reconfigured.
+ *  @retval HAL_BUSY -> Sequence in progress, nothing changed.
+ *  @retval HAL_ERROR-> No active sensor or a sensor did not accept the settings.
+ */
+HAL_StatusTypeDef BMP2_Array_SetOversampling(BMP2_ArrayTypeDef* arr, uint8_t os_mode, uint8_t filter);
+
+/*!
+ *  @brief Minimum time between BMP2_Array_StartConversion() and BMP2_Array_StartRead().
+ *  @note bmp2_compute_meas_time() returns typical conversion times; the maximum
+ *        times in the BMP280 datasheet are up to ~16% longer, so a quarter of the
+ *        conversion time and BMP2_ARRAY_TRIGGER_MARGIN_US are added.
+ *  @param[in] arr : Sensor array structure
+ *
+ *  @return Trigger lead [us]
+ */
+uint32_t BMP2_Array_GetTriggerLead(const BMP2_ArrayTypeDef* arr);
+
+/*!
+ *  @brief Aborts the read sequence in progress.
+ *  @note Intended for a sequence that did not complete within its time budget
+ *        (e.g. one control period). The pending DMA transfer is aborted, chip select
+ *        released and the sequence is finished with the remaining sensors marked as
+ *        failed, so BMP2_Array_ReadCpltCallback() is still called exactly once.
+ *  @param[in] arr : Sensor array structure
+ *
+ *  @retval HAL_OK   -> Sequence aborted.
+ *  @retval HAL_ERROR-> No sequence in progress.
+ */
+HAL_StatusTypeDef BMP2_Array_Abort(BMP2_ArrayTypeDef* arr);
+
+/*!
+ *  @brief Fuses the last readouts of the sensors selected by mask.
+ *  @note Uses the fusion method of the array; bits outside ValidMask are ignored.
+ *  @param[in]  arr   : Sensor array structure
+ *  @param[in]  mask  : Sensors to include
+ *  @param[out] temp  : Fused temperature [degC], NAN if none selected (may be NULL)
+ *  @param[out] press : Fused pressure [hPa], NAN if none selected (may be NULL)
+ */
+void BMP2_Array_Fuse(const BMP2_ArrayTypeDef* arr, uint8_t mask, double* temp, double* press);
+
+/*!
+ *  @brief To be called from HAL_SPI_TxRxCpltCallback().
+ *  @param[in] arr  : Sensor array structure
+ *  @param[in] hspi : SPI handle which completed the transfer
+ */
+void BMP2_Array_SpiTxRxCpltCallback(BMP2_ArrayTypeDef* arr, SPI_HandleTypeDef* hspi);
+
+/*!
+ *  @brief To be called from HAL_SPI_ErrorCallback().
+ *  @param[in] arr  : Sensor array structure
+ *  @param[in] hspi : SPI handle which reported the error
+ */
+void BMP2_Array_SpiErrorCallback(BMP2_ArrayTypeDef* arr, SPI_HandleTypeDef* hspi);
+
+/*!
+ *  @brief Read sequence complete callback (interrupt context).
+ *  @note Weak function, to be overridden by the application.
+ *  @param[in] arr : Sensor array structure
+ */
+void BMP2_Array_ReadCpltCallback(BMP2_ArrayTypeDef* arr);
+
+#endif /* INC_BMP2_ARRAY_H_ */
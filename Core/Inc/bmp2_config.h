@@ -42,6 +42,10 @@ typedef struct {
 #define BMP2_REG_ADDR_INDEX   0  //! @see BMP280 technical note p. 31-32
 #define BMP2_REG_ADDR_LEN     1  //! @see BMP280 technical note p. 31-32
 
+#define BMP2_BURST_LEN       10  //! Registers 0xF3..0xFC: status, ctrl_meas, config, reserved, press[3], temp[3]
+#define BMP2_BURST_STATUS_INDEX 0
+#define BMP2_BURST_DATA_INDEX   4
+
 #define BMP2_TIMEOUT          5
 #define BMP2_NUM_OF_SENSORS   2
 
@@ -53,6 +57,7 @@ typedef struct {
 
 /* Public variables ----------------------------------------------------------*/
 extern struct bmp2_dev bmp2dev;
+extern struct bmp2_dev bmp2dev_2;
 
 /* Public function prototypes ------------------------------------------------*/
 
@@ -71,6 +76,58 @@ extern struct bmp2_dev bmp2dev;
  */
 int8_t BMP2_Init(struct bmp2_dev* dev);
 
+/*!
+ *  @brief Switches BMP2xx to forced mode (one conversion per trigger).
+ *  @note Keeps the oversampling and filter settings made by BMP2_Init(). Setting the
+ *        forced mode starts the first conversion; every following one is started
+ *        by writing the returned ctrl_meas value back to BMP2_REG_CTRL_MEAS.
+ *  @param[in]  dev       : BMP2xx device structure
+ *  @param[out] ctrl_meas : ctrl_meas register value that starts a conversion
+ *  @param[out] meas_time : Conversion time [us]
+ *
+ *  @return Status of execution
+ *
+ *  @retval BMP2_OK -> Success.
+ *  @retval <0 -> Failure.
+ *
+ */
+int8_t BMP2_SetForcedMode(struct bmp2_dev* dev, uint8_t* ctrl_meas, uint32_t* meas_time);
+
+/*!
+ *  @brief Changes oversampling and IIR filter settings of BMP2xx.
+ *  @note bmp2_set_config() soft-resets the sensor, so the filter history is lost and
+ *        data registers hold the reset value until the next conversion. In normal
+ *        mode the sensor is restarted; in forced mode it stays asleep until the next
+ *        trigger. Blocking SPI and bmp2_delay_us() are used (about 2 ms).
+ *  @param[in]  dev       : BMP2xx device structure
+ *  @param[in]  os_mode   : BMP2_OS_MODE_...
+ *  @param[in]  filter    : BMP2_FILTER_...
+ *  @param[out] ctrl_meas : ctrl_meas register value that starts a forced conversion
+ *  @param[out] meas_time : Conversion time [us]
+ *
+ *  @return Status of execution
+ *
+ *  @retval BMP2_OK -> Success.
+ *  @retval <0 -> Failure.
+ *
+ */
+int8_t BMP2_SetOversampling(struct bmp2_dev* dev, uint8_t os_mode, uint8_t filter, uint8_t* ctrl_meas, uint32_t* meas_time);
+
+/*!
+ *  @brief Converts raw data registers into compensated temperature and pressure.
+ *  @param[in]  dev      : BMP2xx device structure (calibration parameters)
+ *  @param[in]  reg_data : Content of registers 0xF7..0xFC (BMP2_P_T_LEN bytes)
+ *  @param[out] comp_data: Compensated data; pressure in [Pa], temperature in [degC]
+ *
+ *  @return Status of execution
+ *
+ *  @retval 0 -> Success.
+ *  @retval >0 -> Warning (value clipped).
+ *  @retval <0 -> Failure (raw data out of range, e.g. conversion skipped or bus fault).
+ *
+ */
+int8_t BMP2_CompensateRaw(struct bmp2_dev *dev, const uint8_t *reg_data, struct bmp2_data *comp_data);
+
 /*!
  *  @brief Function for reading the sensor's registers through SPI bus.
  *
@@ -114,6 +171,41 @@ BMP2_INTF_RET_TYPE bmp2_spi_write(uint8_t reg_addr, const uint8_t *reg_data, uin
  */
 void bmp2_delay_us(uint32_t period_us, void *intf_ptr);
 
+/*!
+ *  @brief Parses a status+data burst (registers 0xF3..0xFC) into compensated values.
+ *  @note Temperature is compensated once and its t_fine is reused for pressure.
+ *  @param[in]  dev   : BMP2xx device structure
+ *  @param[in]  burst : BMP2_BURST_LEN bytes read from BMP2_REG_STATUS
+ *  @param[out] temp  : Temperature measurement [degC]
+ *  @param[out] press : Pressure measurement [hPa]
+ *
+ *  @return Status of execution
+ *
+ *  @retval 0 -> Success.
+ *  @retval >0 -> Warning (value clipped).
+ *  @retval <0 -> Failure.
+ *
+ */
+int8_t BMP2_ParseBurst(struct bmp2_dev *dev, const uint8_t *burst, double* temp, double* press);
+
+/*!
+ *  @brief Reads status and data registers in a single SPI burst and returns
+ *         both compensated temperature and pressure.
+ *  @note The burst is repeated (up to MaxRetry times) only while a conversion
+ *        is in progress; each attempt is one SPI transaction.
+ *  @param[in]  dev   : BMP2xx device structure
+ *  @param[out] temp  : Temperature measurement [degC], NAN on failure
+ *  @param[out] press : Pressure measurement [hPa], NAN on failure
+ *
+ *  @return Status of execution
+ *
+ *  @retval 0 -> Success.
+ *  @retval >0 -> Warning (value clipped).
+ *  @retval <0 -> Failure.
+ *
+ */
+int8_t BMP2_ReadTempPress(struct bmp2_dev *dev, double* temp, double* press);
+
 /*!
  *  @brief This internal API is used to get compensated pressure and temperature data.
  *  @param[in]  dev   : BMP2xx device structure
@@ -0,0 +1,132 @@
+#ifndef INC_COMMAND_H_
+#define INC_COMMAND_H_
+
+#include "stm32f7xx_hal.h"
+
+/**
+ * @file command.h
+ * @brief Odbiór i interpretacja poleceń tekstowych przesyłanych przez UART, wirtualny port USB i UDP.
+ *
+ * Polecenia są odbierane do bufora linii (osobnego dla każdego łącza), a wykonywane
+ * w pętli głównej po odebraniu znaku końca linii. Odpowiedzi wysyłane są łączem, z którego
+ * przyszło polecenie. Pierwszy znak linii wybiera polecenie:
+ *
+ * - "Z<temperatura>"                  ustawienie temperatury zadanej, np. "Z25.50",
+ * - "SA<pre>,<post>,<tryb>,<poziom>"  uzbrojenie rejestratora (tryb: 0 ręczny, 1 zbocze rosnące,
+ *                                     2 zbocze malejące, 3 zmiana wartości zadanej),
+ * - "ST"                              ręczne wyzwolenie rejestratora,
+ * - "SX"                              przerwanie rejestracji lub wysyłania,
+ * - "A", "A<reguła>", "AX"            raport strojenia przekaźnikowego PID, start strojenia wokół bieżącej
+ *                                     zadanej (0 Ziegler-Nichols PID, 1 Tyreus-Luyben, 2 bez przeregulowania,
+ *                                     3 Ziegler-Nichols PI) lub przerwanie z przywróceniem nastaw,
+ * - "F", "F1", "F0", "FR"             raport sprzężenia w przód od temperatury zadanej (model strat ciepła),
+ *                                     włączenie, wyłączenie, wyzerowanie modelu,
+ * - "G", "GS<tablica>", "GT<tablica>", "GX"
+ *                                     raport harmonogramu nastaw PID, wczytanie tablicy indeksowanej
+ *                                     temperaturą zadaną (GS) lub mierzoną (GT), wyłączenie harmonogramu;
+ *                                     tablica to do GAINSCHED_MAX_POINTS punktów "<x>,<Kp>,<Ki>,<Kd>,<imin>,<imax>"
+ *                                     rozdzielonych ';' w kolejności rosnącej temperatury,
+ * - "H"                               raport liczników błędów toru pomiarowego,
+ * - "I"                               raport uśpień rdzenia między taktami,
+ * - "L", "LR"                         raport czasów obsługi i opóźnień przerwań (LR - po wyzerowaniu),
+ * - "P", "P<poziom>", "PA"            raport polityki próbkowania czujników, wymuszenie poziomu
+ *                                     (0 szybki, 1 pośredni, 2 cichy) lub powrót do wyboru automatycznego,
+ * - "B<prędkość>"                     zmiana prędkości transmisji (odpowiedź "B<prędkość> OK"/"ERR"
+ *                                     z dotychczasową prędkością, następnie przełączenie),
+ * - "BP"                              próbka potwierdzająca nową prędkość (odpowiedź "BP <prędkość>");
+ *                                     bez niej po CMD_BAUD_PROBE_TIMEOUT ms następuje powrót,
+ * - "N"                               raport stanu sieci (adres IP, stan łącza, identyfikator urządzenia,
+ *                                     liczniki stosu, wolne/minimum/błędy puli buforów).
+ *
+ * Przez UDP (port CMD_UDP_PORT) każdy datagram zawiera jedną linię, a odpowiedź wysyłana jest
+ * na adres i port nadawcy.
+ */
+
+/** Maksymalna długość linii polecenia (bez znaku końca linii) */
+#define CMD_LINE_LEN 256u
+/** Czas na potwierdzenie nowej prędkości transmisji próbką "BP" [ms] */
+#define CMD_BAUD_PROBE_TIMEOUT 1000u
+/** Zapas ponad czas transmisji odpowiedzi przez UART [ms] */
+#define CMD_UART_TIMEOUT_MARGIN 20u
+/** Port UDP, na którym przyjmowane są polecenia */
+#define CMD_UDP_PORT 5760u
+
+/**
+ * @brief Łącze, którym przyszło polecenie (i którym wysyłana jest odpowiedź).
+ */
+typedef enum {
+    CMD_LINK_UART = 0,
+    CMD_LINK_USB,
+    CMD_LINK_UDP,
+    CMD_LINK_COUNT
+} CMD_Link;
+
+/**
+ * @brief Inicjalizuje odbiór poleceń i uruchamia odbiór w przerwaniu.
+ *
+ * @param huart Wskaźnik na strukturę UART, z której odbierane są polecenia.
+ * @param setpoint Wskaźnik na zmienną przechowującą temperaturę zadaną.
+ */
+void CMD_Init(UART_HandleTypeDef *huart, double *setpoint);
+
+/**
+ * @brief Przyjmuje odebrany znak i wznawia odbiór. Wywoływana z HAL_UART_RxCpltCallback.
+ *
+ * @param huart Wskaźnik na strukturę UART, która zgłosiła zakończenie odbioru.
+ */
+void CMD_RxCpltCallback(UART_HandleTypeDef *huart);
+
+/**
+ * @brief Przyjmuje dane odebrane przez port USB. Wywoływana z CDC_ReceiveCallback.
+ *
+ * @param data Odebrane dane.
+ * @param len Liczba bajtów.
+ */
+void CMD_RxUsb(const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Przyjmuje datagram UDP z poleceniem. Wywoływana z NET_UdpReceiveCallback.
+ *
+ * @param src_ip Adres nadawcy (na niego wysyłana jest odpowiedź).
+ * @param src_port Port nadawcy.
+ * @param data Odebrane dane.
+ * @param len Liczba bajtów.
+ */
+void CMD_RxUdp(uint32_t src_ip, uint16_t src_port, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Wysyła dane łączem, z którego przyszło ostatnie polecenie.
+ *
+ * @param data Dane do wysłania.
+ * @param len Liczba bajtów.
+ * @return HAL_OK lub status błędu/zajętości łącza (dane nie zostały wysłane).
+ */
+HAL_StatusTypeDef CMD_Write(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Zwraca łącze, którym wysyłany jest zarejestrowany przebieg.
+ */
+CMD_Link CMD_GetDumpLink(void);
+
+/**
+ * @brief Wysyła dane przebiegu łączem, z którego uzbrojono rejestrator ("SA").
+ *
+ * @param data Dane do wysłania.
+ * @param len Liczba bajtów.
+ * @return HAL_OK lub status błędu/zajętości łącza (dane nie zostały wysłane).
+ */
+HAL_StatusTypeDef CMD_WriteDump(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Wznawia odbiór po błędzie transmisji. Wywoływana z HAL_UART_ErrorCallback.
+ *
+ * @param huart Wskaźnik na strukturę UART, która zgłosiła błąd.
+ */
+void CMD_ErrorCallback(UART_HandleTypeDef *huart);
+
+/**
+ * @brief Wykonuje odebrane polecenie, jeżeli jest dostępne. Wywoływana w pętli głównej.
+ */
+void CMD_Process(void);
+
+#endif /* INC_COMMAND_H_ */
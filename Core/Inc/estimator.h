@@ -0,0 +1,65 @@
+#ifndef INC_ESTIMATOR_H_
+#define INC_ESTIMATOR_H_
+
+#include <stdint.h>
+
+/**
+ * @file estimator.h
+ * @brief Estymator stanu (temperatura i jej szybkość zmian) typu alfa-beta.
+ *
+ * Filtr alfa-beta jest ustaloną postacią filtru Kalmana dla modelu o stałej prędkości.
+ * Wzmocnienia mogą być podane wprost lub wyznaczone z wariancji szumu procesu i pomiaru
+ * (indeks śledzenia Kalaty). Obliczenia są wykonywane w pojedynczej precyzji, aby
+ * zmieścić się w takcie regulatora bez kosztu emulacji liczb double.
+ */
+
+/**
+ * @brief Stan estymatora alfa-beta.
+ */
+typedef struct {
+    float x;                    /**< Estymata temperatury [°C] */
+    float v;                    /**< Estymata szybkości zmian temperatury [°C/s] */
+    float alpha;                /**< Wzmocnienie korekcji położenia */
+    float beta;                 /**< Wzmocnienie korekcji prędkości */
+    float dt;                   /**< Okres próbkowania [s] */
+    uint8_t initialized;        /**< Czy estymator otrzymał pierwszy pomiar */
+} ESTIMATOR;
+
+/**
+ * @brief Inicjalizuje estymator ze wzmocnieniami podanymi wprost.
+ *
+ * @param est Wskaźnik do struktury estymatora.
+ * @param alpha Wzmocnienie korekcji położenia (0-1).
+ * @param beta Wzmocnienie korekcji prędkości (0-2).
+ * @param dt Okres próbkowania w sekundach.
+ */
+void ESTIMATOR_Init(ESTIMATOR *est, float alpha, float beta, float dt);
+
+/**
+ * @brief Inicjalizuje estymator wzmocnieniami ustalonego filtru Kalmana.
+ *
+ * @param est Wskaźnik do struktury estymatora.
+ * @param process_noise Odchylenie standardowe przyspieszenia zmian temperatury [°C/s^2].
+ * @param meas_noise Odchylenie standardowe szumu pomiaru [°C].
+ * @param dt Okres próbkowania w sekundach.
+ */
+void ESTIMATOR_InitFromNoise(ESTIMATOR *est, float process_noise, float meas_noise, float dt);
+
+/**
+ * @brief Aktualizuje estymatę nowym pomiarem.
+ *
+ * @param est Wskaźnik do struktury estymatora.
+ * @param measurement Zmierzona temperatura [°C].
+ * @return Estymata temperatury po korekcji [°C].
+ */
+float ESTIMATOR_Update(ESTIMATOR *est, float measurement);
+
+/**
+ * @brief Wykonuje tylko krok predykcji (brak pomiaru w bieżącym takcie).
+ *
+ * @param est Wskaźnik do struktury estymatora.
+ * @return Przewidywana temperatura [°C].
+ */
+float ESTIMATOR_Predict(ESTIMATOR *est);
+
+#endif /* INC_ESTIMATOR_H_ */
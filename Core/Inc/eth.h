@@ -29,19 +29,51 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "net.h"
+#include "eth_pool.h"
 /* USER CODE END Includes */
 
 extern ETH_HandleTypeDef heth;
 
 /* USER CODE BEGIN Private defines */
+/** Sieć lokalna urządzenia; adres hosta wyznaczany jest z numeru seryjnego układu */
+#define ETH_IP_NETWORK          NET_IP(192, 168, 1, 0)
+#define ETH_IP_NETMASK          NET_IP(255, 255, 255, 0)
+#define ETH_IP_GATEWAY          NET_IP(192, 168, 1, 1)
+/** Zakres adresów hostów: ETH_IP_HOST_FIRST .. ETH_IP_HOST_FIRST + ETH_IP_HOST_COUNT - 1 */
+#define ETH_IP_HOST_FIRST       100u
+#define ETH_IP_HOST_COUNT       100u
 
+/** Adres układu PHY (LAN8742A) na magistrali MDIO */
+#define ETH_PHY_ADDRESS         0u
+/** Okres sprawdzania stanu łącza [ms] */
+#define ETH_LINK_POLL_PERIOD    500u
 /* USER CODE END Private defines */
 
 void MX_ETH_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+/**
+ * @brief Zwraca identyfikator urządzenia wyznaczony z numeru seryjnego układu.
+ */
+uint32_t ETH_DeviceId(void);
+
+/**
+ * @brief Inicjalizuje stos sieciowy na kontrolerze ETH. Wywoływana po MX_ETH_Init.
+ *
+ * Kontroler jest uruchamiany dopiero po wykryciu łącza w ETH_Poll.
+ */
+void ETH_NetInit(void);
 
+/**
+ * @brief Sprawdza stan łącza i przekazuje odebrane ramki do stosu. Wywoływana w pętli głównej.
+ */
+void ETH_Poll(void);
+
+/**
+ * @brief Czy łącze jest aktywne i kontroler uruchomiony.
+ */
+uint8_t ETH_IsLinkUp(void);
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
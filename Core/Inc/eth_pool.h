@@ -0,0 +1,67 @@
+#ifndef INC_ETH_POOL_H_
+#define INC_ETH_POOL_H_
+
+#include "stm32f7xx_hal.h"
+
+/**
+ * @file eth_pool.h
+ * @brief Pula buforów ramek Ethernet współdzielona przez odbiór i nadawanie.
+ *
+ * Bufory o stałym rozmiarze leżą w sekcji .EthBufferSection (SRAM2, obok deskryptorów DMA)
+ * i są wyrównane do linii pamięci podręcznej, więc operacje na pamięci podręcznej danych
+ * nie obejmują sąsiednich danych. Bufor przydzielony deskryptorowi odbiorczemu trafia bez
+ * kopiowania do stosu sieciowego, a bufor nadawczy jest budowany na miejscu i wraca do puli
+ * po zakończeniu transmisji. Pula nie korzysta ze sterty.
+ */
+
+/** Liczba buforów: 4 deskryptory RX + ramka przetwarzana + 4 deskryptory TX + ramka budowana */
+#define ETH_POOL_COUNT      10u
+/** Rozmiar bufora - wielokrotność linii pamięci podręcznej, nie mniejszy niż ETH_RX_BUF_SIZE */
+#define ETH_POOL_BUF_SIZE   1536u
+/** Rozmiar linii pamięci podręcznej Cortex-M7 */
+#define ETH_POOL_CACHE_LINE 32u
+
+/**
+ * @brief Liczniki puli.
+ */
+typedef struct {
+    uint32_t free;          /**< Wolne bufory */
+    uint32_t min_free;      /**< Najmniejsza liczba wolnych buforów od inicjalizacji */
+    uint32_t failures;      /**< Nieudane przydziały */
+} ETH_Pool_Stats;
+
+/**
+ * @brief Oznacza wszystkie bufory jako wolne.
+ */
+void ETH_Pool_Init(void);
+
+/**
+ * @brief Przydziela bufor.
+ *
+ * @return Bufor o rozmiarze ETH_POOL_BUF_SIZE lub NULL, gdy pula jest pusta.
+ */
+uint8_t *ETH_Pool_Alloc(void);
+
+/**
+ * @brief Zwraca bufor do puli. Można wywoływać z przerwania.
+ *
+ * @param buf Bufor z ETH_Pool_Alloc (wskaźniki spoza puli są ignorowane).
+ */
+void ETH_Pool_Free(uint8_t *buf);
+
+/**
+ * @brief Zapisuje zawartość bufora z pamięci podręcznej do SRAM przed odczytem przez DMA.
+ */
+void ETH_Pool_CleanForDma(const uint8_t *buf, uint32_t len);
+
+/**
+ * @brief Unieważnia pamięć podręczną bufora po zapisie przez DMA.
+ */
+void ETH_Pool_InvalidateFromDma(const uint8_t *buf, uint32_t len);
+
+/**
+ * @brief Zwraca liczniki puli.
+ */
+void ETH_Pool_GetStats(ETH_Pool_Stats *stats);
+
+#endif /* INC_ETH_POOL_H_ */
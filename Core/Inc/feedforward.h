@@ -0,0 +1,124 @@
+#ifndef INC_FEEDFORWARD_H_
+#define INC_FEEDFORWARD_H_
+
+#include "stm32f7xx_hal.h"
+#include "pid.h"
+#include <stddef.h>
+
+/**
+ * @file feedforward.h
+ * @brief Sprzężenie w przód od temperatury zadanej z modelu strat ciepła.
+ *
+ * W stanie ustalonym moc grzania równoważy straty do otoczenia, które w zakresie pracy są
+ * w przybliżeniu liniowe względem temperatury: u = a + b * (T - FF_T_REF). Składowa
+ * u_ff = a + b * (zadana - FF_T_REF) dodawana jest do wyjścia PID, więc po zmianie
+ * temperatury zadanej wypełnienie ustalone pojawia się od razu, a integrator koryguje tylko
+ * błąd modelu (bez nabierania całej wartości przy integral_max = 25).
+ *
+ * Model uczony jest w trakcie pracy rekursywną metodą najmniejszych kwadratów (2 parametry,
+ * współczynnik zapominania). Próbką jest średnie wyjście i średnia temperatura z
+ * FF_STEADY_TICKS kolejnych taktów stanu quasi-ustalonego (mała szybkość zmian temperatury,
+ * wyjście poza nasyceniem; uchyb może być niezerowy, np. przy zbyt małym integratorze), więc
+ * aktualizacja wykonywana jest rzadko i kosztuje kilkanaście działań. Nauka trwa także przy
+ * wyłączonym sprzężeniu.
+ *
+ * Zakres wyjścia PID przesuwany jest o u_ff, aby suma mieściła się w zakresie wypełnienia,
+ * a granice integratora obejmują Ki * I z zakresu [min - u_ff, max - u_ff] (także wartości
+ * ujemne - korekta modelu zawyżającego straty). Zastępują one granice z konfiguracji
+ * i harmonogramu nastaw, które wracają po wyłączeniu sprzężenia. Włączenie i aktualizacja
+ * modelu (bez zmiany zadanej) przenoszą różnicę składowej do integratora - wyjście nie skacze;
+ * przy wyłączeniu część przekraczająca przywrócone granice jest tracona. Skok u_ff następuje
+ * tylko przy zmianie temperatury zadanej.
+ */
+
+#define FF_T_REF            25.0    /**< Temperatura odniesienia modelu [°C] */
+#define FF_STEADY_TICKS     80u     /**< Takty stanu quasi-ustalonego na jedną próbkę (10 s) */
+#define FF_STEADY_RATE      0.01    /**< Maksymalna szybkość zmian w stanie quasi-ustalonym [°C/s] */
+#define FF_FORGETTING       0.98    /**< Współczynnik zapominania RLS (na próbkę) */
+#define FF_P_INIT_OFFSET    100.0   /**< Początkowa wariancja parametru a */
+#define FF_P_INIT_SLOPE     1.0     /**< Początkowa wariancja parametru b */
+#define FF_P_MAX            1000.0  /**< Ślad kowariancji, powyżej którego zapominanie jest wstrzymane */
+
+/**
+ * @brief Stan sprzężenia w przód i modelu strat.
+ */
+typedef struct {
+    PID *pid;                   /**< Regulator, do którego dodawana jest składowa */
+    double output_min;          /**< Zakres wyjścia regulatora z inicjalizacji */
+    double output_max;
+
+    double a;                   /**< Wypełnienie ustalone w FF_T_REF */
+    double b;                   /**< Przyrost wypełnienia ustalonego na stopień */
+    double p00, p01, p11;       /**< Kowariancja parametrów (macierz symetryczna) */
+    uint32_t updates;           /**< Liczba próbek modelu */
+
+    volatile uint8_t enable_request;    /**< Stan żądany poleceniem */
+    volatile uint8_t reset_request;     /**< Zgłoszone zerowanie modelu */
+    uint8_t enabled;            /**< Składowa dodawana do wyjścia */
+    double term;                /**< Bieżąca składowa u_ff */
+    double saved_integral_min;  /**< Granice integratora sprzed włączenia */
+    double saved_integral_max;
+    double setpoint;            /**< Zadana, dla której wyznaczono term */
+
+    uint16_t steady_ticks;      /**< Takty bieżącej próbki quasi-ustalonej */
+    double sum_output;          /**< Suma wyjścia w próbce */
+    double sum_temperature;     /**< Suma temperatury w próbce */
+} FF;
+
+extern FF feedforward;
+
+/**
+ * @brief Inicjalizuje sprzężenie (wyłączone, model pusty).
+ *
+ * @param ff Wskaźnik do struktury sprzężenia.
+ * @param pid Regulator; zapamiętywany jest jego zakres wyjścia.
+ */
+void FF_Init(FF *ff, PID *pid);
+
+/**
+ * @brief Włącza lub wyłącza sprzężenie (wykonywane w najbliższym FF_Apply).
+ *
+ * @param ff Wskaźnik do struktury sprzężenia.
+ * @param enable 1 - włączenie, 0 - wyłączenie.
+ */
+void FF_Enable(FF *ff, uint8_t enable);
+
+/**
+ * @brief Zgłasza wyzerowanie modelu (wykonywane w najbliższym FF_Apply).
+ *
+ * @param ff Wskaźnik do struktury sprzężenia.
+ */
+void FF_Reset(FF *ff);
+
+/**
+ * @brief Wyznacza składową u_ff i przesuwa zakres wyjścia PID. Wywoływać w takcie regulatora
+ *        przed PID_ComputeWithRate; wynik dodać do wyjścia PID.
+ *
+ * @param ff Wskaźnik do struktury sprzężenia.
+ * @return Składowa sprzężenia w przód (0, gdy wyłączone).
+ */
+double FF_Apply(FF *ff);
+
+/**
+ * @brief Uczy model na podstawie bieżącego taktu. Wywoływać po wyznaczeniu wyjścia.
+ *
+ * @param ff Wskaźnik do struktury sprzężenia.
+ * @param temperature Estymata temperatury [°C].
+ * @param rate Estymata szybkości zmian temperatury [°C/s].
+ * @param output Wyjście podane na grzałkę (PID + u_ff).
+ */
+void FF_Learn(FF *ff, double temperature, double rate, double output);
+
+/**
+ * @brief Zapisuje stan sprzężenia w postaci jednej linii tekstu.
+ *
+ * Format: "F<włączone> <próbki> <a> <b> <u_ff> <p00> <p11>\n".
+ *
+ * @param ff Wskaźnik do struktury sprzężenia.
+ * @param line Bufor na linię.
+ * @param size Rozmiar bufora.
+ * @return Długość linii (bez znaku końca napisu).
+ */
+int FF_Format(const FF *ff, char *line, size_t size);
+
+#endif /* INC_FEEDFORWARD_H_ */
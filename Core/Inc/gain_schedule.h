@@ -0,0 +1,133 @@
+#ifndef INC_GAIN_SCHEDULE_H_
+#define INC_GAIN_SCHEDULE_H_
+
+#include "stm32f7xx_hal.h"
+#include "pid.h"
+#include <stddef.h>
+
+/**
+ * @file gain_schedule.h
+ * @brief Harmonogram nastaw PID zależny od temperatury (gain scheduling).
+ *
+ * Tablica do GAINSCHED_MAX_POINTS punktów węzłowych: temperatura i przypisane do niej Kp, Ki,
+ * Kd oraz granice integratora. Między punktami nastawy interpolowane są liniowo, poza zakresem
+ * tablicy obowiązują wartości skrajnego punktu. Wejściem jest temperatura zadana albo
+ * estymata temperatury mierzonej.
+ *
+ * Nachylenia odcinków liczone są przy wczytaniu tablicy, a bieżący odcinek jest pamiętany,
+ * więc krok w takcie regulatora to porównanie z granicami odcinka i jedno mnożenie
+ * z dodawaniem na parametr. Tablica wczytywana jest w pętli głównej do drugiego bufora
+ * i przełączana jednym zapisem, dzięki czemu przerwanie regulatora nie widzi tablicy
+ * w połowie zapisu.
+ *
+ * Przy zmianie Ki integrator jest przeskalowywany tak, aby składowa całkująca się nie
+ * zmieniła (zmiana nastaw nie powoduje skoku wyjścia), i od razu ograniczany do nowych
+ * granic - skok pozostaje tylko wtedy, gdy składowa nie mieści się w nowym zakresie.
+ * Dla Ki = 0 integrator jest zerowany.
+ */
+
+#define GAINSCHED_MAX_POINTS    8u      /**< Maksymalna liczba punktów tablicy */
+
+/**
+ * @brief Parametry regulatora w punkcie tablicy (kolejność jak w poleceniu "G").
+ */
+typedef enum {
+    GAINSCHED_KP = 0,
+    GAINSCHED_KI,
+    GAINSCHED_KD,
+    GAINSCHED_INTEGRAL_MIN,
+    GAINSCHED_INTEGRAL_MAX,
+    GAINSCHED_PARAMS
+} GAINSCHED_Param;
+
+/**
+ * @brief Wielkość indeksująca tablicę.
+ */
+typedef enum {
+    GAINSCHED_SETPOINT = 0,     /**< Temperatura zadana */
+    GAINSCHED_TEMPERATURE       /**< Estymata temperatury */
+} GAINSCHED_Source;
+
+/**
+ * @brief Punkt węzłowy tablicy.
+ */
+typedef struct {
+    double x;                           /**< Temperatura [°C] */
+    double value[GAINSCHED_PARAMS];     /**< Nastawy w punkcie */
+} GAINSCHED_Point;
+
+/**
+ * @brief Tablica z nachyleniami odcinków.
+ */
+typedef struct {
+    GAINSCHED_Point point[GAINSCHED_MAX_POINTS];
+    double slope[GAINSCHED_MAX_POINTS][GAINSCHED_PARAMS];   /**< Nachylenie odcinka od punktu [1/°C] */
+    double x_min;               /**< Pierwszy punkt */
+    double x_max;               /**< Ostatni punkt */
+    uint8_t count;              /**< Liczba punktów (0 - harmonogram wyłączony) */
+    uint8_t last_segment;       /**< Ostatni odcinek (count - 2, 0 dla jednego punktu) */
+    GAINSCHED_Source source;
+} GAINSCHED_Table;
+
+/**
+ * @brief Stan harmonogramu nastaw.
+ */
+typedef struct {
+    GAINSCHED_Table table[2];   /**< Tablica aktywna i bufor wczytywania */
+    volatile uint8_t active;    /**< Indeks tablicy używanej w takcie regulatora */
+    uint8_t segment;            /**< Bieżący odcinek */
+    double x;                   /**< Ostatnia wartość indeksująca [°C] */
+} GAINSCHED;
+
+extern GAINSCHED gain_schedule;
+
+/**
+ * @brief Inicjalizuje harmonogram (wyłączony, nastawy regulatora bez zmian).
+ *
+ * @param gs Wskaźnik do struktury harmonogramu.
+ */
+void GAINSCHED_Init(GAINSCHED *gs);
+
+/**
+ * @brief Wczytuje tablicę i włącza harmonogram. Wywoływać z pętli głównej.
+ *
+ * @param gs Wskaźnik do struktury harmonogramu.
+ * @param source Wielkość indeksująca tablicę.
+ * @param points Punkty w kolejności rosnącej temperatury.
+ * @param count Liczba punktów (1..GAINSCHED_MAX_POINTS).
+ * @return 1, jeżeli tablica jest poprawna i została przełączona.
+ */
+uint8_t GAINSCHED_Load(GAINSCHED *gs, GAINSCHED_Source source, const GAINSCHED_Point *points, uint8_t count);
+
+/**
+ * @brief Wyłącza harmonogram; regulator zachowuje ostatnio ustawione nastawy.
+ *
+ * @param gs Wskaźnik do struktury harmonogramu.
+ */
+void GAINSCHED_Disable(GAINSCHED *gs);
+
+/**
+ * @brief Ustawia nastawy regulatora dla bieżącej temperatury. Wywoływać w takcie
+ *        regulatora przed PID_ComputeWithRate.
+ *
+ * @param gs Wskaźnik do struktury harmonogramu.
+ * @param pid Regulator.
+ * @param temperature Estymata temperatury [°C] (używana dla GAINSCHED_TEMPERATURE).
+ * @param apply_limits 0 - granice integratora ustala inny moduł (sprzężenie w przód).
+ */
+void GAINSCHED_Apply(GAINSCHED *gs, PID *pid, double temperature, uint8_t apply_limits);
+
+/**
+ * @brief Zapisuje harmonogram w postaci jednej linii tekstu.
+ *
+ * Format: "G<źródło> <punkty> <odcinek> <x>" i dla każdego punktu
+ * " <x>,<Kp>,<Ki>,<Kd>,<imin>,<imax>", zakończone "\n".
+ *
+ * @param gs Wskaźnik do struktury harmonogramu.
+ * @param line Bufor na linię.
+ * @param size Rozmiar bufora.
+ * @return Długość linii (bez znaku końca napisu).
+ */
+int GAINSCHED_Format(const GAINSCHED *gs, char *line, size_t size);
+
+#endif /* INC_GAIN_SCHEDULE_H_ */
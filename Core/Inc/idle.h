@@ -0,0 +1,75 @@
+#ifndef INC_IDLE_H_
+#define INC_IDLE_H_
+
+#include "stm32f7xx_hal.h"
+#include <stddef.h>
+
+/**
+ * @file idle.h
+ * @brief Uśpienie rdzenia między taktami regulatora z wyłączonym SysTick.
+ *
+ * Pętla główna nie ma nic do zrobienia przez większość taktu, więc zamiast obracać się
+ * w oczekiwaniu na HAL_GetTick, zasypia (tryb Sleep, WFI) do najbliższego zdarzenia:
+ * przepełnienia lub porównania TIM2, wywołania UTIMER albo terminu podanego przez pętlę.
+ * Na czas snu SysTick jest zatrzymywany - nie budzi rdzenia co 1 ms i nie wydłuża obsługi
+ * przerwań regulatora. Po przebudzeniu licznik HAL (uwTick) i licznik cykli DWT są
+ * uzupełniane o czas snu zmierzony licznikiem TIM2.
+ *
+ * Tryb Stop nie jest używany - wyłączyłby zegary TIM2, SPI/DMA, USB i ETH.
+ *
+ * Przerwania, które zostawiają pracę dla pętli głównej, wywołują IDLE_Wake; zgłoszenie
+ * sprawdzane jest przy wyłączonych przerwaniach tuż przed WFI, więc nie może zostać
+ * przespane.
+ */
+
+#define IDLE_MIN_SLEEP_US   100u        /**< Krótszy czas do zdarzenia - bez usypiania [us] */
+
+/**
+ * @brief Liczniki uśpień.
+ */
+typedef struct {
+    uint32_t sleeps;            /**< Liczba uśpień */
+    uint32_t skipped;           /**< Pominięte (zgłoszona praca lub zdarzenie zbyt blisko) */
+    uint32_t slept_ms;          /**< Łączny czas snu [ms] */
+    uint32_t max_us;            /**< Najdłuższy sen [us] */
+    uint32_t last_us;           /**< Ostatni sen [us] */
+} IDLE_Stats;
+
+/**
+ * @brief Inicjalizuje uśpienia.
+ *
+ * @param htim Licznik taktu regulatora zliczający mikrosekundy (mierzy czas snu).
+ */
+void IDLE_Init(TIM_HandleTypeDef *htim);
+
+/**
+ * @brief Zgłasza pracę dla pętli głównej - najbliższe IDLE_Sleep nie uśpi rdzenia.
+ *        Wywoływać z przerwań.
+ */
+void IDLE_Wake(void);
+
+/**
+ * @brief Usypia rdzeń do najbliższego zdarzenia, najdłużej na podany czas.
+ *
+ * @param max_us Termin pętli głównej [us] (UINT32_MAX - brak).
+ * @return Czas snu [us], 0 jeżeli rdzeń nie został uśpiony.
+ */
+uint32_t IDLE_Sleep(uint32_t max_us);
+
+/**
+ * @brief Zwraca liczniki uśpień.
+ */
+const IDLE_Stats *IDLE_GetStats(void);
+
+/**
+ * @brief Zapisuje liczniki w postaci jednej linii tekstu.
+ *
+ * Format: "I <uśpienia> <pominięte> <sen_ms> <najdłuższy_us> <ostatni_us>\n".
+ *
+ * @param line Bufor na linię.
+ * @param size Rozmiar bufora.
+ * @return Długość linii (bez znaku końca napisu).
+ */
+int IDLE_Format(char *line, size_t size);
+
+#endif /* INC_IDLE_H_ */
@@ -0,0 +1,120 @@
+#ifndef INC_LATENCY_H_
+#define INC_LATENCY_H_
+
+#include "stm32f7xx_hal.h"
+#include <stddef.h>
+
+/**
+ * @file latency.h
+ * @brief Pomiar czasów obsługi i opóźnień przerwań.
+ *
+ * Mapa priorytetów NVIC (grupa 4 - 16 poziomów wywłaszczania, 0 najwyższy):
+ *
+ * | Poziom | Przerwanie               | Zadanie                                              |
+ * |--------|--------------------------|------------------------------------------------------|
+ * | 0      | SysTick                  | podstawa czasu HAL (kilkadziesiąt cykli)             |
+ * | 1      | USART3                   | odbiór znaku bez FIFO - termin jednego znaku          |
+ * | 2      | DMA2 Stream0/1, TIM2     | sekwencja SPI czujników, takt, wyzwolenie konwersji, |
+ * |        |                          | wywołania UTIMER (wspólny poziom - bez wzajemnego    |
+ * |        |                          | wywłaszczania przy dostępie do stanu BMP2_Array)     |
+ * | 3      | OTG_FS, ETH              | USB CDC, zgłoszenie odebranej ramki (budzi pętlę)    |
+ * | 15     | PendSV                   | obliczenia regulatora (nadzór, estymator, PID, PWM)  |
+ *
+ * Dla każdego źródła mierzony jest czas obsługi (od wejścia do wyjścia, łącznie z czasem
+ * przerwań wywłaszczających). Opóźnienie wejścia da się zmierzyć bezpośrednio dla TIM2 (stan
+ * licznika przy wejściu to czas od zdarzenia aktualizacji) i PendSV (od zgłoszenia). Dla
+ * pozostałych podawane jest oszacowanie z pomiarów: najdłuższa obsługa innego przerwania na
+ * tym samym poziomie (nie może go wywłaszczyć) plus suma najdłuższych obsług przerwań
+ * o wyższym priorytecie. Sekcje z wyłączonymi przerwaniami (pula ETH, UTIMER) są krótkie
+ * i nie są w nim ujęte.
+ */
+
+/**
+ * @brief Mierzone przerwania.
+ */
+typedef enum {
+    LATENCY_SYSTICK = 0,
+    LATENCY_USART3,
+    LATENCY_DMA_SPI_RX,
+    LATENCY_DMA_SPI_TX,
+    LATENCY_TIM2,
+    LATENCY_OTG_FS,
+    LATENCY_ETH,
+    LATENCY_PENDSV,
+    LATENCY_SOURCES
+} LATENCY_Source;
+
+/**
+ * @brief Liczniki jednego przerwania (w cyklach rdzenia).
+ */
+typedef struct {
+    uint32_t count;             /**< Liczba obsłużonych przerwań */
+    uint32_t exec_max;          /**< Najdłuższy czas obsługi */
+    uint32_t entry_max;         /**< Najdłuższe zmierzone opóźnienie wejścia (TIM2, PendSV) */
+} LATENCY_Stat;
+
+/**
+ * @brief Zeruje liczniki.
+ */
+void LATENCY_Init(void);
+
+/**
+ * @brief Znacznik wejścia do obsługi przerwania.
+ *
+ * @return Stan licznika cykli, przekazywany do LATENCY_Exit.
+ */
+uint32_t LATENCY_Enter(void);
+
+/**
+ * @brief Zapisuje czas obsługi przerwania.
+ *
+ * @param src Źródło.
+ * @param start Wynik LATENCY_Enter z wejścia do obsługi.
+ */
+void LATENCY_Exit(LATENCY_Source src, uint32_t start);
+
+/**
+ * @brief Zapisuje zmierzone opóźnienie wejścia do obsługi.
+ *
+ * @param src Źródło.
+ * @param cycles Opóźnienie [cykle].
+ */
+void LATENCY_Entry(LATENCY_Source src, uint32_t cycles);
+
+/**
+ * @brief Zgłasza PendSV i zapamiętuje chwilę zgłoszenia (pomiar opóźnienia wejścia).
+ */
+void LATENCY_PendSVRequest(void);
+
+/**
+ * @brief Wywoływać na początku PendSV_Handler - zapisuje opóźnienie od zgłoszenia.
+ *
+ * @param start Wynik LATENCY_Enter z wejścia do obsługi.
+ */
+void LATENCY_PendSVEntry(uint32_t start);
+
+/**
+ * @brief Zapisuje czas od zdarzenia taktu do ustawienia wyjścia regulatora.
+ *
+ * @param cycles Czas [cykle].
+ */
+void LATENCY_Output(uint32_t cycles);
+
+/**
+ * @brief Zwraca liczniki przerwania.
+ */
+const LATENCY_Stat *LATENCY_Get(LATENCY_Source src);
+
+/**
+ * @brief Zapisuje raport w postaci linii tekstu.
+ *
+ * Dla każdego źródła: "L<nr> <priorytet> <liczba> <obsługa_ns> <wejście_ns> <oszacowanie_ns>\n"
+ * (wejście_ns = 0, gdy nie jest mierzone), na końcu "LO <takt_do_wyjścia_ns>\n".
+ *
+ * @param buf Bufor na raport.
+ * @param size Rozmiar bufora.
+ * @return Długość raportu (bez znaku końca napisu).
+ */
+int LATENCY_Format(char *buf, size_t size);
+
+#endif /* INC_LATENCY_H_ */
@@ -41,6 +41,11 @@
 /** Port GPIO używany do sterowania wyświetlaczem */
 #define LCD_GPIO_PORT GPIOD       /**< Port GPIOD */
 
+/** Czasy z noty katalogowej HD44780 (z zapasem) */
+#define LCD_E_PULSE_US  1u        /**< Szerokość impulsu E i przerwa między impulsami (min. 450 ns) */
+#define LCD_EXEC_US     50u       /**< Wykonanie komendy lub zapisu danych (37 us + 4 us) */
+#define LCD_CLEAR_US    2000u     /**< Wykonanie komendy czyszczenia ekranu (1,52 ms) */
+
 /**
  * @brief Funkcja opóźnienia.
  *
@@ -52,6 +57,16 @@
  */
 void LCD_Delay(uint32_t delay);
 
+/**
+ * @brief Funkcja opóźnienia mikrosekundowego.
+ *
+ * Odmierza czasy wymagane przez kontroler HD44780 licznikiem cykli (UTIMER_DelayUs)
+ * zamiast pełnych milisekund.
+ *
+ * @param delay Czas opóźnienia w mikrosekundach.
+ */
+void LCD_DelayUs(uint32_t delay);
+
 /**
  * @brief Wysyłanie 4-bitowego nibbla do wyświetlacza LCD.
  *
@@ -53,6 +53,7 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
+void wykonaj_regulacje(void);
 
 /* USER CODE END EFP */
 
@@ -135,6 +136,13 @@ void Error_Handler(void);
 #define BMP2_SDO_GPIO_Port GPIOE
 #define BMP2_SDA_Pin GPIO_PIN_6
 #define BMP2_SDA_GPIO_Port GPIOE
+#define BMP2_CSB2_Pin GPIO_PIN_3
+#define BMP2_CSB2_GPIO_Port GPIOE
+
+/* Priorytety przerwań spoza konfiguracji CubeMX (mapa wszystkich poziomów w latency.h) */
+#define IRQ_PRIO_SPI_DMA  2   /* jak TIM2 - sekwencja czujników bez wzajemnego wywłaszczania */
+#define IRQ_PRIO_USB      3
+#define IRQ_PRIO_ETH      3   /* tylko zgłoszenie odebranej ramki - ramki odbiera pętla główna */
 
 /* USER CODE END Private defines */
 
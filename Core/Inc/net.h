@@ -0,0 +1,167 @@
+#ifndef INC_NET_H_
+#define INC_NET_H_
+
+#include <stdint.h>
+
+/**
+ * @file net.h
+ * @brief Minimalny stos UDP/IPv4 z obsługą ARP i ICMP echo, bez alokacji pamięci.
+ *
+ * Stos nie zależy od HAL - sterownik karty sieciowej jest widoczny wyłącznie przez strukturę
+ * NET_Mac (przydział i zwalnianie buforów ramek oraz funkcja wysyłająca), dzięki czemu ten sam
+ * kod działa na kontrolerze ETH i na Linuksie z urządzeniem TAP (Tools/net_tap). Ramki odebrane
+ * przekazywane są do NET_Input, który odpowiada na ARP i ping, a datagramy UDP adresowane do
+ * urządzenia przekazuje do NET_UdpReceiveCallback.
+ *
+ * Dane nie są kopiowane: odpowiedzi ARP i ICMP echo powstają w buforze odebranej ramki, który
+ * jest od razu wysyłany, a datagramy UDP budowane są bezpośrednio w buforze nadawczym
+ * (NET_UdpBegin/NET_UdpEnd).
+ *
+ * Obsługiwane są tylko niefragmentowane datagramy IPv4. Adresy IP przechowywane są w
+ * porządku hosta (NET_IP(192,168,1,10)). Funkcje stosu nie są współbieżne - wszystkie
+ * (łącznie z NET_Input) należy wywoływać z jednego kontekstu, np. z pętli głównej.
+ */
+
+/** Adres IPv4 w porządku hosta */
+#define NET_IP(a, b, c, d)  (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) | (uint32_t)(d))
+
+#define NET_ETH_HDR_LEN     14u     /**< Nagłówek Ethernet */
+#define NET_IP_HDR_LEN      20u     /**< Nagłówek IPv4 bez opcji */
+#define NET_UDP_HDR_LEN     8u      /**< Nagłówek UDP */
+#define NET_FRAME_MAX       1514u   /**< Maksymalna ramka bez sumy CRC */
+/** Maksymalny rozmiar danych datagramu UDP */
+#define NET_UDP_PAYLOAD_MAX (NET_FRAME_MAX - NET_ETH_HDR_LEN - NET_IP_HDR_LEN - NET_UDP_HDR_LEN)
+
+#define NET_ARP_CACHE_LEN   8u      /**< Liczba zapamiętanych par IP-MAC */
+#define NET_TTL             64u     /**< TTL datagramów unicast */
+#define NET_MULTICAST_TTL   1u      /**< TTL datagramów multicast (tylko sieć lokalna) */
+
+/**
+ * @brief Wynik operacji stosu.
+ */
+typedef enum {
+    NET_OK = 0,         /**< Ramka przyjęta do wysłania */
+    NET_BUSY,           /**< Brak bufora lub adresu MAC odbiorcy (wysłano zapytanie ARP) */
+    NET_ERROR           /**< Błędne parametry lub błąd sterownika */
+} NET_Status;
+
+/**
+ * @brief Sterownik karty sieciowej widziany przez stos.
+ */
+typedef struct {
+    /** Zwraca bufor na ramkę nadawczą (co najmniej NET_FRAME_MAX bajtów) lub NULL */
+    uint8_t *(*tx_alloc)(void *ctx);
+    /** Wysyła ramkę z bufora z tx_alloc lub odebranego i przejmuje bufor (również przy błędzie) */
+    NET_Status (*tx_send)(void *ctx, uint8_t *frame, uint16_t len);
+    /** Zwraca do sterownika bufor z tx_alloc, który nie został wysłany */
+    void (*tx_release)(void *ctx, uint8_t *frame);
+    void *ctx;                      /**< Kontekst przekazywany do funkcji sterownika */
+    uint8_t addr[6];                /**< Adres MAC interfejsu */
+    uint8_t checksum_offload;       /**< Sumy kontrolne IP/UDP/ICMP liczone sprzętowo */
+} NET_Mac;
+
+/**
+ * @brief Konfiguracja adresów IPv4 (porządek hosta).
+ */
+typedef struct {
+    uint32_t ip;
+    uint32_t netmask;
+    uint32_t gateway;               /**< 0 - brak bramy, tylko sieć lokalna */
+} NET_Config;
+
+/**
+ * @brief Liczniki stosu.
+ */
+typedef struct {
+    uint32_t rx_frames;             /**< Odebrane ramki */
+    uint32_t rx_dropped;            /**< Ramki odrzucone (błędne lub nieobsługiwane) */
+    uint32_t tx_frames;             /**< Ramki przekazane do sterownika */
+    uint32_t tx_dropped;            /**< Ramki niewysłane (brak bufora, błąd sterownika) */
+    uint32_t arp_misses;            /**< Datagramy niewysłane z powodu braku adresu MAC */
+    uint32_t icmp_echo;             /**< Obsłużone zapytania ping */
+} NET_Stats;
+
+/**
+ * @brief Inicjalizuje stos.
+ *
+ * @param mac Sterownik karty sieciowej (struktura musi istnieć przez cały czas pracy).
+ * @param config Konfiguracja adresów (kopiowana).
+ */
+void NET_Init(const NET_Mac *mac, const NET_Config *config);
+
+/**
+ * @brief Przetwarza odebraną ramkę Ethernet (bez sumy CRC).
+ *
+ * Bufor ramki musi mieć co najmniej NET_FRAME_MAX bajtów i pochodzić z tej samej puli co
+ * bufory nadawcze - odpowiedzi ARP i ICMP echo są wysyłane w nim bez kopiowania.
+ *
+ * @param frame Ramka.
+ * @param len Długość ramki w bajtach.
+ * @return 1, jeżeli bufor został przekazany do NET_Mac.tx_send (sterownik nie może go zwolnić),
+ *         0 w przeciwnym wypadku.
+ */
+uint8_t NET_Input(uint8_t *frame, uint16_t len);
+
+/**
+ * @brief Przydziela bufor nadawczy dla datagramu UDP.
+ *
+ * Dane zapisywane są bezpośrednio w ramce, za miejscem na nagłówki. Bufor jest wysyłany
+ * lub zwalniany przez NET_UdpEnd; ponowne wywołanie przed NET_UdpEnd zwraca ten sam bufor.
+ *
+ * @return Miejsce na dane (NET_UDP_PAYLOAD_MAX bajtów) lub NULL, gdy brak wolnego bufora.
+ */
+uint8_t *NET_UdpBegin(void);
+
+/**
+ * @brief Uzupełnia nagłówki i wysyła datagram przygotowany przez NET_UdpBegin.
+ *
+ * Adres MAC odbiorcy wyznaczany jest z tablicy ARP (adres spoza sieci lokalnej - przez bramę),
+ * a dla adresów multicast 224.0.0.0/4 i rozgłoszeniowych bezpośrednio z adresu IP. Przy braku
+ * wpisu w tablicy wysyłane jest zapytanie ARP, a datagram jest odrzucany ze statusem NET_BUSY.
+ *
+ * @param dst_ip Adres odbiorcy.
+ * @param dst_port Port odbiorcy.
+ * @param src_port Port nadawcy.
+ * @param len Liczba bajtów danych (co najwyżej NET_UDP_PAYLOAD_MAX).
+ * @return NET_OK, NET_BUSY lub NET_ERROR.
+ */
+NET_Status NET_UdpEnd(uint32_t dst_ip, uint16_t dst_port, uint16_t src_port, uint16_t len);
+
+/**
+ * @brief Wysyła datagram UDP z kopią podanych danych (NET_UdpBegin + NET_UdpEnd).
+ *
+ * Przeznaczona dla krótkich odpowiedzi tekstowych; większe dane należy budować na miejscu.
+ *
+ * @param dst_ip Adres odbiorcy.
+ * @param dst_port Port odbiorcy.
+ * @param src_port Port nadawcy.
+ * @param data Dane.
+ * @param len Liczba bajtów (co najwyżej NET_UDP_PAYLOAD_MAX).
+ * @return NET_OK, NET_BUSY lub NET_ERROR.
+ */
+NET_Status NET_UdpSend(uint32_t dst_ip, uint16_t dst_port, uint16_t src_port, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Funkcja zwrotna odbioru datagramu UDP adresowanego do urządzenia.
+ *
+ * Domyślna implementacja (słaba) odrzuca dane. Dane są ważne tylko w trakcie wywołania.
+ *
+ * @param src_ip Adres nadawcy.
+ * @param src_port Port nadawcy.
+ * @param dst_port Port docelowy.
+ * @param data Dane.
+ * @param len Liczba bajtów.
+ */
+void NET_UdpReceiveCallback(uint32_t src_ip, uint16_t src_port, uint16_t dst_port, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Zwraca konfigurację adresów.
+ */
+const NET_Config *NET_GetConfig(void);
+
+/**
+ * @brief Zwraca liczniki stosu.
+ */
+const NET_Stats *NET_GetStats(void);
+
+#endif /* INC_NET_H_ */
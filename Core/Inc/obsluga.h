@@ -5,6 +5,8 @@
 #include "stm32f7xx_hal_tim.h"
 #include "pid.h"
 #include "bmp2_defs.h"
+#include "scope.h"
+#include "net.h"
 
 /**
  * @file obsluga.h
@@ -17,6 +19,27 @@
  * @date 25 styczeń 2025
  */
 
+/** Grupa multicast i port, na które wysyłana jest telemetria UDP */
+#define TELEMETRY_GROUP  NET_IP(239, 255, 76, 1)
+#define TELEMETRY_PORT   5761u
+/** Znacznik początku ramki telemetrii ("PPT1" w little-endian) */
+#define TELEMETRY_MAGIC  0x31545050u
+
+/**
+ * @brief Ramka telemetrii UDP (little-endian), wysyłana w każdym takcie regulatora.
+ *
+ * Identyfikator urządzenia pozwala odbiorcy rozróżnić sterowniki nadające do wspólnej grupy,
+ * a numer kolejny - wykryć zgubione datagramy.
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             /**< TELEMETRY_MAGIC */
+    uint32_t device;            /**< Identyfikator urządzenia (ETH_DeviceId) */
+    uint32_t seq;               /**< Numer kolejny datagramu */
+    uint8_t mode;               /**< Tryb toru pomiarowego (HEALTH_Mode) */
+    uint8_t reserved[3];
+    SCOPE_Sample sample;        /**< Próbka taktu regulatora */
+} TELEMETRY_Frame;
+
 /**
  * @brief Skaluje temperaturę (0-25°C) do wartości Pulse (0-144000).
  *
@@ -74,15 +97,25 @@ void set_PWM(TIM_HandleTypeDef *htim, uint32_t channel, int value);
 void send_via_uart(double set, double measure, UART_HandleTypeDef *huart);
 
 /**
- * @brief Odbiera dane przez UART.
+ * @brief Wysyła dane przez wirtualny port USB.
+ *
+ * Funkcja wysyła tę samą linię co send_via_uart, o ile host otworzył port USB.
+ * Dane są tylko umieszczane w buforze nadawczym - funkcja nie czeka na transmisję.
+ *
+ * @param set Temperatura ustawiona przez użytkownika.
+ * @param measure Zmierzona temperatura.
+ */
+void send_via_usb(double set, double measure);
+
+/**
+ * @brief Wysyła próbkę taktu regulatora jako datagram multicast.
  *
- * Funkcja ta odbiera dane z interfejsu UART, które zawierają ustawioną temperaturę
- * i zapisuje je w odpowiednich zmiennych.
+ * Datagram (TELEMETRY_Frame) trafia do grupy TELEMETRY_GROUP:TELEMETRY_PORT. Przy braku
+ * łącza lub wolnego bufora próbka jest pomijana.
  *
- * @param huart Wskaźnik na strukturę UART, z której będą odbierane dane.
- * @param set Wskaźnik na zmienną, w której będzie zapisana odbierana temperatura.
- * @param bufor1 Bufor do przechowywania danych odbieranych przez UART.
+ * @param sample Próbka taktu regulatora.
+ * @param mode Tryb toru pomiarowego.
  */
-void recieve_via_uart(UART_HandleTypeDef *huart, double *set, uint8_t *bufor1);
+void send_via_eth(const SCOPE_Sample *sample, uint8_t mode);
 
 #endif /* INC_OBSLUGA_H_ */
@@ -33,6 +33,10 @@ typedef struct {
     double integral_max;        /**< Maksymalna wartość integratora (anty wind-up) */
     double output_min;          /**< Minimalna wartość wyjściowa */
     double output_max;          /**< Maksymalna wartość wyjściowa */
+
+    double p_term;              /**< Składowa proporcjonalna z ostatniego obliczenia */
+    double i_term;              /**< Składowa całkująca z ostatniego obliczenia */
+    double d_term;              /**< Składowa różniczkująca z ostatniego obliczenia */
 } PID;
 
 /**
@@ -68,6 +72,19 @@ void PID_Init(PID *pid, double Kp, double Ki, double Kd, double setpoint,
  */
 double PID_Compute(PID *pid, double input);
 
+/**
+ * @brief Oblicza wyjście PID dla estymaty wejścia i jej pochodnej.
+ *
+ * Działa jak PID_Compute, lecz składowa różniczkująca korzysta z podanej szybkości zmian
+ * (np. z estymatora stanu) zamiast z różnicy dwóch zaszumionych próbek.
+ *
+ * @param pid Wskaźnik do struktury PID.
+ * @param input Estymata wartości wejściowej.
+ * @param rate Estymata szybkości zmian wejścia na sekundę.
+ * @return Wyjście algorytmu PID z uwzględnieniem opóźnienia transportowego i systemu anty wind-up.
+ */
+double PID_ComputeWithRate(PID *pid, double input, double rate);
+
 /**
  * @brief Zmienia punkt zadany (setpoint) w algorytmie PID.
  *
@@ -0,0 +1,122 @@
+#ifndef INC_SAMPLING_POLICY_H_
+#define INC_SAMPLING_POLICY_H_
+
+#include "stm32f7xx_hal.h"
+#include <stddef.h>
+
+/**
+ * @file sampling_policy.h
+ * @brief Dobór nadpróbkowania i filtru IIR czujników BMP2 do stanu regulacji.
+ *
+ * Przy dużym uchybie lub szybkiej zmianie temperatury czujniki pracują z najkrótszą konwersją
+ * i bez filtru (małe opóźnienie pomiaru), a w stanie ustalonym z najwyższym nadpróbkowaniem
+ * i silnym filtrem (mały szum). Przejście do poziomu o mniejszym opóźnieniu następuje od razu
+ * po przekroczeniu progu, a powrót do poziomu cichszego dopiero po SAMPLING_CALM_TICKS taktach
+ * z uchybem i szybkością poniżej węższych progów (histereza). Zmiany ustawień są rozdzielone
+ * co najmniej SAMPLING_MIN_INTERVAL taktami, co ogranicza koszt rekonfiguracji czujników.
+ *
+ * Moduł tylko wyznacza poziom - ustawienia czujników zmienia aplikacja (w pętli głównej,
+ * ponieważ rekonfiguracja używa blokującej transmisji SPI) i potwierdza to SAMPLING_Applied.
+ */
+
+#define SAMPLING_MIN_INTERVAL    8u     /**< Minimalny odstęp między zmianami ustawień [takty] */
+#define SAMPLING_CALM_TICKS     24u     /**< Czas spokoju wymagany do przejścia na cichszy poziom [takty] */
+#define SAMPLING_RECONFIG_BUDGET_US 12000u  /**< Czas zarezerwowany na rekonfigurację czujników [us] */
+
+/**
+ * @brief Poziom ustawień czujników.
+ */
+typedef enum {
+    SAMPLING_LEVEL_FAST = 0,    /**< Nadpróbkowanie 1x, filtr wyłączony */
+    SAMPLING_LEVEL_BALANCED,    /**< Rozdzielczość standardowa, filtr 2 */
+    SAMPLING_LEVEL_QUIET,       /**< Najwyższa rozdzielczość, filtr 8 */
+    SAMPLING_LEVELS
+} SAMPLING_Level;
+
+/**
+ * @brief Ustawienia czujnika i progi przypisane do poziomu.
+ */
+typedef struct {
+    uint8_t os_mode;            /**< BMP2_OS_MODE_... */
+    uint8_t filter;             /**< BMP2_FILTER_... */
+    float error_stay;           /**< Uchyb, powyżej którego poziom jest opuszczany [°C] */
+    float rate_stay;            /**< Szybkość, powyżej której poziom jest opuszczany [°C/s] */
+    float error_enter;          /**< Uchyb, poniżej którego można wejść na poziom [°C] */
+    float rate_enter;           /**< Szybkość, poniżej której można wejść na poziom [°C/s] */
+} SAMPLING_Setting;
+
+/**
+ * @brief Stan polityki próbkowania.
+ */
+typedef struct {
+    SAMPLING_Level level;       /**< Poziom ustawiony w czujnikach */
+    SAMPLING_Level target;      /**< Poziom wymagany przez stan regulacji */
+    int8_t pinned;              /**< Poziom wymuszony poleceniem, -1 - wybór automatyczny */
+    uint16_t calm_ticks;        /**< Kolejne takty spełniające progi wejścia na cichszy poziom */
+    uint16_t since_change;      /**< Takty od ostatniej zmiany ustawień */
+
+    uint32_t changes;           /**< Wykonane rekonfiguracje */
+    uint32_t deferred;          /**< Rekonfiguracje odłożone z braku czasu w takcie */
+    uint32_t failures;          /**< Rekonfiguracje zakończone błędem */
+    uint32_t last_us;           /**< Czas ostatniej rekonfiguracji [us] */
+    uint32_t max_us;            /**< Najdłuższa rekonfiguracja [us] */
+} SAMPLING_POLICY;
+
+extern SAMPLING_POLICY sampling_policy;
+extern const SAMPLING_Setting sampling_settings[SAMPLING_LEVELS];
+
+/**
+ * @brief Inicjalizuje politykę.
+ *
+ * @param p Wskaźnik do struktury polityki.
+ * @param level Poziom ustawiony w czujnikach przy inicjalizacji.
+ */
+void SAMPLING_Init(SAMPLING_POLICY *p, SAMPLING_Level level);
+
+/**
+ * @brief Aktualizuje poziom wymagany przez stan regulacji. Wywoływać raz na takt.
+ *
+ * @param p Wskaźnik do struktury polityki.
+ * @param error Uchyb regulacji [°C].
+ * @param rate Szybkość zmian temperatury [°C/s].
+ * @return 1, jeżeli ustawienia czujników należy zmienić na p->target, 0 w przeciwnym wypadku.
+ */
+uint8_t SAMPLING_Update(SAMPLING_POLICY *p, float error, float rate);
+
+/**
+ * @brief Zapisuje wynik rekonfiguracji czujników.
+ *
+ * @param p Wskaźnik do struktury polityki.
+ * @param ok Czy czujniki przyjęły ustawienia poziomu p->target.
+ * @param duration_us Czas rekonfiguracji [us].
+ */
+void SAMPLING_Applied(SAMPLING_POLICY *p, uint8_t ok, uint32_t duration_us);
+
+/**
+ * @brief Zlicza rekonfigurację odłożoną do następnego taktu.
+ *
+ * @param p Wskaźnik do struktury polityki.
+ */
+void SAMPLING_Deferred(SAMPLING_POLICY *p);
+
+/**
+ * @brief Wymusza poziom lub przywraca wybór automatyczny.
+ *
+ * @param p Wskaźnik do struktury polityki.
+ * @param level Poziom (0..SAMPLING_LEVELS-1) lub -1 dla wyboru automatycznego.
+ */
+void SAMPLING_Pin(SAMPLING_POLICY *p, int8_t level);
+
+/**
+ * @brief Zapisuje stan polityki w postaci jednej linii tekstu.
+ *
+ * Format: "P<poziom> <wymagany> <wymuszony> <zmiany> <odłożone> <błędy> <ostatni_us> <max_us>\n".
+ *
+ * @param p Wskaźnik do struktury polityki.
+ * @param line Bufor na linię.
+ * @param size Rozmiar bufora.
+ * @return Długość linii (bez znaku końca napisu).
+ */
+int SAMPLING_Format(const SAMPLING_POLICY *p, char *line, size_t size);
+
+#endif /* INC_SAMPLING_POLICY_H_ */
@@ -0,0 +1,130 @@
+#ifndef INC_SCOPE_H_
+#define INC_SCOPE_H_
+
+#include "stm32f7xx_hal.h"
+#include "pid.h"
+
+/**
+ * @file scope.h
+ * @brief Rejestrator próbek pętli regulacji (tryb oscyloskopu).
+ *
+ * Moduł zapisuje w każdym takcie regulatora jedną próbkę (pomiar, wartość zadana,
+ * składowe P/I/D, wypełnienie PWM, czas obsługi przerwania w cyklach) do statycznego
+ * bufora pierścieniowego w SRAM. Po uzbrojeniu i wyzwoleniu bufor zawiera zadaną liczbę
+ * próbek sprzed i po zdarzeniu, które są następnie wysyłane hurtowo przez UART.
+ */
+
+/** Pojemność bufora w próbkach (stała, bufor alokowany statycznie) */
+#define SCOPE_BUFFER_LEN   1024u
+/** Liczba próbek wysyłanych w jednym wywołaniu SCOPE_DumpChunk */
+#define SCOPE_DUMP_CHUNK   4u
+
+/**
+ * @brief Funkcja wysyłająca dane; zwraca HAL_OK, jeżeli dane zostały przyjęte do wysłania.
+ */
+typedef HAL_StatusTypeDef (*SCOPE_WriteFn)(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Pojedyncza próbka rejestrowana w takcie regulatora.
+ */
+typedef struct {
+    uint32_t tick;              /**< Numer taktu regulatora */
+    float measurement;          /**< Zmierzona temperatura [°C] */
+    float setpoint;             /**< Temperatura zadana [°C] */
+    float p_term;               /**< Składowa proporcjonalna */
+    float i_term;               /**< Składowa całkująca */
+    float d_term;               /**< Składowa różniczkująca */
+    float output;               /**< Wyjście regulatora (po saturacji) */
+    uint32_t duty;              /**< Wypełnienie PWM (wartość rejestru CCR) */
+    uint32_t isr_cycles;        /**< Czas obsługi taktu w cyklach rdzenia */
+} SCOPE_Sample;
+
+/**
+ * @brief Warunek wyzwolenia rejestracji.
+ */
+typedef enum {
+    SCOPE_TRIG_MANUAL   = 0,    /**< Wyzwolenie tylko poleceniem SCOPE_Trigger */
+    SCOPE_TRIG_RISING   = 1,    /**< Pomiar przekracza poziom rosnąco */
+    SCOPE_TRIG_FALLING  = 2,    /**< Pomiar przekracza poziom malejąco */
+    SCOPE_TRIG_SETPOINT = 3     /**< Zmiana temperatury zadanej */
+} SCOPE_TriggerMode;
+
+/**
+ * @brief Stan rejestratora.
+ */
+typedef enum {
+    SCOPE_IDLE = 0,             /**< Rejestracja wyłączona */
+    SCOPE_ARMED,                /**< Zapis historii, oczekiwanie na wyzwolenie */
+    SCOPE_TRIGGERED,            /**< Zapis próbek po wyzwoleniu */
+    SCOPE_DONE                  /**< Bufor kompletny, oczekuje na wysłanie */
+} SCOPE_State;
+
+/**
+ * @brief Inicjalizuje rejestrator.
+ *
+ * Czas obsługi taktu mierzony jest licznikiem cykli DWT uruchamianym przez UTIMER_Init.
+ */
+void SCOPE_Init(void);
+
+/**
+ * @brief Uzbraja rejestrator.
+ *
+ * @param pre Liczba próbek sprzed wyzwolenia.
+ * @param post Liczba próbek po wyzwoleniu (łącznie z próbką wyzwalającą).
+ * @param mode Warunek wyzwolenia.
+ * @param level Poziom temperatury dla wyzwolenia zboczem [°C].
+ * @return HAL_OK lub HAL_ERROR, gdy pre + post przekracza SCOPE_BUFFER_LEN albo post == 0.
+ */
+HAL_StatusTypeDef SCOPE_Arm(uint32_t pre, uint32_t post, SCOPE_TriggerMode mode, float level);
+
+/**
+ * @brief Wymusza wyzwolenie uzbrojonego rejestratora (wykonywane w najbliższym takcie).
+ */
+void SCOPE_Trigger(void);
+
+/**
+ * @brief Przerywa rejestrację lub wysyłanie i wraca do stanu SCOPE_IDLE.
+ */
+void SCOPE_Abort(void);
+
+/**
+ * @brief Zapisuje próbkę bieżącego taktu. Wywoływana z przerwania regulatora.
+ *
+ * @param pid Wskaźnik do struktury PID (źródło składowych P/I/D i wartości zadanej).
+ * @param measurement Zmierzona temperatura.
+ * @param output Wyjście regulatora.
+ * @param duty Wypełnienie PWM.
+ * @param isr_cycles Czas obsługi taktu w cyklach rdzenia.
+ */
+void SCOPE_Record(const PID *pid, double measurement, double output, int duty, uint32_t isr_cycles);
+
+/**
+ * @brief Kopiuje próbkę ostatniego taktu regulatora (zapisywaną niezależnie od stanu rejestratora).
+ *
+ * Przeznaczona do wywoływania w pętli głównej, np. do wysyłania telemetrii w każdym takcie.
+ *
+ * @param sample Miejsce na kopię próbki.
+ * @return Numer taktu próbki (0 - brak próbek).
+ */
+uint32_t SCOPE_GetLast(SCOPE_Sample *sample);
+
+/**
+ * @brief Zwraca bieżący stan rejestratora.
+ */
+SCOPE_State SCOPE_GetState(void);
+
+/**
+ * @brief Wysyła kolejną porcję zarejestrowanych danych.
+ *
+ * Przy pierwszym wywołaniu po zakończeniu rejestracji wysyłany jest nagłówek tekstowy
+ * "SCOPE <liczba próbek> <rozmiar próbki> <próbki przed wyzwoleniem>\n", a następnie
+ * w kolejnych wywołaniach próbki binarnie (little-endian) po SCOPE_DUMP_CHUNK sztuk.
+ * Funkcja przeznaczona do wywoływania w pętli głównej. Porcja nieprzyjęta przez funkcję
+ * wysyłającą (np. pełny bufor USB) jest ponawiana przy następnym wywołaniu.
+ *
+ * @param write Funkcja wysyłająca dane.
+ * @return 1, jeżeli pozostały dane do wysłania, 0 w przeciwnym wypadku.
+ */
+uint8_t SCOPE_DumpChunk(SCOPE_WriteFn write);
+
+#endif /* INC_SCOPE_H_ */
@@ -0,0 +1,107 @@
+#ifndef INC_SENSOR_HEALTH_H_
+#define INC_SENSOR_HEALTH_H_
+
+#include "stm32f7xx_hal.h"
+#include "bmp2_array.h"
+
+/**
+ * @file sensor_health.h
+ * @brief Nadzór poprawności pomiarów temperatury i przełączanie awaryjne.
+ *
+ * W każdym takcie regulatora sprawdzane są wszystkie czujniki: błąd magistrali SPI,
+ * zakres wartości, szybkość zmian oraz "zawieszenie" (identyczna wartość przez wiele taktów).
+ * Czujnik z błędem jest wyłączany z fuzji do czasu uzyskania serii poprawnych próbek.
+ * Gdy nie ma żadnego sprawnego czujnika, regulator przez ograniczony czas pracuje na
+ * predykcji estymatora, a następnie grzałka jest przełączana na bezpieczne wypełnienie.
+ * Wszystkie kontrole mają stały koszt - nie są wykonywane żadne ponowienia odczytu.
+ */
+
+/** Flagi błędów czujnika */
+#define HEALTH_FAULT_SPI      0x01u   /**< Błąd transmisji lub nieprawidłowe dane surowe */
+#define HEALTH_FAULT_RANGE    0x02u   /**< Temperatura poza zakresem */
+#define HEALTH_FAULT_RATE     0x04u   /**< Zbyt szybka zmiana temperatury */
+#define HEALTH_FAULT_STUCK    0x08u   /**< Wartość niezmienna przez zbyt wiele taktów */
+#define HEALTH_FAULT_TIMEOUT  0x10u   /**< Sekwencja odczytu nie zakończyła się w jednym takcie */
+#define HEALTH_FAULT_TYPES    5u
+
+/** Domyślne parametry nadzoru */
+#define HEALTH_TEMP_MIN         -20.0   /**< Minimalna akceptowana temperatura [°C] */
+#define HEALTH_TEMP_MAX          85.0   /**< Maksymalna akceptowana temperatura [°C] */
+#define HEALTH_MAX_RATE           5.0   /**< Maksymalna szybkość zmian [°C/s] */
+#define HEALTH_STUCK_TICKS      240u    /**< Liczba identycznych próbek uznawana za zawieszenie */
+#define HEALTH_RECOVER_TICKS      8u    /**< Liczba poprawnych próbek do przywrócenia czujnika */
+#define HEALTH_HOLDOVER_TICKS    16u    /**< Maksymalny czas pracy na predykcji estymatora [takty] */
+#define HEALTH_SAFE_OUTPUT        0.0   /**< Wyjście regulatora w trybie bezpiecznym */
+
+/**
+ * @brief Tryb pracy toru pomiarowego.
+ */
+typedef enum {
+    HEALTH_MODE_OK = 0,         /**< Wszystkie aktywne czujniki sprawne */
+    HEALTH_MODE_DEGRADED,       /**< Część czujników wyłączona, pomiar z pozostałych */
+    HEALTH_MODE_HOLDOVER,       /**< Brak sprawnych czujników, praca na predykcji estymatora */
+    HEALTH_MODE_SAFE            /**< Brak pomiaru dłużej niż HEALTH_HOLDOVER_TICKS - wyjście bezpieczne */
+} HEALTH_Mode;
+
+/**
+ * @brief Stan nadzoru pojedynczego czujnika.
+ */
+typedef struct {
+    double last_temp;           /**< Ostatnia odczytana temperatura */
+    uint8_t has_last;           /**< Czy last_temp jest ważna */
+    uint8_t faults;             /**< Flagi błędów z ostatniego taktu */
+    uint8_t excluded;           /**< Czy czujnik jest wyłączony z fuzji */
+    uint16_t stuck_ticks;       /**< Licznik identycznych próbek */
+    uint16_t good_ticks;        /**< Licznik kolejnych poprawnych próbek */
+} HEALTH_Sensor;
+
+/**
+ * @brief Stan nadzoru toru pomiarowego.
+ */
+typedef struct {
+    HEALTH_Sensor sensor[BMP2_NUM_OF_SENSORS];
+    double dt;                  /**< Okres próbkowania [s] */
+    HEALTH_Mode mode;           /**< Bieżący tryb pracy */
+    uint16_t holdover_ticks;    /**< Czas bez sprawnego czujnika [takty] */
+    uint32_t last_timeouts;     /**< Ostatnio widziana wartość licznika przekroczeń czasu */
+
+    uint32_t fault_events[HEALTH_FAULT_TYPES]; /**< Liczniki zdarzeń błędów wg typu */
+    uint32_t failover_events;   /**< Liczba przejść do trybu DEGRADED */
+    uint32_t holdover_events;   /**< Liczba przejść do trybu HOLDOVER */
+    uint32_t safe_events;       /**< Liczba przejść do trybu SAFE */
+} SENSOR_HEALTH;
+
+extern SENSOR_HEALTH sensor_health;
+
+/**
+ * @brief Inicjalizuje nadzór toru pomiarowego.
+ *
+ * @param h Wskaźnik do struktury nadzoru.
+ * @param dt Okres próbkowania w sekundach.
+ */
+void HEALTH_Init(SENSOR_HEALTH *h, double dt);
+
+/**
+ * @brief Ocenia wyniki ostatniej sekwencji odczytu i wyznacza pomiar dla regulatora.
+ *
+ * @param h Wskaźnik do struktury nadzoru.
+ * @param arr Wskaźnik do zestawu czujników po zakończonej sekwencji.
+ * @param measurement Wskaźnik na zmienną, w której zostanie zapisany pomiar
+ *        (tylko w trybach HEALTH_MODE_OK i HEALTH_MODE_DEGRADED).
+ * @return Tryb pracy toru pomiarowego w bieżącym takcie.
+ */
+HEALTH_Mode HEALTH_Evaluate(SENSOR_HEALTH *h, BMP2_ArrayTypeDef *arr, double *measurement);
+
+/**
+ * @brief Zapisuje liczniki zdarzeń w postaci jednej linii tekstu.
+ *
+ * Format: "H<tryb> <spi> <zakres> <szybkość> <zawieszenie> <timeout> <failover> <holdover> <safe>\n".
+ *
+ * @param h Wskaźnik do struktury nadzoru.
+ * @param line Bufor na linię.
+ * @param size Rozmiar bufora.
+ * @return Długość linii (bez znaku końca napisu).
+ */
+int HEALTH_Format(const SENSOR_HEALTH *h, char *line, size_t size);
+
+#endif /* INC_SENSOR_HEALTH_H_ */
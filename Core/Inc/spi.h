@@ -35,6 +35,8 @@ extern "C" {
 extern SPI_HandleTypeDef hspi4;
 
 /* USER CODE BEGIN Private defines */
+extern DMA_HandleTypeDef hdma_spi4_rx;
+extern DMA_HandleTypeDef hdma_spi4_tx;
 
 /* USER CODE END Private defines */
 
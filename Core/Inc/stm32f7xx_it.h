@@ -58,6 +58,10 @@ void SysTick_Handler(void);
 void TIM2_IRQHandler(void);
 void USART3_IRQHandler(void);
 /* USER CODE BEGIN EFP */
+void DMA2_Stream0_IRQHandler(void);
+void DMA2_Stream1_IRQHandler(void);
+void OTG_FS_IRQHandler(void);
+void ETH_IRQHandler(void);
 
 /* USER CODE END EFP */
 
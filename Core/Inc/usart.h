@@ -35,12 +35,16 @@ extern "C" {
 extern UART_HandleTypeDef huart3;
 
 /* USER CODE BEGIN Private defines */
+/* Maksymalny względny błąd prędkości transmisji po podziale zegara [%] */
+#define USART_BAUD_MAX_ERROR_PCT 2u
 
 /* USER CODE END Private defines */
 
 void MX_USART3_UART_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+HAL_StatusTypeDef USART_CheckBaudRate(const UART_HandleTypeDef *huart, uint32_t baud);
+HAL_StatusTypeDef USART_ChangeBaudRate(UART_HandleTypeDef *huart, uint32_t baud);
 
 /* USER CODE END Prototypes */
 
@@ -0,0 +1,56 @@
+#ifndef INC_USB_CDC_H_
+#define INC_USB_CDC_H_
+
+#include "stm32f7xx_hal.h"
+
+/**
+ * @file usb_cdc.h
+ * @brief Wirtualny port szeregowy USB (klasa CDC-ACM) na sterowniku HAL PCD.
+ *
+ * Minimalna implementacja urządzenia USB: obsługa żądań standardowych na EP0, deskryptory
+ * CDC-ACM oraz kanał danych na punktach końcowych bulk 0x01 (OUT) i 0x81 (IN). Kontroler
+ * OTG_FS nie ma sprzętowego podwójnego buforowania dla bulk, więc jest ono realizowane
+ * programowo: jeden bufor nadawczy jest wysyłany, podczas gdy drugi jest zapełniany,
+ * a odbiór jest wznawiany do drugiego bufora przed przetworzeniem odebranego pakietu.
+ */
+
+#define CDC_PACKET_SIZE     64u     /**< Rozmiar pakietu bulk (Full Speed) */
+#define CDC_CMD_PACKET_SIZE 8u      /**< Rozmiar pakietu punktu przerwaniowego */
+#define CDC_TX_BUFFER_LEN   1024u   /**< Rozmiar każdego z dwóch buforów nadawczych */
+
+#define CDC_DATA_OUT_EP     0x01u
+#define CDC_DATA_IN_EP      0x81u
+#define CDC_CMD_EP          0x82u
+
+/**
+ * @brief Uruchamia urządzenie USB (podział FIFO, start PCD).
+ *
+ * @param hpcd Wskaźnik do zainicjalizowanej struktury PCD (MX_USB_OTG_FS_PCD_Init).
+ */
+void CDC_Init(PCD_HandleTypeDef *hpcd);
+
+/**
+ * @brief Czy host skonfigurował urządzenie i otworzył port (sygnał DTR).
+ */
+uint8_t CDC_IsConnected(void);
+
+/**
+ * @brief Umieszcza dane w buforze nadawczym; nie czeka na zakończenie transmisji.
+ *
+ * @param data Dane do wysłania.
+ * @param len Liczba bajtów (co najwyżej CDC_TX_BUFFER_LEN).
+ * @return HAL_OK, HAL_BUSY gdy bufor jest pełny (dane nie zostały przyjęte)
+ *         lub HAL_ERROR gdy port nie jest otwarty.
+ */
+HAL_StatusTypeDef CDC_Transmit(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Wywoływana z przerwania USB po odebraniu pakietu danych.
+ * @note Funkcja słaba, do nadpisania przez aplikację.
+ *
+ * @param data Odebrane dane (ważne tylko w trakcie wywołania).
+ * @param len Liczba odebranych bajtów.
+ */
+void CDC_ReceiveCallback(const uint8_t *data, uint32_t len);
+
+#endif /* INC_USB_CDC_H_ */
@@ -0,0 +1,123 @@
+#ifndef INC_UTIMER_H_
+#define INC_UTIMER_H_
+
+#include "stm32f7xx_hal.h"
+
+/**
+ * @file utimer.h
+ * @brief Mikrosekundowe opóźnienia, terminy i jednorazowe wywołania zwrotne.
+ *
+ * Czas mierzony jest licznikiem cykli rdzenia DWT->CYCCNT, więc opóźnienia i terminy
+ * mają rozdzielczość pojedynczych cykli i nie zależą od SysTick ani priorytetów przerwań.
+ * Licznik przepełnia się co 2^32 cykli (ok. 59 s przy 72 MHz), dlatego pojedynczy termin
+ * jest ograniczony do UTIMER_MAX_CYCLES; dłuższe opóźnienia są dzielone na części.
+ *
+ * Jednorazowe wywołania zwrotne odmierzane są kanałem porównania licznika taktującego
+ * mikrosekundami (TIM2 kanał 2, licznik zerowany co takt regulatora) - przerwanie
+ * zgłaszane jest tylko przy najbliższym terminie. Wywołania wykonywane są w przerwaniu
+ * tego licznika i działają po jego uruchomieniu.
+ */
+
+#define UTIMER_SLOTS        4u              /**< Liczba jednoczesnych wywołań jednorazowych */
+#define UTIMER_MAX_CYCLES   0x7FFFFFFFu     /**< Najdłuższy pojedynczy termin [cykle] */
+#define UTIMER_MIN_LEAD_US  3u              /**< Najkrótszy czas do przerwania porównania [us] */
+
+/**
+ * @brief Funkcja wywoływana po upływie czasu (w przerwaniu).
+ */
+typedef void (*UTIMER_Callback)(void *ctx);
+
+/**
+ * @brief Termin odmierzany licznikiem cykli.
+ */
+typedef struct {
+    uint32_t start;             /**< Stan licznika cykli przy ustawieniu terminu */
+    uint32_t cycles;            /**< Czas do terminu [cykle] */
+} UTIMER_Deadline;
+
+/**
+ * @brief Uruchamia licznik cykli i przypisuje kanał porównania do wywołań jednorazowych.
+ *
+ * Licznik htim musi zliczać mikrosekundy. Wywołać przed pierwszym użyciem opóźnień przez
+ * sterowniki (opóźnienia działają także wcześniej - licznik cykli jest wtedy uruchamiany).
+ *
+ * @param htim Licznik taktujący mikrosekundami.
+ * @param channel Kanał porównania (TIM_CHANNEL_x) skonfigurowany w trybie TIM_OCMODE_TIMING.
+ */
+void UTIMER_Init(TIM_HandleTypeDef *htim, uint32_t channel);
+
+/**
+ * @brief Zwraca stan licznika cykli rdzenia.
+ */
+uint32_t UTIMER_Cycles(void);
+
+/**
+ * @brief Przelicza cykle rdzenia na mikrosekundy.
+ */
+uint32_t UTIMER_CyclesToUs(uint32_t cycles);
+
+/**
+ * @brief Czeka aktywnie podaną liczbę mikrosekund.
+ *
+ * @param us Czas oczekiwania [us].
+ */
+void UTIMER_DelayUs(uint32_t us);
+
+/**
+ * @brief Ustawia termin za podaną liczbę mikrosekund (ograniczoną do UTIMER_MAX_CYCLES).
+ *
+ * @param d Termin.
+ * @param us Czas do terminu [us].
+ */
+void UTIMER_DeadlineSet(UTIMER_Deadline *d, uint32_t us);
+
+/**
+ * @brief Sprawdza, czy termin minął.
+ *
+ * @param d Termin.
+ * @return 1, jeżeli termin minął, 0 w przeciwnym wypadku.
+ */
+uint8_t UTIMER_DeadlineExpired(const UTIMER_Deadline *d);
+
+/**
+ * @brief Zwraca czas pozostały do terminu.
+ *
+ * @param d Termin.
+ * @return Czas do terminu [us], 0 jeżeli termin minął.
+ */
+uint32_t UTIMER_DeadlineRemainingUs(const UTIMER_Deadline *d);
+
+/**
+ * @brief Planuje jednorazowe wywołanie funkcji po podanym czasie.
+ *
+ * Można wywoływać z przerwania, także z wywołania zwrotnego (ponowne zaplanowanie).
+ *
+ * @param us Czas do wywołania [us] (ograniczony do UTIMER_MAX_CYCLES).
+ * @param callback Funkcja wywoływana w przerwaniu licznika.
+ * @param ctx Argument funkcji.
+ * @return Numer wywołania (do UTIMER_Cancel) lub -1, gdy brak wolnego miejsca.
+ */
+int8_t UTIMER_Start(uint32_t us, UTIMER_Callback callback, void *ctx);
+
+/**
+ * @brief Odwołuje zaplanowane wywołanie. Wywołanie już wykonane jest ignorowane.
+ *
+ * @param id Numer zwrócony przez UTIMER_Start.
+ */
+void UTIMER_Cancel(int8_t id);
+
+/**
+ * @brief Zwraca czas do najbliższego zaplanowanego wywołania.
+ *
+ * @return Czas [us] lub UINT32_MAX, gdy nic nie jest zaplanowane.
+ */
+uint32_t UTIMER_NextExpiryUs(void);
+
+/**
+ * @brief Obsługa przerwania porównania. Wywoływać z HAL_TIM_OC_DelayElapsedCallback.
+ *
+ * @param htim Licznik, który zgłosił przerwanie (inne kanały i liczniki są ignorowane).
+ */
+void UTIMER_CompareCallback(TIM_HandleTypeDef *htim);
+
+#endif /* INC_UTIMER_H_ */
@@ -0,0 +1,372 @@
+#include "autotune.h"
+#include <math.h>
+#include <stdio.h>
+
+/**
+ * @file autotune.c
+ * @brief Implementacja automatycznego doboru nastaw PID metodą przekaźnikową.
+ *
+ * Cykl liczony jest od przełączenia przekaźnika na grzanie do następnego takiego przełączenia.
+ * Pierwszy pełny cykl służy tylko jako punkt odniesienia (obiekt wychodzi ze stanu sprzed
+ * strojenia); kolejne porównywane są ze średnimi poprzednich.
+ */
+
+AUTOTUNE autotune;
+
+/** Współczynniki reguł: Kp/Ku, Ti/Tu, Td/Tu (Ti = 0 - bez całkowania) */
+static const double autotune_rules[AUTOTUNE_RULES][3] = {
+    [AUTOTUNE_RULE_ZN_PID]          = {0.6,       0.5, 0.125},
+    [AUTOTUNE_RULE_TYREUS_LUYBEN]   = {1.0 / 2.2, 2.2, 1.0 / 6.3},
+    [AUTOTUNE_RULE_NO_OVERSHOOT]    = {0.2,       0.5, 1.0 / 3.0},
+    [AUTOTUNE_RULE_ZN_PI]           = {0.45, 1.0 / 1.2, 0.0},
+};
+
+/**
+ * @brief Ustawia nastawy regulatora; granice integratora obejmują cały zakres wyjścia.
+ */
+static void autotune_set_gains(PID *pid, double Kp, double Ki, double Kd,
+                               double integral_min, double integral_max)
+{
+    pid->Kp = Kp;
+    pid->Ki = Ki;
+    pid->Kd = Kd;
+    pid->integral_min = integral_min;
+    pid->integral_max = integral_max;
+}
+
+/**
+ * @brief Przekazuje sterowanie do PID bez skoku wyjścia i wykonuje jego pierwszy krok.
+ *
+ * @param output Wyjście, od którego PID ma kontynuować.
+ */
+static double autotune_handover(AUTOTUNE *at, double input, double rate, double output)
+{
+    PID *pid = at->pid;
+    double error = pid->setpoint - input;
+
+    // Integrator tak, aby Kp*e + Ki*(I + e) + Kd*v*Ts = output w pierwszym kroku PID
+    if (pid->Ki != 0.0) {
+        pid->integral = (output - pid->Kp * error - pid->Kd * rate * pid->sampling_time) / pid->Ki - error;
+        if (pid->integral > pid->integral_max) {
+            pid->integral = pid->integral_max;
+        } else if (pid->integral < pid->integral_min) {
+            pid->integral = pid->integral_min;
+        }
+    }
+    pid->prev_input = input;
+    pid->prev_output = output;
+    // Obliczenie już w tym takcie
+    pid->sample_count = pid->delay_samples;
+
+    return PID_ComputeWithRate(pid, input, rate);
+}
+
+/**
+ * @brief Przywraca nastawy sprzed strojenia.
+ */
+static void autotune_restore(AUTOTUNE *at, AUTOTUNE_Error error)
+{
+    autotune_set_gains(at->pid, at->saved_Kp, at->saved_Ki, at->saved_Kd,
+                       at->saved_integral_min, at->saved_integral_max);
+    at->error = error;
+    at->state = AUTOTUNE_FAILED;
+}
+
+/**
+ * @brief Wyznacza nastawy z Ku i Tu według wybranej reguły.
+ *
+ * @return 1, jeżeli nastawy są poprawne.
+ */
+static uint8_t autotune_compute_gains(AUTOTUNE *at)
+{
+    const double *rule = autotune_rules[at->rule];
+    PID *pid = at->pid;
+    double calc_period = (pid->delay_samples + 1u) * pid->sampling_time;
+    double Kp, Ti, Td;
+
+    if (at->amp <= AUTOTUNE_HYSTERESIS) {
+        return 0;
+    }
+    at->Ku = 4.0 * at->relay_amp / (M_PI * sqrt(at->amp * at->amp - AUTOTUNE_HYSTERESIS * AUTOTUNE_HYSTERESIS));
+
+    Kp = rule[0] * at->Ku;
+    Ti = rule[1] * at->period;
+    Td = rule[2] * at->period;
+
+    // Postać pid.c: suma uchybu co calc_period, pochodna = zmiana temperatury w takcie
+    at->Kp = Kp;
+    at->Ki = Kp * calc_period / Ti;
+    at->Kd = -Kp * Td / pid->sampling_time;
+    return 1;
+}
+
+/**
+ * @brief Kończy pełny cykl przekaźnika (przełączenie na grzanie).
+ */
+static void autotune_cycle_end(AUTOTUNE *at, double input)
+{
+    PID *pid = at->pid;
+    double period, amp, skew, room;
+
+    if (at->in_cycle && at->cycle_ticks > 0u) {
+        period = at->cycle_ticks * pid->sampling_time;
+        amp = 0.5 * (at->y_max - at->y_min);
+        at->output_avg = at->output_sum / at->cycle_ticks;
+        at->cycles++;
+
+        // d, które wywołało zmierzoną amplitudę - Ku nie może korzystać z d na następny cykl
+        if (at->cycles == 1u) {
+            at->period = period;
+            at->amp = amp;
+            at->relay_amp = at->amplitude;
+        }
+        else {
+            if (fabs(period - at->period) <= AUTOTUNE_TOLERANCE * at->period
+                && fabs(amp - at->amp) <= AUTOTUNE_TOLERANCE * at->amp) {
+                at->stable++;
+            }
+            else {
+                at->stable = 0;
+            }
+            at->period = 0.5 * (at->period + period);
+            at->amp = 0.5 * (at->amp + amp);
+            at->relay_amp = 0.5 * (at->relay_amp + at->amplitude);
+        }
+
+        // Nastawy z cykli już zmierzonych, przed zmianą przekaźnika na następny cykl
+        if (at->stable >= AUTOTUNE_STABLE_CYCLES && at->state == AUTOTUNE_RELAY) {
+            if (autotune_compute_gains(at)) {
+                at->state = AUTOTUNE_HANDOVER;
+            }
+            else {
+                at->error = AUTOTUNE_ERR_AMPLITUDE;
+            }
+        }
+
+        // Korekta biasu w stronę równych czasów grzania i chłodzenia
+        skew = ((double)at->high_ticks - (double)(at->cycle_ticks - at->high_ticks)) / at->cycle_ticks;
+        at->bias += 0.5 * at->amplitude * skew;
+        if (at->stable > 0u) {
+            // W trakcie liczenia zgodnych cykli d bez zmian - bias ograniczony tak, aby d się mieściło
+            at->bias = fmin(fmax(at->bias, pid->output_min + at->amplitude), pid->output_max - at->amplitude);
+        }
+        else {
+            room = fmin(at->bias - pid->output_min, pid->output_max - at->bias);
+            if (room < 0.0) {
+                at->bias = (at->bias < pid->output_min) ? pid->output_min : pid->output_max;
+                room = 0.0;
+            }
+            at->amplitude = fmin(AUTOTUNE_AMPLITUDE, fmax(room, 0.1 * AUTOTUNE_AMPLITUDE));
+        }
+    }
+
+    at->in_cycle = 1;
+    at->cycle_ticks = 0;
+    at->high_ticks = 0;
+    at->output_sum = 0.0;
+    at->y_max = input;
+    at->y_min = input;
+}
+
+/**
+ * @brief Inicjalizuje strojenie.
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ * @param pid Strojony regulator.
+ */
+void AUTOTUNE_Init(AUTOTUNE *at, PID *pid)
+{
+    at->pid = pid;
+    at->state = AUTOTUNE_IDLE;
+    at->abort_request = 0;
+    at->rule = AUTOTUNE_RULE_ZN_PID;
+    at->error = AUTOTUNE_ERR_NONE;
+    at->cycles = 0;
+    at->period = 0.0;
+    at->amp = 0.0;
+    at->Ku = 0.0;
+    at->Kp = pid->Kp;
+    at->Ki = pid->Ki;
+    at->Kd = pid->Kd;
+}
+
+/**
+ * @brief Uruchamia strojenie wokół bieżącej temperatury zadanej regulatora.
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ * @param rule Reguła doboru nastaw.
+ * @return 1, jeżeli strojenie zostało uruchomione, 0 gdy już trwa lub reguła jest nieznana.
+ */
+uint8_t AUTOTUNE_Start(AUTOTUNE *at, AUTOTUNE_Rule rule)
+{
+    PID *pid = at->pid;
+
+    if (AUTOTUNE_IsActive(at) || rule >= AUTOTUNE_RULES) {
+        return 0;
+    }
+
+    at->rule = rule;
+    at->error = AUTOTUNE_ERR_NONE;
+    at->abort_request = 0;
+    at->setpoint = pid->setpoint;
+    at->saved_Kp = pid->Kp;
+    at->saved_Ki = pid->Ki;
+    at->saved_Kd = pid->Kd;
+    at->saved_integral_min = pid->integral_min;
+    at->saved_integral_max = pid->integral_max;
+
+    at->started = 0;
+    at->in_cycle = 0;
+    at->ticks = 0;
+    at->phase_ticks = 0;
+    at->high_ticks = 0;
+    at->cycle_ticks = 0;
+    at->output_sum = 0.0;
+    at->cycles = 0;
+    at->stable = 0;
+    at->period = 0.0;
+    at->amp = 0.0;
+    at->relay_amp = 0.0;
+    at->Ku = 0.0;
+
+    // Stan ustawiany na końcu - przerwanie regulatora widzi kompletną konfigurację
+    at->state = AUTOTUNE_RELAY;
+    return 1;
+}
+
+/**
+ * @brief Zgłasza przerwanie strojenia (wykonywane w najbliższym AUTOTUNE_Update).
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ */
+void AUTOTUNE_Abort(AUTOTUNE *at)
+{
+    if (AUTOTUNE_IsActive(at)) {
+        at->abort_request = 1;
+    }
+}
+
+/**
+ * @brief Przerywa strojenie natychmiast, bez przekazania sterowania do PID.
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ * @param error Przyczyna.
+ */
+void AUTOTUNE_Cancel(AUTOTUNE *at, AUTOTUNE_Error error)
+{
+    if (AUTOTUNE_IsActive(at)) {
+        autotune_restore(at, error);
+    }
+}
+
+/**
+ * @brief Czy strojenie zastępuje regulator PID.
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ */
+uint8_t AUTOTUNE_IsActive(const AUTOTUNE *at)
+{
+    return at->state == AUTOTUNE_RELAY || at->state == AUTOTUNE_HANDOVER;
+}
+
+/**
+ * @brief Krok strojenia - wywoływać w takcie regulatora zamiast PID_ComputeWithRate.
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ * @param input Estymata temperatury [°C].
+ * @param rate Estymata szybkości zmian temperatury [°C/s].
+ * @return Wyjście regulatora.
+ */
+double AUTOTUNE_Update(AUTOTUNE *at, double input, double rate)
+{
+    PID *pid = at->pid;
+    double error = at->setpoint - input;
+    double output;
+    AUTOTUNE_Error fault = AUTOTUNE_ERR_NONE;
+
+    if (at->abort_request) {
+        fault = AUTOTUNE_ERR_ABORTED;
+    }
+    else if (fabs(pid->setpoint - at->setpoint) > AUTOTUNE_SETPOINT_TOLERANCE) {
+        fault = AUTOTUNE_ERR_SETPOINT;
+    }
+    else if (fabs(error) > AUTOTUNE_MAX_DEVIATION) {
+        fault = AUTOTUNE_ERR_DEVIATION;
+    }
+    else if (++at->ticks > AUTOTUNE_MAX_TICKS) {
+        fault = AUTOTUNE_ERR_TIMEOUT;
+    }
+    else if (at->error == AUTOTUNE_ERR_AMPLITUDE) {
+        fault = AUTOTUNE_ERR_AMPLITUDE;
+    }
+    if (fault != AUTOTUNE_ERR_NONE) {
+        at->abort_request = 0;
+        output = at->high ? at->bias + at->amplitude : at->bias - at->amplitude;
+        autotune_restore(at, fault);
+        return autotune_handover(at, input, rate, at->started ? output : pid->prev_output);
+    }
+
+    if (!at->started) {
+        // Środek przekaźnika z bieżącego wyjścia, z miejscem na amplitudę w zakresie wyjścia
+        // (w takcie regulatora - zakres może jeszcze zmieniać sprzężenie w przód)
+        at->amplitude = fmin(AUTOTUNE_AMPLITUDE, 0.5 * (pid->output_max - pid->output_min));
+        at->bias = fmin(fmax(pid->prev_output, pid->output_min + at->amplitude), pid->output_max - at->amplitude);
+        at->started = 1;
+        at->high = (error > 0.0);
+        at->prev_error = error;
+        at->y_max = input;
+        at->y_min = input;
+    }
+
+    // Przekaźnik z histerezą
+    if (at->high && input > at->setpoint + AUTOTUNE_HYSTERESIS) {
+        at->high = 0;
+        at->high_ticks = at->phase_ticks;
+        at->phase_ticks = 0;
+    }
+    else if (!at->high && input < at->setpoint - AUTOTUNE_HYSTERESIS) {
+        at->high = 1;
+        at->phase_ticks = 0;
+        autotune_cycle_end(at, input);
+    }
+
+    if (input > at->y_max) {
+        at->y_max = input;
+    }
+    if (input < at->y_min) {
+        at->y_min = input;
+    }
+
+    output = at->high ? at->bias + at->amplitude : at->bias - at->amplitude;
+    at->phase_ticks++;
+    at->cycle_ticks++;
+    at->output_sum += output;
+
+    // Nowe nastawy od przejścia temperatury przez zadaną (uchyb bliski zera)
+    if (at->state == AUTOTUNE_HANDOVER && at->prev_error * error <= 0.0) {
+        autotune_set_gains(pid, at->Kp, at->Ki, at->Kd,
+                           pid->output_min / at->Ki, pid->output_max / at->Ki);
+        at->state = AUTOTUNE_DONE;
+        return autotune_handover(at, input, rate, at->output_avg);
+    }
+    at->prev_error = error;
+
+    return output;
+}
+
+/**
+ * @brief Zapisuje stan strojenia w postaci jednej linii tekstu.
+ *
+ * @param at Wskaźnik do struktury strojenia.
+ * @param line Bufor na linię.
+ * @param size Rozmiar bufora.
+ * @return Długość linii (bez znaku końca napisu).
+ */
+int AUTOTUNE_Format(const AUTOTUNE *at, char *line, size_t size)
+{
+    int len = snprintf(line, size, "A%u %u %u %u %.2f %.3f %.3f %.4g %.4g %.4g\n",
+                       (unsigned)at->state, (unsigned)at->rule, (unsigned)at->error, (unsigned)at->cycles,
+                       at->period, at->amp, at->Ku, at->Kp, at->Ki, at->Kd);
+
+    return (len < (int)size) ? len : (int)size - 1;
+}
@@ -0,0 +1,507 @@
+/**
+  ******************************************************************************
+  * @file    bmp2_array.c
+  * @brief   Array of BMP2xx sensors sharing one SPI bus;
+  *          DMA-chained read sequence and fused outputs.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "bmp2_array.h"
+
+#include <math.h>
+
+/* Typedef -------------------------------------------------------------------*/
+
+/* Define --------------------------------------------------------------------*/
+#define BMP2_ARRAY_XFER_LEN     (BMP2_REG_ADDR_LEN + BMP2_BURST_LEN)
+#define BMP2_ARRAY_TRIGGER_LEN  (BMP2_REG_ADDR_LEN + 1)
+
+/* Macro ---------------------------------------------------------------------*/
+#define BMP2_ARRAY_HANDLE(arr, i)  ((BMP2_HandleTypeDef*)((arr)->Dev[(i)]->intf_ptr))
+
+/* Public variables ----------------------------------------------------------*/
+BMP2_ArrayTypeDef bmp2array;
+
+/* Private function prototypes -----------------------------------------------*/
+static void bmp2_array_start_from(BMP2_ArrayTypeDef* arr, uint8_t first);
+static void bmp2_array_finish(BMP2_ArrayTypeDef* arr);
+static double bmp2_array_fuse(const double* values, uint8_t mask, uint8_t count,
+                              BMP2_FusionTypeDef fusion, double tol);
+static HAL_StatusTypeDef bmp2_array_reconfig_begin(BMP2_ArrayTypeDef* arr);
+
+/* Private function ----------------------------------------------------------*/
+
+/*!
+ *  @brief Starts the transfer of the first active sensor with index >= first.
+ *         Finishes the sequence if there is none left.
+ */
+static void bmp2_array_start_from(BMP2_ArrayTypeDef* arr, uint8_t first)
+{
+  HAL_StatusTypeDef status;
+
+  for (uint8_t i = first; i < arr->Count; i++)
+  {
+    BMP2_HandleTypeDef* h;
+
+    if ((arr->ActiveMask & (1u << i)) == 0)
+      continue;
+
+    h = BMP2_ARRAY_HANDLE(arr, i);
+    arr->Current = i;
+
+    HAL_GPIO_WritePin(h->CS_Port, h->CS_Pin, GPIO_PIN_RESET);
+    if (arr->Trigger)
+      status = HAL_SPI_TransmitReceive_DMA(h->SPI, arr->TriggerBuffer[i], arr->TriggerRxBuffer, BMP2_ARRAY_TRIGGER_LEN);
+    else
+      status = HAL_SPI_TransmitReceive_DMA(h->SPI, arr->TxBuffer, arr->RxBuffer[i], BMP2_ARRAY_XFER_LEN);
+    if (status == HAL_OK)
+      return;
+
+    /* Transfer could not be started - skip this sensor in the current sequence */
+    HAL_GPIO_WritePin(h->CS_Port, h->CS_Pin, GPIO_PIN_SET);
+    h->LastExecutionStatus = BMP2_E_COM_FAIL;
+    arr->ErrorCount++;
+  }
+
+  bmp2_array_finish(arr);
+}
+
+/*!
+ *  @brief Compensates the data of all sensors, computes fused outputs and
+ *         reports the end of the sequence. A trigger sequence only releases the bus.
+ */
+static void bmp2_array_finish(BMP2_ArrayTypeDef* arr)
+{
+  uint8_t valid = 0;
+
+  if (arr->Trigger)
+  {
+    arr->Trigger = 0;
+    arr->TriggerCount++;
+    arr->Busy = 0;
+    return;
+  }
+
+  for (uint8_t i = 0; i < arr->Count; i++)
+  {
+    BMP2_HandleTypeDef* h;
+
+    if ((arr->ActiveMask & (1u << i)) == 0)
+      continue;
+
+    h = BMP2_ARRAY_HANDLE(arr, i);
+    if (h->LastExecutionStatus == BMP2_E_COM_FAIL)
+      continue;
+
+    /* Data registers are shadowed - a late conversion leaves the previous result, count it */
+    if (arr->AcqMode == BMP2_ACQ_FORCED &&
+        (arr->RxBuffer[i][BMP2_DATA_INDEX + BMP2_BURST_STATUS_INDEX] & BMP2_STATUS_MEAS_MSK))
+      arr->StaleCount++;
+
+    h->LastExecutionStatus = BMP2_ParseBurst(arr->Dev[i], &arr->RxBuffer[i][BMP2_DATA_INDEX], &arr->Temp[i], &arr->Press[i]);
+    if (h->LastExecutionStatus < BMP2_OK)
+      continue;
+
+    h->ReadoutTemp = arr->Temp[i];
+    h->ReadoutPress = arr->Press[i];
+    valid |= (1u << i);
+  }
+
+  arr->ValidMask = valid;
+  arr->FusedTemp = bmp2_array_fuse(arr->Temp, valid, arr->Count, arr->Fusion, arr->VoteTolTemp);
+  arr->FusedPress = bmp2_array_fuse(arr->Press, valid, arr->Count, arr->Fusion, arr->VoteTolPress);
+  arr->SequenceCount++;
+  arr->Busy = 0;
+
+  BMP2_Array_ReadCpltCallback(arr);
+}
+
+/*!
+ *  @brief Marks the start of a blocking reconfiguration.
+ *  @note Reconfig is set before Busy is checked: an interrupt that starts a sequence
+ *        either completes before (Busy seen here) or sees Reconfig and refuses.
+ *  @retval HAL_OK   -> Reconfig set, no sequence in progress.
+ *  @retval HAL_BUSY -> Sequence in progress, Reconfig cleared.
+ */
+static HAL_StatusTypeDef bmp2_array_reconfig_begin(BMP2_ArrayTypeDef* arr)
+{
+  arr->Reconfig = 1;
+  if (arr->Busy)
+  {
+    arr->Reconfig = 0;
+    return HAL_BUSY;
+  }
+  return HAL_OK;
+}
+
+/*!
+ *  @brief Fuses the values selected by mask.
+ *  @return Fused value, NAN if no value is valid or no majority agrees (vote).
+ */
+static double bmp2_array_fuse(const double* values, uint8_t mask, uint8_t count,
+                              BMP2_FusionTypeDef fusion, double tol)
+{
+  double sorted[BMP2_NUM_OF_SENSORS];
+  double median, sum = 0.0;
+  uint8_t n = 0, agree = 0;
+
+  /* Insertion sort of the valid values (few sensors) */
+  for (uint8_t i = 0; i < count; i++)
+  {
+    uint8_t j;
+
+    if ((mask & (1u << i)) == 0)
+      continue;
+
+    for (j = n; j > 0 && sorted[j - 1] > values[i]; j--)
+      sorted[j] = sorted[j - 1];
+    sorted[j] = values[i];
+    n++;
+  }
+
+  if (n == 0)
+    return NAN;
+
+  median = (n % 2) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+
+  switch (fusion)
+  {
+    case BMP2_FUSION_MEDIAN:
+      return median;
+
+    case BMP2_FUSION_VOTE:
+      for (uint8_t i = 0; i < n; i++)
+      {
+        if (fabs(sorted[i] - median) <= tol)
+        {
+          sum += sorted[i];
+          agree++;
+        }
+      }
+      return (2 * agree > n) ? sum / agree : NAN;
+
+    case BMP2_FUSION_MEAN:
+    default:
+      for (uint8_t i = 0; i < n; i++)
+        sum += sorted[i];
+      return sum / n;
+  }
+}
+
+/* Public function -----------------------------------------------------------*/
+
+/*!
+ *  @brief Sensor array initialization function.
+ *  @param[in] arr   : Sensor array structure
+ *  @param[in] devs  : Table of BMP2xx device structures
+ *  @param[in] count : Number of sensors (<= BMP2_NUM_OF_SENSORS)
+ *  @param[in] fusion: Fusion method for FusedTemp/FusedPress
+ *
+ *  @return Number of active sensors
+ */
+uint8_t BMP2_Array_Init(BMP2_ArrayTypeDef* arr, struct bmp2_dev* const devs[], uint8_t count, BMP2_FusionTypeDef fusion)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+  uint8_t active = 0;
+
+  if (count > BMP2_NUM_OF_SENSORS)
+    count = BMP2_NUM_OF_SENSORS;
+
+  arr->Count = count;
+  arr->ActiveMask = 0;
+  arr->ValidMask = 0;
+  arr->Fusion = fusion;
+  arr->VoteTolTemp = BMP2_ARRAY_VOTE_TOL_TEMP;
+  arr->VoteTolPress = BMP2_ARRAY_VOTE_TOL_PRESS;
+  arr->FusedTemp = NAN;
+  arr->FusedPress = NAN;
+  arr->SequenceCount = 0;
+  arr->ErrorCount = 0;
+  arr->TimeoutCount = 0;
+  arr->Busy = 0;
+  arr->AcqMode = BMP2_ACQ_NORMAL;
+  arr->MeasTime = 0;
+  arr->Trigger = 0;
+  arr->TriggerCount = 0;
+  arr->StaleCount = 0;
+  arr->Reconfig = 0;
+  arr->ReconfigSkipCount = 0;
+
+  /* Every transfer reads the status and data registers (0xF3..0xFC) in one burst */
+  arr->TxBuffer[BMP2_REG_ADDR_INDEX] = BMP2_REG_STATUS | BMP2_SPI_RD_MASK;
+  for (uint8_t i = BMP2_DATA_INDEX; i < BMP2_ARRAY_XFER_LEN; i++)
+    arr->TxBuffer[i] = 0x00;
+
+  /* Chip-select lines: push-pull outputs, inactive (high) */
+  GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    BMP2_HandleTypeDef* h;
+
+    arr->Dev[i] = devs[i];
+    h = BMP2_ARRAY_HANDLE(arr, i);
+    HAL_GPIO_WritePin(h->CS_Port, h->CS_Pin, GPIO_PIN_SET);
+    GPIO_InitStruct.Pin = h->CS_Pin;
+    HAL_GPIO_Init(h->CS_Port, &GPIO_InitStruct);
+  }
+
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (BMP2_Init(arr->Dev[i]) == BMP2_OK)
+    {
+      arr->ActiveMask |= (1u << i);
+      active++;
+    }
+  }
+
+  return active;
+}
+
+/*!
+ *  @brief Starts the DMA-chained read of all active sensors.
+ *  @param[in] arr : Sensor array structure
+ *
+ *  @retval HAL_OK   -> Sequence started.
+ *  @retval HAL_BUSY -> Previous sequence or reconfiguration still in progress.
+ *  @retval HAL_ERROR-> No active sensor.
+ */
+HAL_StatusTypeDef BMP2_Array_StartRead(BMP2_ArrayTypeDef* arr)
+{
+  if (arr->ActiveMask == 0)
+    return HAL_ERROR;
+
+  if (arr->Busy || arr->Reconfig)
+    return HAL_BUSY;
+
+  arr->Busy = 1;
+  arr->Trigger = 0;
+  for (uint8_t i = 0; i < arr->Count; i++)
+    BMP2_ARRAY_HANDLE(arr, i)->LastExecutionStatus = BMP2_OK;
+
+  bmp2_array_start_from(arr, 0);
+  return HAL_OK;
+}
+
+/*!
+ *  @brief Switches all active sensors to forced mode.
+ *  @param[in] arr : Sensor array structure
+ *
+ *  @retval HAL_OK   -> All active sensors switched.
+ *  @retval HAL_BUSY -> Sequence in progress, nothing changed.
+ *  @retval HAL_ERROR-> No active sensor or a sensor did not accept the settings
+ *                      (it is removed from ActiveMask).
+ */
+HAL_StatusTypeDef BMP2_Array_SetForcedMode(BMP2_ArrayTypeDef* arr)
+{
+  HAL_StatusTypeDef status = HAL_OK;
+  uint32_t meas_time, longest = 0;
+  uint8_t ctrl_meas;
+
+  if (arr->ActiveMask == 0)
+    return HAL_ERROR;
+
+  if (bmp2_array_reconfig_begin(arr) != HAL_OK)
+    return HAL_BUSY;
+
+  for (uint8_t i = 0; i < arr->Count; i++)
+  {
+    if ((arr->ActiveMask & (1u << i)) == 0)
+      continue;
+
+    if (BMP2_SetForcedMode(arr->Dev[i], &ctrl_meas, &meas_time) != BMP2_OK)
+    {
+      arr->ActiveMask &= ~(1u << i);
+      status = HAL_ERROR;
+      continue;
+    }
+
+    arr->TriggerBuffer[i][BMP2_REG_ADDR_INDEX] = BMP2_REG_CTRL_MEAS & BMP2_SPI_WR_MASK;
+    arr->TriggerBuffer[i][BMP2_DATA_INDEX] = ctrl_meas;
+    if (meas_time > longest)
+      longest = meas_time;
+  }
+
+  arr->MeasTime = longest;
+  arr->AcqMode = BMP2_ACQ_FORCED;
+  arr->Reconfig = 0;
+  return (arr->ActiveMask == 0) ? HAL_ERROR : status;
+}
+
+/*!
+ *  @brief Starts a forced-mode conversion on all active sensors.
+ *  @param[in] arr : Sensor array structure
+ *
+ *  @retval HAL_OK   -> Triggers started.
+ *  @retval HAL_BUSY -> Sequence or reconfiguration in progress.
+ *  @retval HAL_ERROR-> No active sensor or array not in forced mode.
+ */
+HAL_StatusTypeDef BMP2_Array_StartConversion(BMP2_ArrayTypeDef* arr)
+{
+  if (arr->ActiveMask == 0 || arr->AcqMode != BMP2_ACQ_FORCED)
+    return HAL_ERROR;
+
+  if (arr->Busy || arr->Reconfig)
+    return HAL_BUSY;
+
+  /* Read statuses are kept; a failed trigger is visible as BMP2_E_COM_FAIL until the next read */
+  arr->Busy = 1;
+  arr->Trigger = 1;
+  bmp2_array_start_from(arr, 0);
+  return HAL_OK;
+}
+
+/*!
+ *  @brief Changes oversampling and IIR filter settings of all active sensors.
+ *  @param[in] arr     : Sensor array structure
+ *  @param[in] os_mode : BMP2_OS_MODE_...
+ *  @param[in] filter  : BMP2_FILTER_...
+ *
+ *  @retval HAL_OK   -> All active sensors reconfigured.
+ *  @retval HAL_BUSY -> Sequence in progress, nothing changed.
+ *  @retval HAL_ERROR-> No active sensor or a sensor did not accept the settings.
+ */
+HAL_StatusTypeDef BMP2_Array_SetOversampling(BMP2_ArrayTypeDef* arr, uint8_t os_mode, uint8_t filter)
+{
+  HAL_StatusTypeDef status = HAL_OK;
+  uint32_t meas_time, longest = 0;
+  uint8_t ctrl_meas;
+
+  if (arr->ActiveMask == 0)
+    return HAL_ERROR;
+
+  if (bmp2_array_reconfig_begin(arr) != HAL_OK)
+    return HAL_BUSY;
+
+  for (uint8_t i = 0; i < arr->Count; i++)
+  {
+    if ((arr->ActiveMask & (1u << i)) == 0)
+      continue;
+
+    /* A sensor that failed keeps its previous trigger value; health monitoring handles its data */
+    if (BMP2_SetOversampling(arr->Dev[i], os_mode, filter, &ctrl_meas, &meas_time) != BMP2_OK)
+    {
+      status = HAL_ERROR;
+      continue;
+    }
+
+    arr->TriggerBuffer[i][BMP2_DATA_INDEX] = ctrl_meas;
+    if (meas_time > longest)
+      longest = meas_time;
+  }
+
+  if (longest > arr->MeasTime || status == HAL_OK)
+    arr->MeasTime = longest;
+  arr->Reconfig = 0;
+  return status;
+}
+
+/*!
+ *  @brief Minimum time between BMP2_Array_StartConversion() and BMP2_Array_StartRead().
+ *  @param[in] arr : Sensor array structure
+ *
+ *  @return Trigger lead [us]
+ */
+uint32_t BMP2_Array_GetTriggerLead(const BMP2_ArrayTypeDef* arr)
+{
+  return arr->MeasTime + arr->MeasTime / 4u + BMP2_ARRAY_TRIGGER_MARGIN_US;
+}
+
+/*!
+ *  @brief Aborts the read sequence in progress.
+ *  @param[in] arr : Sensor array structure
+ *
+ *  @retval HAL_OK   -> Sequence aborted.
+ *  @retval HAL_ERROR-> No sequence in progress.
+ */
+HAL_StatusTypeDef BMP2_Array_Abort(BMP2_ArrayTypeDef* arr)
+{
+  BMP2_HandleTypeDef* h;
+
+  if (!arr->Busy)
+    return HAL_ERROR;
+
+  h = BMP2_ARRAY_HANDLE(arr, arr->Current);
+  HAL_SPI_Abort(h->SPI);
+  HAL_GPIO_WritePin(h->CS_Port, h->CS_Pin, GPIO_PIN_SET);
+
+  for (uint8_t i = arr->Current; i < arr->Count; i++)
+    BMP2_ARRAY_HANDLE(arr, i)->LastExecutionStatus = BMP2_E_COM_FAIL;
+
+  arr->ErrorCount++;
+  arr->TimeoutCount++;
+  bmp2_array_finish(arr);
+  return HAL_OK;
+}
+
+/*!
+ *  @brief Fuses the last readouts of the sensors selected by mask.
+ *  @param[in]  arr   : Sensor array structure
+ *  @param[in]  mask  : Sensors to include
+ *  @param[out] temp  : Fused temperature [degC], NAN if none selected (may be NULL)
+ *  @param[out] press : Fused pressure [hPa], NAN if none selected (may be NULL)
+ */
+void BMP2_Array_Fuse(const BMP2_ArrayTypeDef* arr, uint8_t mask, double* temp, double* press)
+{
+  mask &= arr->ValidMask;
+
+  if (temp != NULL)
+    *temp = bmp2_array_fuse(arr->Temp, mask, arr->Count, arr->Fusion, arr->VoteTolTemp);
+  if (press != NULL)
+    *press = bmp2_array_fuse(arr->Press, mask, arr->Count, arr->Fusion, arr->VoteTolPress);
+}
+
+/*!
+ *  @brief To be called from HAL_SPI_TxRxCpltCallback().
+ *  @param[in] arr  : Sensor array structure
+ *  @param[in] hspi : SPI handle which completed the transfer
+ */
+void BMP2_Array_SpiTxRxCpltCallback(BMP2_ArrayTypeDef* arr, SPI_HandleTypeDef* hspi)
+{
+  BMP2_HandleTypeDef* h;
+
+  if (!arr->Busy)
+    return;
+
+  h = BMP2_ARRAY_HANDLE(arr, arr->Current);
+  if (h->SPI != hspi)
+    return;
+
+  HAL_GPIO_WritePin(h->CS_Port, h->CS_Pin, GPIO_PIN_SET);
+  bmp2_array_start_from(arr, arr->Current + 1);
+}
+
+/*!
+ *  @brief To be called from HAL_SPI_ErrorCallback().
+ *  @param[in] arr  : Sensor array structure
+ *  @param[in] hspi : SPI handle which reported the error
+ */
+void BMP2_Array_SpiErrorCallback(BMP2_ArrayTypeDef* arr, SPI_HandleTypeDef* hspi)
+{
+  BMP2_HandleTypeDef* h;
+
+  if (!arr->Busy)
+    return;
+
+  h = BMP2_ARRAY_HANDLE(arr, arr->Current);
+  if (h->SPI != hspi)
+    return;
+
+  HAL_GPIO_WritePin(h->CS_Port, h->CS_Pin, GPIO_PIN_SET);
+  h->LastExecutionStatus = BMP2_E_COM_FAIL;
+  arr->ErrorCount++;
+  bmp2_array_start_from(arr, arr->Current + 1);
+}
+
+/*!
+ *  @brief Read sequence complete callback (interrupt context).
+ *  @note Weak function, to be overridden by the application.
+ *  @param[in] arr : Sensor array structure
+ */
+__weak void BMP2_Array_ReadCpltCallback(BMP2_ArrayTypeDef* arr)
+{
+  UNUSED(arr);
+}
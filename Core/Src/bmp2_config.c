@@ -14,6 +14,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "bmp2.h"
 #include "bmp2_config.h"
+#include "utimer.h"
 
 #include <string.h>
 #include <math.h>
@@ -32,6 +33,13 @@ BMP2_HandleTypeDef hbmp2 = {
   .MaxRetry = 10
 };
 
+BMP2_HandleTypeDef hbmp2_2 = {
+  .SPI = &hspi4,
+  .CS_Port = BMP2_CSB2_GPIO_Port,
+  .CS_Pin = BMP2_CSB2_Pin,
+  .MaxRetry = 10
+};
+
 /* Public variables ----------------------------------------------------------*/
 struct bmp2_dev bmp2dev = {
   .intf_ptr = (void*) &hbmp2,
@@ -40,12 +48,65 @@ struct bmp2_dev bmp2dev = {
   .delay_us = bmp2_delay_us
 };
 
+struct bmp2_dev bmp2dev_2 = {
+  .intf_ptr = (void*) &hbmp2_2,
+  .intf = BMP2_SPI_INTF,
+  .read = bmp2_spi_read, .write = bmp2_spi_write,
+  .delay_us = bmp2_delay_us
+};
+
 /* Private function prototypes -----------------------------------------------*/
+static int8_t bmp2_read_forced_ctrl_meas(struct bmp2_dev* dev, uint8_t* ctrl_meas);
 
 /* Private function ----------------------------------------------------------*/
 
+/*!
+ *  @brief Reads ctrl_meas and sets its mode bits to forced, so that writing it back
+ *         starts a conversion with the current settings.
+ */
+static int8_t bmp2_read_forced_ctrl_meas(struct bmp2_dev* dev, uint8_t* ctrl_meas)
+{
+  int8_t rslt;
+
+  rslt = bmp2_get_regs(BMP2_REG_CTRL_MEAS, ctrl_meas, 1, dev);
+
+  /* The sensor returns to sleep after the conversion - the register read back may already show it */
+  if (rslt == BMP2_OK)
+    *ctrl_meas = BMP2_SET_BITS_POS_0(*ctrl_meas, BMP2_POWERMODE, BMP2_POWERMODE_FORCED);
+
+  return rslt;
+}
+
 /* Public function -----------------------------------------------------------*/
 
+/*!
+ *  @brief Converts raw data registers into compensated temperature and pressure.
+ *  @param[in]  dev      : BMP2xx device structure (calibration parameters)
+ *  @param[in]  reg_data : Content of registers 0xF7..0xFC (BMP2_P_T_LEN bytes)
+ *  @param[out] comp_data: Compensated data; pressure in [Pa], temperature in [degC]
+ *
+ *  @return Status of execution
+ *
+ *  @retval 0 -> Success.
+ *  @retval >0 -> Warning (value clipped).
+ *  @retval <0 -> Failure (raw data out of range, e.g. conversion skipped or bus fault).
+ *
+ */
+int8_t BMP2_CompensateRaw(struct bmp2_dev *dev, const uint8_t *reg_data, struct bmp2_data *comp_data)
+{
+  struct bmp2_uncomp_data uncomp_data;
+
+  uncomp_data.pressure = ((uint32_t)reg_data[0] << 12) | ((uint32_t)reg_data[1] << 4) | ((uint32_t)reg_data[2] >> 4);
+  uncomp_data.temperature = (int32_t)(((uint32_t)reg_data[3] << 12) | ((uint32_t)reg_data[4] << 4) | ((uint32_t)reg_data[5] >> 4));
+
+  /* 0x80000 is the reset value of a skipped conversion, 0xFFFFF a floating MISO line */
+  if (uncomp_data.temperature <= BMP2_ST_ADC_T_MIN || uncomp_data.temperature >= BMP2_ST_ADC_T_MAX ||
+      uncomp_data.temperature == 0x80000)
+    return BMP2_E_UNCOMP_TEMP_RANGE;
+
+  return bmp2_compensate_data(&uncomp_data, comp_data, dev);
+}
+
 /*!
  *  @brief BMP2xx initialization function.
  *  @note Enables both pressure and temperature measurement with no oversampling.
@@ -67,12 +128,17 @@ int8_t BMP2_Init(struct bmp2_dev* dev)
 
   rslt = bmp2_init(dev);
 
+  /* Sensor not found or not responding - leave it unconfigured */
+  if (rslt != BMP2_OK)
+    return rslt;
+
   /* Always read the current settings before writing, especially when all the configuration is not modified */
   rslt = bmp2_get_config(&conf, dev);
 
   /* Configuring the over-sampling mode, filter coefficient and output data rate */
   /* Overwrite the desired settings */
-  conf.filter = BMP2_FILTER_COEFF_8;
+  /* Light IIR filtering only - noise is handled by the state estimator in the control loop */
+  conf.filter = BMP2_FILTER_COEFF_2;
   /* Over-sampling mode is set as ultra low resolution i.e., os_pres = 1x and os_temp = 1x */
   conf.os_mode = BMP2_OS_MODE_ULTRA_LOW_POWER;
   /* Setting the output data rate */
@@ -89,6 +155,80 @@ int8_t BMP2_Init(struct bmp2_dev* dev)
   return rslt;
 }
 
+/*!
+ *  @brief Switches BMP2xx to forced mode (one conversion per trigger).
+ *  @note Keeps the oversampling and filter settings made by BMP2_Init(). Setting the
+ *        forced mode starts the first conversion; every following one is started
+ *        by writing the returned ctrl_meas value back to BMP2_REG_CTRL_MEAS.
+ *  @param[in]  dev       : BMP2xx device structure
+ *  @param[out] ctrl_meas : ctrl_meas register value that starts a conversion
+ *  @param[out] meas_time : Conversion time [us]
+ *
+ *  @return Status of execution
+ *
+ *  @retval BMP2_OK -> Success.
+ *  @retval <0 -> Failure.
+ *
+ */
+int8_t BMP2_SetForcedMode(struct bmp2_dev* dev, uint8_t* ctrl_meas, uint32_t* meas_time)
+{
+  int8_t rslt;
+  struct bmp2_config conf;
+
+  rslt = bmp2_get_config(&conf, dev);
+  if (rslt == BMP2_OK)
+    rslt = bmp2_set_power_mode(BMP2_POWERMODE_FORCED, &conf, dev);
+  if (rslt == BMP2_OK)
+    rslt = bmp2_read_forced_ctrl_meas(dev, ctrl_meas);
+  if (rslt == BMP2_OK)
+    rslt = bmp2_compute_meas_time(meas_time, &conf, dev);
+
+  return rslt;
+}
+
+/*!
+ *  @brief Changes oversampling and IIR filter settings of BMP2xx.
+ *  @note bmp2_set_config() soft-resets the sensor, so the filter history is lost and
+ *        data registers hold the reset value until the next conversion. In normal
+ *        mode the sensor is restarted; in forced mode it stays asleep until the next
+ *        trigger. Blocking SPI and bmp2_delay_us() are used (about 2 ms).
+ *  @param[in]  dev       : BMP2xx device structure
+ *  @param[in]  os_mode   : BMP2_OS_MODE_...
+ *  @param[in]  filter    : BMP2_FILTER_...
+ *  @param[out] ctrl_meas : ctrl_meas register value that starts a forced conversion
+ *  @param[out] meas_time : Conversion time [us]
+ *
+ *  @return Status of execution
+ *
+ *  @retval BMP2_OK -> Success.
+ *  @retval <0 -> Failure.
+ *
+ */
+int8_t BMP2_SetOversampling(struct bmp2_dev* dev, uint8_t os_mode, uint8_t filter, uint8_t* ctrl_meas, uint32_t* meas_time)
+{
+  int8_t rslt;
+  struct bmp2_config conf;
+
+  rslt = bmp2_get_config(&conf, dev);
+  if (rslt != BMP2_OK)
+    return rslt;
+
+  conf.os_mode = os_mode;
+  conf.filter = filter;
+
+  if (dev->power_mode == BMP2_POWERMODE_NORMAL)
+    rslt = bmp2_set_power_mode(BMP2_POWERMODE_NORMAL, &conf, dev);
+  else
+    rslt = bmp2_set_config(&conf, dev);
+
+  if (rslt == BMP2_OK)
+    rslt = bmp2_read_forced_ctrl_meas(dev, ctrl_meas);
+  if (rslt == BMP2_OK)
+    rslt = bmp2_compute_meas_time(meas_time, &conf, dev);
+
+  return rslt;
+}
+
 /*!
  *  @brief Function for reading the sensor's registers through SPI bus.
  *
@@ -177,46 +317,96 @@ BMP2_INTF_RET_TYPE bmp2_spi_write(uint8_t reg_addr, const uint8_t *reg_data, uin
 void bmp2_delay_us(uint32_t period_us, void *intf_ptr)
 {
   UNUSED(intf_ptr);
-  HAL_Delay(period_us / 1000uL);
+  /* Exact wait - HAL_Delay() had millisecond granularity and truncated e.g. the 2 ms start-up time */
+  UTIMER_DelayUs(period_us);
 }
 
 /*!
- *  @brief This internal API is used to get compensated pressure and temperature data.
+ *  @brief Parses a status+data burst (registers 0xF3..0xFC) into compensated values.
+ *  @note Temperature is compensated once and its t_fine is reused for pressure.
  *  @param[in]  dev   : BMP2xx device structure
- *  @param[out] press : Pressure measurement [hPa]
+ *  @param[in]  burst : BMP2_BURST_LEN bytes read from BMP2_REG_STATUS
  *  @param[out] temp  : Temperature measurement [degC]
+ *  @param[out] press : Pressure measurement [hPa]
  *
  *  @return Status of execution
  *
  *  @retval 0 -> Success.
+ *  @retval >0 -> Warning (value clipped).
  *  @retval <0 -> Failure.
  *
  */
-int8_t BMP2_ReadData(struct bmp2_dev *dev, double* press, double* temp)
+int8_t BMP2_ParseBurst(struct bmp2_dev *dev, const uint8_t *burst, double* temp, double* press)
 {
-  int8_t rslt = BMP2_E_NULL_PTR;
-  struct bmp2_status status;
   struct bmp2_data comp_data;
+  int8_t rslt;
+
+  rslt = BMP2_CompensateRaw(dev, &burst[BMP2_BURST_DATA_INDEX], &comp_data);
+  if (rslt < BMP2_OK)
+    return rslt;
+
+  *temp = comp_data.temperature;
+  *press = comp_data.pressure / 100.0;
+  return rslt;
+}
+
+/*!
+ *  @brief Reads status and data registers in a single SPI burst and returns
+ *         both compensated temperature and pressure.
+ *  @note The burst is repeated (up to MaxRetry times) only while a conversion
+ *        is in progress; each attempt is one SPI transaction.
+ *  @param[in]  dev   : BMP2xx device structure
+ *  @param[out] temp  : Temperature measurement [degC], NAN on failure
+ *  @param[out] press : Pressure measurement [hPa], NAN on failure
+ *
+ *  @return Status of execution
+ *
+ *  @retval 0 -> Success.
+ *  @retval >0 -> Warning (value clipped).
+ *  @retval <0 -> Failure.
+ *
+ */
+int8_t BMP2_ReadTempPress(struct bmp2_dev *dev, double* temp, double* press)
+{
+  uint8_t burst[BMP2_BURST_LEN];
+  int8_t rslt;
   int8_t try = BMP2_GET_MAX_RETRY(dev);
 
   do {
-    /* Read sensor status */
-    rslt = bmp2_get_status(&status, dev);
-    /* Read compensated data */
-    rslt = bmp2_get_sensor_data(&comp_data, dev);
-    *temp = comp_data.temperature;
-    *press = comp_data.pressure / 100.0;
+    rslt = bmp2_get_regs(BMP2_REG_STATUS, burst, BMP2_BURST_LEN, dev);
     try--;
-  } while (status.measuring != BMP2_MEAS_DONE && try > 0);
+  } while (rslt == BMP2_OK && (burst[BMP2_BURST_STATUS_INDEX] & BMP2_STATUS_MEAS_MSK) && try > 0);
+
+  *temp = NAN;
+  *press = NAN;
+  if (rslt == BMP2_OK)
+    rslt = BMP2_ParseBurst(dev, burst, temp, press);
 
   /* Save reading result in sensor handler */
-  BMP2_GET_PRESS(dev) = *press;
   BMP2_GET_TEMP(dev) = *temp;
+  BMP2_GET_PRESS(dev) = *press;
   BMP2_GET_STATUS(dev) = rslt;
 
   return rslt;
 }
 
+/*!
+ *  @brief This internal API is used to get compensated pressure and temperature data.
+ *  @param[in]  dev   : BMP2xx device structure
+ *  @param[out] press : Pressure measurement [hPa]
+ *  @param[out] temp  : Temperature measurement [degC]
+ *
+ *  @return Status of execution
+ *
+ *  @retval 0 -> Success.
+ *  @retval <0 -> Failure.
+ *
+ */
+int8_t BMP2_ReadData(struct bmp2_dev *dev, double* press, double* temp)
+{
+  return BMP2_ReadTempPress(dev, temp, press);
+}
+
 /*!
  *  @brief This internal API is used to get compensated temperature data.
  *  @param[in]  dev   : BMP2xx device structure
@@ -225,25 +415,9 @@ int8_t BMP2_ReadData(struct bmp2_dev *dev, double* press, double* temp)
  */
 double BMP2_ReadTemperature_degC(struct bmp2_dev *dev)
 {
-  int8_t rslt = BMP2_E_NULL_PTR;
-  struct bmp2_status status;
-  struct bmp2_data comp_data;
-  double temp = NAN;
-  int8_t try = BMP2_GET_MAX_RETRY(dev);
-
-  do {
-    /* Read sensor status */
-    rslt = bmp2_get_status(&status, dev);
-    /* Read compensated data */
-    rslt = bmp2_get_sensor_data(&comp_data, dev);
-    temp = comp_data.temperature;
-    try--;
-  } while (status.measuring != BMP2_MEAS_DONE && try > 0);
-
-  /* Save reading result in sensor handler */
-  BMP2_GET_TEMP(dev) = temp;
-  BMP2_GET_STATUS(dev) = rslt;
+  double temp, press;
 
+  BMP2_ReadTempPress(dev, &temp, &press);
   return temp;
 }
 
@@ -255,24 +429,8 @@ double BMP2_ReadTemperature_degC(struct bmp2_dev *dev)
  */
 double BMP2_ReadPressure_hPa(struct bmp2_dev *dev)
 {
-  int8_t rslt = BMP2_E_NULL_PTR;
-  struct bmp2_status status;
-  struct bmp2_data comp_data;
-  double press = NAN;
-  int8_t try = BMP2_GET_MAX_RETRY(dev);
-
-  do {
-    /* Read sensor status */
-    rslt = bmp2_get_status(&status, dev);
-    /* Read compensated data */
-    rslt = bmp2_get_sensor_data(&comp_data, dev);
-    press = comp_data.pressure / 100.0;
-    try--;
-  } while (status.measuring != BMP2_MEAS_DONE && try > 0);
-
-  /* Save reading result in sensor handler */
-  BMP2_GET_PRESS(dev) = press;
-  BMP2_GET_STATUS(dev) = rslt;
+  double temp, press;
 
+  BMP2_ReadTempPress(dev, &temp, &press);
   return press;
 }
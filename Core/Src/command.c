@@ -0,0 +1,518 @@
+#include "command.h"
+#include "autotune.h"
+#include "eth.h"
+#include "feedforward.h"
+#include "gain_schedule.h"
+#include "idle.h"
+#include "latency.h"
+#include "scope.h"
+#include "sampling_policy.h"
+#include "sensor_health.h"
+#include "usart.h"
+#include "usb_cdc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @file command.c
+ * @brief Implementacja odbioru i interpretacji poleceń tekstowych przesyłanych przez UART, USB i UDP.
+ *
+ * Każde łącze ma własny bufor składania linii, a gotowa linia zapamiętuje łącze, z którego
+ * przyszła - odpowiedzi (także dane rejestratora) wysyłane są tym samym łączem.
+ */
+
+static UART_HandleTypeDef *cmd_huart;
+static double *cmd_setpoint;
+
+static uint8_t cmd_rx_byte;                     /**< Bufor odbioru pojedynczego znaku */
+static char cmd_rx_line[CMD_LINK_COUNT][CMD_LINE_LEN + 1];  /**< Linie w trakcie odbioru */
+static uint32_t cmd_rx_len[CMD_LINK_COUNT];
+static char cmd_line[CMD_LINE_LEN + 1];         /**< Linia gotowa do wykonania */
+static CMD_Link cmd_line_link;                  /**< Łącze, z którego przyszła linia */
+static volatile uint8_t cmd_line_ready = 0;
+static CMD_Link cmd_reply_link = CMD_LINK_UART; /**< Łącze ostatniego wykonanego polecenia */
+
+static uint32_t cmd_udp_rx_ip;                  /**< Nadawca odbieranego datagramu */
+static uint16_t cmd_udp_rx_port;
+static uint32_t cmd_udp_line_ip;                /**< Nadawca linii gotowej do wykonania */
+static uint16_t cmd_udp_line_port;
+static uint32_t cmd_udp_reply_ip;               /**< Adresat odpowiedzi na ostatnie polecenie UDP */
+static uint16_t cmd_udp_reply_port;
+static CMD_Link cmd_dump_link = CMD_LINK_UART;  /**< Łącze, z którego uzbrojono rejestrator */
+static uint32_t cmd_udp_dump_ip;                /**< Adresat przebiegu przy uzbrojeniu przez UDP */
+static uint16_t cmd_udp_dump_port;
+
+static uint32_t cmd_baud_previous;              /**< Prędkość sprzed zmiany (do powrotu) */
+static uint32_t cmd_baud_switch_tick;           /**< Chwila zmiany prędkości [ms] */
+static uint8_t cmd_baud_pending = 0;            /**< Czy zmiana czeka na potwierdzenie */
+
+/**
+ * @brief Inicjalizuje odbiór poleceń i uruchamia odbiór w przerwaniu.
+ *
+ * @param huart Wskaźnik na strukturę UART, z której odbierane są polecenia.
+ * @param setpoint Wskaźnik na zmienną przechowującą temperaturę zadaną.
+ */
+void CMD_Init(UART_HandleTypeDef *huart, double *setpoint)
+{
+    cmd_huart = huart;
+    cmd_setpoint = setpoint;
+    memset(cmd_rx_len, 0, sizeof(cmd_rx_len));
+    cmd_line_ready = 0;
+    HAL_UART_Receive_IT(cmd_huart, &cmd_rx_byte, 1);
+}
+
+/**
+ * @brief Dołącza znak do linii danego łącza. Wywoływana z przerwania.
+ */
+static void cmd_rx_char(CMD_Link link, uint8_t c)
+{
+    uint32_t *len = &cmd_rx_len[link];
+    uint32_t primask;
+
+    if (c == '\n' || c == '\r') {
+        // Przekazanie wywoływane z przerwań UART i USB oraz z pętli głównej (UDP) - wywołanie
+        // z innego łącza nie może przerwać kopiowania ani podmienić łącza odpowiedzi
+        primask = __get_PRIMASK();
+        __disable_irq();
+        // Linia jest przekazywana tylko, gdy poprzednia została już wykonana
+        if (*len > 0 && !cmd_line_ready) {
+            memcpy(cmd_line, cmd_rx_line[link], *len);
+            cmd_line[*len] = '\0';
+            cmd_line_link = link;
+            if (link == CMD_LINK_UDP) {
+                cmd_udp_line_ip = cmd_udp_rx_ip;
+                cmd_udp_line_port = cmd_udp_rx_port;
+            }
+            cmd_line_ready = 1;
+            IDLE_Wake();
+        }
+        __set_PRIMASK(primask);
+        *len = 0;
+    } else if (*len < CMD_LINE_LEN) {
+        cmd_rx_line[link][(*len)++] = (char)c;
+    } else {
+        // Zbyt długa linia jest odrzucana w całości
+        *len = 0;
+    }
+}
+
+/**
+ * @brief Przyjmuje odebrany znak i wznawia odbiór. Wywoływana z HAL_UART_RxCpltCallback.
+ *
+ * @param huart Wskaźnik na strukturę UART, która zgłosiła zakończenie odbioru.
+ */
+void CMD_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart != cmd_huart) {
+        return;
+    }
+
+    cmd_rx_char(CMD_LINK_UART, cmd_rx_byte);
+    HAL_UART_Receive_IT(cmd_huart, &cmd_rx_byte, 1);
+}
+
+/**
+ * @brief Przyjmuje dane odebrane przez port USB. Wywoływana z CDC_ReceiveCallback.
+ *
+ * @param data Odebrane dane.
+ * @param len Liczba bajtów.
+ */
+void CMD_RxUsb(const uint8_t *data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        cmd_rx_char(CMD_LINK_USB, data[i]);
+    }
+}
+
+/**
+ * @brief Przyjmuje datagram UDP z poleceniem. Wywoływana z NET_UdpReceiveCallback.
+ *
+ * @param src_ip Adres nadawcy (na niego wysyłana jest odpowiedź).
+ * @param src_port Port nadawcy.
+ * @param data Odebrane dane.
+ * @param len Liczba bajtów.
+ */
+void CMD_RxUdp(uint32_t src_ip, uint16_t src_port, const uint8_t *data, uint32_t len)
+{
+    cmd_udp_rx_ip = src_ip;
+    cmd_udp_rx_port = src_port;
+    cmd_rx_len[CMD_LINK_UDP] = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        cmd_rx_char(CMD_LINK_UDP, data[i]);
+    }
+    // Koniec datagramu kończy linię, także bez znaku '\n'
+    cmd_rx_char(CMD_LINK_UDP, '\n');
+}
+
+/**
+ * @brief Wysyła dane wskazanym łączem (dla UDP - na podany adres i port).
+ */
+static HAL_StatusTypeDef cmd_write_link(CMD_Link link, uint32_t ip, uint16_t port,
+                                        const uint8_t *data, uint16_t len)
+{
+    if (link == CMD_LINK_USB) {
+        return CDC_Transmit(data, len);
+    }
+    if (link == CMD_LINK_UDP) {
+        switch (NET_UdpSend(ip, port, CMD_UDP_PORT, data, len)) {
+        case NET_OK:
+            return HAL_OK;
+        case NET_BUSY:
+            return HAL_BUSY;
+        default:
+            return HAL_ERROR;
+        }
+    }
+    // Czas transmisji przy bieżącej prędkości (10 bitów na znak) z zapasem - raporty
+    // dłuższe niż ~100 B nie mieszczą się w stałym limicie przy 9600 bit/s
+    return HAL_UART_Transmit(cmd_huart, (uint8_t*)data, len,
+                             (uint32_t)len * 10000u / cmd_huart->Init.BaudRate + CMD_UART_TIMEOUT_MARGIN);
+}
+
+/**
+ * @brief Wysyła dane łączem, z którego przyszło ostatnie polecenie.
+ *
+ * @param data Dane do wysłania.
+ * @param len Liczba bajtów.
+ * @return HAL_OK lub status błędu/zajętości łącza (dane nie zostały wysłane).
+ */
+HAL_StatusTypeDef CMD_Write(const uint8_t *data, uint16_t len)
+{
+    return cmd_write_link(cmd_reply_link, cmd_udp_reply_ip, cmd_udp_reply_port, data, len);
+}
+
+/**
+ * @brief Zwraca łącze, którym wysyłany jest zarejestrowany przebieg.
+ */
+CMD_Link CMD_GetDumpLink(void)
+{
+    return cmd_dump_link;
+}
+
+/**
+ * @brief Wysyła dane przebiegu łączem, z którego uzbrojono rejestrator.
+ *
+ * @param data Dane do wysłania.
+ * @param len Liczba bajtów.
+ * @return HAL_OK lub status błędu/zajętości łącza (dane nie zostały wysłane).
+ */
+HAL_StatusTypeDef CMD_WriteDump(const uint8_t *data, uint16_t len)
+{
+    return cmd_write_link(cmd_dump_link, cmd_udp_dump_ip, cmd_udp_dump_port, data, len);
+}
+
+/**
+ * @brief Wznawia odbiór po błędzie transmisji. Wywoływana z HAL_UART_ErrorCallback.
+ *
+ * @param huart Wskaźnik na strukturę UART, która zgłosiła błąd.
+ */
+void CMD_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart != cmd_huart) {
+        return;
+    }
+    cmd_rx_len[CMD_LINK_UART] = 0;
+    HAL_UART_Receive_IT(cmd_huart, &cmd_rx_byte, 1);
+}
+
+/**
+ * @brief Wykonuje polecenia harmonogramu nastaw ("GS", "GT" - wczytanie tablicy, "GX" - wyłączenie).
+ *
+ * Tablica: punkty "<x>,<Kp>,<Ki>,<Kd>,<imin>,<imax>" rozdzielone znakiem ';'.
+ */
+static void cmd_gain_schedule(const char *args)
+{
+    GAINSCHED_Point points[GAINSCHED_MAX_POINTS];
+    GAINSCHED_Source source;
+    const char *p = args + 1;
+    char *end;
+    uint8_t count = 0;
+
+    switch (args[0]) {
+    case 'S':
+        source = GAINSCHED_SETPOINT;
+        break;
+    case 'T':
+        source = GAINSCHED_TEMPERATURE;
+        break;
+    case 'X':
+        GAINSCHED_Disable(&gain_schedule);
+        return;
+    default:
+        return;
+    }
+
+    while (*p != '\0') {
+        if (count == GAINSCHED_MAX_POINTS) return;
+        points[count].x = strtod(p, &end);
+        if (end == p || *end != ',') return;
+        for (uint8_t i = 0; i < GAINSCHED_PARAMS; i++) {
+            p = end + 1;
+            points[count].value[i] = strtod(p, &end);
+            if (end == p) return;
+            if (i + 1u < GAINSCHED_PARAMS && *end != ',') return;
+        }
+        count++;
+        if (*end == ';') {
+            end++;
+        }
+        else if (*end != '\0') {
+            return;
+        }
+        p = end;
+    }
+    GAINSCHED_Load(&gain_schedule, source, points, count);
+}
+
+/**
+ * @brief Wykonuje polecenia rejestratora ("SA", "ST", "SX").
+ */
+static void cmd_scope(const char *args)
+{
+    char *end;
+    uint32_t pre, post;
+    SCOPE_TriggerMode mode;
+    float level;
+
+    switch (args[0]) {
+    case 'A':
+        pre = strtoul(args + 1, &end, 10);
+        if (*end != ',') return;
+        post = strtoul(end + 1, &end, 10);
+        if (*end != ',') return;
+        mode = (SCOPE_TriggerMode)strtoul(end + 1, &end, 10);
+        if (*end != ',') return;
+        level = strtof(end + 1, &end);
+        // Blok binarny musi w całości trafić do łącza, które uzbroiło rejestrator - polecenia
+        // z innych łączy w trakcie zrzutu nie zmieniają adresata
+        if (SCOPE_Arm(pre, post, mode, level) == HAL_OK) {
+            cmd_dump_link = cmd_reply_link;
+            cmd_udp_dump_ip = cmd_udp_reply_ip;
+            cmd_udp_dump_port = cmd_udp_reply_port;
+        }
+        break;
+    case 'T':
+        SCOPE_Trigger();
+        break;
+    case 'X':
+        SCOPE_Abort();
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Wysyła krótką odpowiedź tekstową.
+ */
+static void cmd_reply(const char *text)
+{
+    CMD_Write((const uint8_t*)text, (uint16_t)strlen(text));
+}
+
+/**
+ * @brief Ustawia prędkość transmisji i wznawia odbiór poleceń.
+ */
+static HAL_StatusTypeDef cmd_set_baud(uint32_t baud)
+{
+    HAL_StatusTypeDef status = USART_ChangeBaudRate(cmd_huart, baud);
+
+    cmd_rx_len[CMD_LINK_UART] = 0;
+    HAL_UART_Receive_IT(cmd_huart, &cmd_rx_byte, 1);
+    return status;
+}
+
+/**
+ * @brief Wykonuje polecenia zmiany prędkości ("B<prędkość>", "BP").
+ *
+ * Odpowiedź na "B<prędkość>" wysyłana jest jeszcze z dotychczasową prędkością, po czym
+ * następuje przełączenie. Nowa prędkość zostaje zatwierdzona dopiero po odebraniu próbki
+ * "BP" w ciągu CMD_BAUD_PROBE_TIMEOUT ms; w przeciwnym razie następuje powrót do poprzedniej.
+ */
+static void cmd_baud(const char *args)
+{
+    char reply[32];
+    char *end;
+    uint32_t baud;
+
+    // Prędkość dotyczy tylko UART - dla USB i UDP nie ma znaczenia
+    if (cmd_reply_link != CMD_LINK_UART) {
+        cmd_reply("B ERR\n");
+        return;
+    }
+
+    if (args[0] == 'P') {
+        // Próbka odebrana poprawnie - nowa prędkość obowiązuje
+        cmd_baud_pending = 0;
+        snprintf(reply, sizeof(reply), "BP %lu\n", (unsigned long)cmd_huart->Init.BaudRate);
+        cmd_reply(reply);
+        return;
+    }
+
+    baud = strtoul(args, &end, 10);
+    if (end == args || cmd_baud_pending || USART_CheckBaudRate(cmd_huart, baud) != HAL_OK) {
+        snprintf(reply, sizeof(reply), "B%lu ERR\n", (unsigned long)baud);
+        cmd_reply(reply);
+        return;
+    }
+
+    snprintf(reply, sizeof(reply), "B%lu OK\n", (unsigned long)baud);
+    cmd_reply(reply);
+
+    // Odpowiedź wysyłana jest blokująco, więc nadajnik jest już wolny
+    cmd_baud_previous = cmd_huart->Init.BaudRate;
+    if (cmd_set_baud(baud) != HAL_OK) {
+        cmd_set_baud(cmd_baud_previous);
+        return;
+    }
+    cmd_baud_switch_tick = HAL_GetTick();
+    cmd_baud_pending = 1;
+}
+
+/**
+ * @brief Wysyła raport stanu sieci ("N").
+ */
+static void cmd_net_status(void)
+{
+    char reply[128];
+    const NET_Config *config = NET_GetConfig();
+    const NET_Stats *stats = NET_GetStats();
+
+    ETH_Pool_Stats pool;
+
+    ETH_Pool_GetStats(&pool);
+    snprintf(reply, sizeof(reply), "N %lu.%lu.%lu.%lu %s %08lX rx %lu/%lu tx %lu/%lu arp %lu pool %lu/%lu/%lu\n",
+             (unsigned long)(config->ip >> 24), (unsigned long)((config->ip >> 16) & 0xFFu),
+             (unsigned long)((config->ip >> 8) & 0xFFu), (unsigned long)(config->ip & 0xFFu),
+             ETH_IsLinkUp() ? "UP" : "DOWN", (unsigned long)ETH_DeviceId(),
+             (unsigned long)stats->rx_frames, (unsigned long)stats->rx_dropped,
+             (unsigned long)stats->tx_frames, (unsigned long)stats->tx_dropped,
+             (unsigned long)stats->arp_misses, (unsigned long)pool.free,
+             (unsigned long)pool.min_free, (unsigned long)pool.failures);
+    cmd_reply(reply);
+}
+
+/**
+ * @brief Wykonuje odebrane polecenie, jeżeli jest dostępne. Wywoływana w pętli głównej.
+ */
+void CMD_Process(void)
+{
+    char *end;
+    double value;
+
+    // Brak potwierdzenia nowej prędkości - powrót do poprzedniej
+    if (cmd_baud_pending && HAL_GetTick() - cmd_baud_switch_tick > CMD_BAUD_PROBE_TIMEOUT) {
+        cmd_baud_pending = 0;
+        cmd_set_baud(cmd_baud_previous);
+    }
+
+    if (!cmd_line_ready) {
+        return;
+    }
+    cmd_reply_link = cmd_line_link;
+    if (cmd_reply_link == CMD_LINK_UDP) {
+        cmd_udp_reply_ip = cmd_udp_line_ip;
+        cmd_udp_reply_port = cmd_udp_line_port;
+    }
+
+    switch (cmd_line[0]) {
+    case 'Z':
+        value = strtod(&cmd_line[1], &end);
+        if (end != &cmd_line[1]) {
+            *cmd_setpoint = value;
+        }
+        break;
+    case 'S':
+        cmd_scope(&cmd_line[1]);
+        break;
+    case 'A': {
+        char line[96];
+        int len;
+        if (cmd_line[1] == 'X') {
+            AUTOTUNE_Abort(&autotune);
+        }
+        else if (cmd_line[1] >= '0' && cmd_line[1] < (char)('0' + AUTOTUNE_RULES)) {
+            // Harmonogram nadpisałby wyznaczone nastawy, a sprzężenie w przód przesuwa zakres
+            // wyjścia PID - oba wyłączane przed startem
+            if (!AUTOTUNE_IsActive(&autotune)) {
+                GAINSCHED_Disable(&gain_schedule);
+                FF_Enable(&feedforward, 0);
+            }
+            AUTOTUNE_Start(&autotune, (AUTOTUNE_Rule)(cmd_line[1] - '0'));
+        }
+        len = AUTOTUNE_Format(&autotune, line, sizeof(line));
+        CMD_Write((const uint8_t*)line, (uint16_t)len);
+        break;
+    }
+    case 'F': {
+        char line[80];
+        int len;
+        // Sprzężenie przesuwa zakres wyjścia PID, na którym opiera się przekaźnik strojenia
+        if (cmd_line[1] == '0' || (cmd_line[1] == '1' && !AUTOTUNE_IsActive(&autotune))) {
+            FF_Enable(&feedforward, (uint8_t)(cmd_line[1] - '0'));
+        }
+        else if (cmd_line[1] == 'R') {
+            FF_Reset(&feedforward);
+        }
+        len = FF_Format(&feedforward, line, sizeof(line));
+        CMD_Write((const uint8_t*)line, (uint16_t)len);
+        break;
+    }
+    case 'G': {
+        char report[512];
+        int len;
+        if (cmd_line[1] != '\0') {
+            cmd_gain_schedule(&cmd_line[1]);
+        }
+        len = GAINSCHED_Format(&gain_schedule, report, sizeof(report));
+        CMD_Write((const uint8_t*)report, (uint16_t)len);
+        break;
+    }
+    case 'H': {
+        char line[96];
+        int len = HEALTH_Format(&sensor_health, line, sizeof(line));
+        CMD_Write((const uint8_t*)line, (uint16_t)len);
+        break;
+    }
+    case 'P': {
+        char line[64];
+        int len;
+        if (cmd_line[1] == 'A') {
+            SAMPLING_Pin(&sampling_policy, -1);
+        }
+        else if (cmd_line[1] >= '0' && cmd_line[1] < (char)('0' + SAMPLING_LEVELS)) {
+            SAMPLING_Pin(&sampling_policy, (int8_t)(cmd_line[1] - '0'));
+        }
+        len = SAMPLING_Format(&sampling_policy, line, sizeof(line));
+        CMD_Write((const uint8_t*)line, (uint16_t)len);
+        break;
+    }
+    case 'L': {
+        char report[448];
+        int len;
+        if (cmd_line[1] == 'R') {
+            LATENCY_Init();
+        }
+        len = LATENCY_Format(report, sizeof(report));
+        CMD_Write((const uint8_t*)report, (uint16_t)len);
+        break;
+    }
+    case 'I': {
+        char line[64];
+        int len = IDLE_Format(line, sizeof(line));
+        CMD_Write((const uint8_t*)line, (uint16_t)len);
+        break;
+    }
+    case 'B':
+        cmd_baud(&cmd_line[1]);
+        break;
+    case 'N':
+        cmd_net_status();
+        break;
+    default:
+        break;
+    }
+
+    cmd_line_ready = 0;
+}
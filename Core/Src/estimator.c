@@ -0,0 +1,85 @@
+#include "estimator.h"
+#include <math.h>
+
+/**
+ * @file estimator.c
+ * @brief Implementacja estymatora stanu typu alfa-beta.
+ */
+
+/**
+ * @brief Inicjalizuje estymator ze wzmocnieniami podanymi wprost.
+ *
+ * @param est Wskaźnik do struktury estymatora.
+ * @param alpha Wzmocnienie korekcji położenia (0-1).
+ * @param beta Wzmocnienie korekcji prędkości (0-2).
+ * @param dt Okres próbkowania w sekundach.
+ */
+void ESTIMATOR_Init(ESTIMATOR *est, float alpha, float beta, float dt)
+{
+    est->x = 0.0f;
+    est->v = 0.0f;
+    est->alpha = alpha;
+    est->beta = beta;
+    est->dt = dt;
+    est->initialized = 0;
+}
+
+/**
+ * @brief Inicjalizuje estymator wzmocnieniami ustalonego filtru Kalmana.
+ *
+ * Wzmocnienia wyznaczane są z indeksu śledzenia lambda = sigma_w * dt^2 / sigma_v.
+ *
+ * @param est Wskaźnik do struktury estymatora.
+ * @param process_noise Odchylenie standardowe przyspieszenia zmian temperatury [°C/s^2].
+ * @param meas_noise Odchylenie standardowe szumu pomiaru [°C].
+ * @param dt Okres próbkowania w sekundach.
+ */
+void ESTIMATOR_InitFromNoise(ESTIMATOR *est, float process_noise, float meas_noise, float dt)
+{
+    float lambda = process_noise * dt * dt / meas_noise;
+    float r = sqrtf(lambda * lambda + 8.0f * lambda);
+    float alpha = -(lambda * lambda + 8.0f * lambda - (lambda + 4.0f) * r) / 8.0f;
+    float beta = (lambda * lambda + 4.0f * lambda - lambda * r) / 4.0f;
+
+    ESTIMATOR_Init(est, alpha, beta, dt);
+}
+
+/**
+ * @brief Aktualizuje estymatę nowym pomiarem.
+ *
+ * @param est Wskaźnik do struktury estymatora.
+ * @param measurement Zmierzona temperatura [°C].
+ * @return Estymata temperatury po korekcji [°C].
+ */
+float ESTIMATOR_Update(ESTIMATOR *est, float measurement)
+{
+    // Pierwszy pomiar przyjmujemy wprost, aby uniknąć stanu przejściowego od zera
+    if (!est->initialized) {
+        est->x = measurement;
+        est->v = 0.0f;
+        est->initialized = 1;
+        return est->x;
+    }
+
+    // Predykcja
+    est->x += est->v * est->dt;
+
+    // Korekcja na podstawie residuum
+    float residual = measurement - est->x;
+    est->x += est->alpha * residual;
+    est->v += (est->beta / est->dt) * residual;
+
+    return est->x;
+}
+
+/**
+ * @brief Wykonuje tylko krok predykcji (brak pomiaru w bieżącym takcie).
+ *
+ * @param est Wskaźnik do struktury estymatora.
+ * @return Przewidywana temperatura [°C].
+ */
+float ESTIMATOR_Predict(ESTIMATOR *est)
+{
+    est->x += est->v * est->dt;
+    return est->x;
+}
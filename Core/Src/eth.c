@@ -43,6 +43,24 @@ ETH_BufferTypeDef Txbuffer[ETH_TX_DESC_CNT * 2U];
 ETH_TxPacketConfig TxConfig;
 
 /* USER CODE BEGIN 0 */
+#include "idle.h"
+
+/* Rejestry układu PHY LAN8742A */
+#define ETH_PHY_BSR             0x01u       /* Basic Status Register */
+#define ETH_PHY_BSR_LINK        0x0004u
+#define ETH_PHY_SCSR            0x1Fu       /* PHY Special Control/Status Register */
+#define ETH_PHY_SCSR_AUTODONE   0x1000u
+#define ETH_PHY_SCSR_100M       0x0008u
+#define ETH_PHY_SCSR_FULLDUPLEX 0x0010u
+
+/* Deskryptory odbiorcze i nadawcze pobierają bufory z jednej puli (eth_pool.c): bufor odebranej
+   ramki trafia do stosu bez kopiowania i może zostać wysłany jako odpowiedź, a bufor nadawczy
+   wraca do puli w HAL_ETH_TxFreeCallback po zakończeniu transmisji. */
+static uint16_t eth_rx_len;
+
+static NET_Mac eth_net_mac;
+static uint8_t eth_link_up = 0;
+static uint32_t eth_link_tick;
 
 /* USER CODE END 0 */
 
@@ -75,7 +93,10 @@ void MX_ETH_Init(void)
   heth.Init.RxBuffLen = 1524;
 
   /* USER CODE BEGIN MACADDRESS */
-
+  // Adres unikalny dla każdego układu, aby kilka sterowników mogło pracować w jednej sieci
+  MACAddr[3] = (uint8_t)(ETH_DeviceId() >> 16);
+  MACAddr[4] = (uint8_t)(ETH_DeviceId() >> 8);
+  MACAddr[5] = (uint8_t)ETH_DeviceId();
   /* USER CODE END MACADDRESS */
 
   if (HAL_ETH_Init(&heth) != HAL_OK)
@@ -149,6 +170,9 @@ void HAL_ETH_MspInit(ETH_HandleTypeDef* ethHandle)
     HAL_GPIO_Init(GPIOG, &GPIO_InitStruct);
 
   /* USER CODE BEGIN ETH_MspInit 1 */
+    /* ETH interrupt Init (received frame wakes the main loop from idle) */
+    HAL_NVIC_SetPriority(ETH_IRQn, IRQ_PRIO_ETH, 0);
+    HAL_NVIC_EnableIRQ(ETH_IRQn);
 
   /* USER CODE END ETH_MspInit 1 */
   }
@@ -185,6 +209,8 @@ void HAL_ETH_MspDeInit(ETH_HandleTypeDef* ethHandle)
     HAL_GPIO_DeInit(GPIOG, RMII_TX_EN_Pin|RMII_TXD0_Pin);
 
   /* USER CODE BEGIN ETH_MspDeInit 1 */
+    /* ETH interrupt Deinit */
+    HAL_NVIC_DisableIRQ(ETH_IRQn);
 
   /* USER CODE END ETH_MspDeInit 1 */
   }
@@ -192,4 +218,208 @@ void HAL_ETH_MspDeInit(ETH_HandleTypeDef* ethHandle)
 
 /* USER CODE BEGIN 1 */
 
+/**
+ * @brief Zwraca identyfikator urządzenia wyznaczony z numeru seryjnego układu.
+ */
+uint32_t ETH_DeviceId(void)
+{
+  return HAL_GetUIDw0() ^ HAL_GetUIDw1() ^ HAL_GetUIDw2();
+}
+
+/**
+ * @brief Przydziela bufor odbiorczy deskryptorowi. Wywoływana przez HAL.
+ *
+ * Przy pustej puli deskryptor pozostaje bez bufora - HAL ponawia przydział przy kolejnym
+ * HAL_ETH_ReadData.
+ */
+void HAL_ETH_RxAllocateCallback(uint8_t **buff)
+{
+  *buff = ETH_Pool_Alloc();
+}
+
+/**
+ * @brief Składa ramkę z buforów deskryptorów. Wywoływana przez HAL.
+ *
+ * Bufor (ETH_RX_BUF_SIZE) mieści całą ramkę, więc ramka zawsze zajmuje jeden deskryptor.
+ */
+void HAL_ETH_RxLinkCallback(void **pStart, void **pEnd, uint8_t *buff, uint16_t Length)
+{
+  if (*pStart == NULL)
+  {
+    *pStart = buff;
+    eth_rx_len = Length;
+  }
+  else
+  {
+    // Nie powinno wystąpić; drugi bufor nie należy do ramki przekazywanej do stosu
+    ETH_Pool_Free(buff);
+  }
+  *pEnd = buff;
+  ETH_Pool_InvalidateFromDma(buff, Length);
+}
+
+/**
+ * @brief Odebrano ramkę - pętla główna nie może zasnąć przed jej odbiorem. Wywoływana z przerwania ETH.
+ */
+void HAL_ETH_RxCpltCallback(ETH_HandleTypeDef *heth)
+{
+  UNUSED(heth);
+  IDLE_Wake();
+}
+
+/**
+ * @brief Zwraca do puli bufor wysłanej ramki. Wywoływana przez HAL_ETH_ReleaseTxPacket.
+ */
+void HAL_ETH_TxFreeCallback(uint32_t *buff)
+{
+  ETH_Pool_Free((uint8_t*)buff);
+}
+
+static uint8_t *eth_tx_alloc(void *ctx)
+{
+  (void)ctx;
+  return eth_link_up ? ETH_Pool_Alloc() : NULL;
+}
+
+static void eth_tx_release(void *ctx, uint8_t *frame)
+{
+  (void)ctx;
+  ETH_Pool_Free(frame);
+}
+
+/**
+ * @brief Przekazuje ramkę do DMA bez oczekiwania na koniec transmisji.
+ */
+static NET_Status eth_tx_send(void *ctx, uint8_t *frame, uint16_t len)
+{
+  (void)ctx;
+
+  // Odzyskanie deskryptorów i buforów ramek już wysłanych
+  HAL_ETH_ReleaseTxPacket(&heth);
+
+  ETH_Pool_CleanForDma(frame, len);
+  Txbuffer[0].buffer = frame;
+  Txbuffer[0].len = len;
+  Txbuffer[0].next = NULL;
+  TxConfig.Length = len;
+  TxConfig.TxBuffer = &Txbuffer[0];
+  TxConfig.pData = frame;
+
+  if (HAL_ETH_Transmit_IT(&heth, &TxConfig) != HAL_OK)
+  {
+    ETH_Pool_Free(frame);
+    return NET_BUSY;
+  }
+  return NET_OK;
+}
+
+/**
+ * @brief Uruchamia kontroler po wykryciu łącza (z prędkością i trybem z autonegocjacji PHY)
+ *        i zatrzymuje go po utracie łącza.
+ */
+static void eth_link_update(void)
+{
+  uint32_t bsr, scsr;
+  ETH_MACConfigTypeDef mac_config;
+
+  if (HAL_ETH_ReadPHYRegister(&heth, ETH_PHY_ADDRESS, ETH_PHY_BSR, &bsr) != HAL_OK)
+  {
+    return;
+  }
+
+  if ((bsr & ETH_PHY_BSR_LINK) == 0u)
+  {
+    if (eth_link_up)
+    {
+      HAL_ETH_Stop_IT(&heth);
+      eth_link_up = 0;
+    }
+    return;
+  }
+
+  if (eth_link_up)
+  {
+    return;
+  }
+
+  if (HAL_ETH_ReadPHYRegister(&heth, ETH_PHY_ADDRESS, ETH_PHY_SCSR, &scsr) != HAL_OK
+      || (scsr & ETH_PHY_SCSR_AUTODONE) == 0u)
+  {
+    return;
+  }
+
+  HAL_ETH_GetMACConfig(&heth, &mac_config);
+  mac_config.Speed = (scsr & ETH_PHY_SCSR_100M) ? ETH_SPEED_100M : ETH_SPEED_10M;
+  mac_config.DuplexMode = (scsr & ETH_PHY_SCSR_FULLDUPLEX) ? ETH_FULLDUPLEX_MODE : ETH_HALFDUPLEX_MODE;
+  HAL_ETH_SetMACConfig(&heth, &mac_config);
+
+  // Przerwanie odbioru tylko budzi pętlę główną; ramki odbierane są w ETH_Poll
+  if (HAL_ETH_Start_IT(&heth) == HAL_OK)
+  {
+    eth_link_up = 1;
+  }
+}
+
+/**
+ * @brief Inicjalizuje stos sieciowy na kontrolerze ETH. Wywoływana po MX_ETH_Init.
+ */
+void ETH_NetInit(void)
+{
+  NET_Config config;
+
+  ETH_Pool_Init();
+  memcpy(eth_net_mac.addr, heth.Init.MACAddr, 6);
+  eth_net_mac.tx_alloc = eth_tx_alloc;
+  eth_net_mac.tx_send = eth_tx_send;
+  eth_net_mac.tx_release = eth_tx_release;
+  eth_net_mac.ctx = &heth;
+  // TxConfig zleca sprzętowe wstawianie sum kontrolnych IP/UDP/ICMP
+  eth_net_mac.checksum_offload = 1;
+
+  config.ip = ETH_IP_NETWORK | (ETH_IP_HOST_FIRST + ETH_DeviceId() % ETH_IP_HOST_COUNT);
+  config.netmask = ETH_IP_NETMASK;
+  config.gateway = ETH_IP_GATEWAY;
+  NET_Init(&eth_net_mac, &config);
+
+  // Pierwsze sprawdzenie łącza przy najbliższym ETH_Poll
+  eth_link_tick = HAL_GetTick() - ETH_LINK_POLL_PERIOD;
+}
+
+/**
+ * @brief Sprawdza stan łącza i przekazuje odebrane ramki do stosu. Wywoływana w pętli głównej.
+ */
+void ETH_Poll(void)
+{
+  void *frame;
+
+  if (HAL_GetTick() - eth_link_tick >= ETH_LINK_POLL_PERIOD)
+  {
+    eth_link_tick = HAL_GetTick();
+    eth_link_update();
+  }
+
+  if (!eth_link_up)
+  {
+    return;
+  }
+
+  HAL_ETH_ReleaseTxPacket(&heth);
+  while (HAL_ETH_ReadData(&heth, &frame) == HAL_OK)
+  {
+    // Bufor wysłany przez stos jako odpowiedź wróci do puli po transmisji
+    if (!NET_Input((uint8_t*)frame, eth_rx_len))
+    {
+      ETH_Pool_Free((uint8_t*)frame);
+    }
+  }
+}
+
+/**
+ * @brief Czy łącze jest aktywne i kontroler uruchomiony.
+ */
+uint8_t ETH_IsLinkUp(void)
+{
+  return eth_link_up;
+}
+
 /* USER CODE END 1 */
@@ -0,0 +1,117 @@
+#include "eth_pool.h"
+
+/**
+ * @file eth_pool.c
+ * @brief Implementacja puli buforów ramek Ethernet.
+ *
+ * Wolne bufory oznaczone są bitami maski; przydział i zwolnienie wykonywane są przy
+ * wyłączonych przerwaniach, ponieważ bufory nadawcze mogą wracać do puli z przerwania ETH.
+ */
+
+static uint8_t eth_pool[ETH_POOL_COUNT][ETH_POOL_BUF_SIZE]
+    __attribute__((section(".EthBufferSection"), aligned(ETH_POOL_CACHE_LINE)));
+
+static uint32_t eth_pool_free_mask;
+static uint32_t eth_pool_min_free;
+static uint32_t eth_pool_failures;
+
+/**
+ * @brief Liczba ustawionych bitów maski.
+ */
+static uint32_t eth_pool_count(uint32_t mask)
+{
+    uint32_t n = 0;
+
+    while (mask) {
+        mask &= mask - 1u;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Oznacza wszystkie bufory jako wolne.
+ */
+void ETH_Pool_Init(void)
+{
+    eth_pool_free_mask = (ETH_POOL_COUNT >= 32u) ? 0xFFFFFFFFu : ((1u << ETH_POOL_COUNT) - 1u);
+    eth_pool_min_free = ETH_POOL_COUNT;
+    eth_pool_failures = 0;
+}
+
+/**
+ * @brief Przydziela bufor.
+ *
+ * @return Bufor o rozmiarze ETH_POOL_BUF_SIZE lub NULL, gdy pula jest pusta.
+ */
+uint8_t *ETH_Pool_Alloc(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t idx, free_count;
+
+    __disable_irq();
+    if (eth_pool_free_mask == 0u) {
+        eth_pool_failures++;
+        __set_PRIMASK(primask);
+        return NULL;
+    }
+    idx = __CLZ(__RBIT(eth_pool_free_mask));
+    eth_pool_free_mask &= ~(1u << idx);
+    free_count = eth_pool_count(eth_pool_free_mask);
+    if (free_count < eth_pool_min_free) {
+        eth_pool_min_free = free_count;
+    }
+    __set_PRIMASK(primask);
+
+    return eth_pool[idx];
+}
+
+/**
+ * @brief Zwraca bufor do puli. Można wywoływać z przerwania.
+ *
+ * @param buf Bufor z ETH_Pool_Alloc (wskaźniki spoza puli są ignorowane).
+ */
+void ETH_Pool_Free(uint8_t *buf)
+{
+    uint32_t offset = (uint32_t)(buf - &eth_pool[0][0]);
+    uint32_t primask;
+
+    if (buf < &eth_pool[0][0] || offset >= sizeof(eth_pool) || offset % ETH_POOL_BUF_SIZE != 0u) {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    eth_pool_free_mask |= 1u << (offset / ETH_POOL_BUF_SIZE);
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Zapisuje zawartość bufora z pamięci podręcznej do SRAM przed odczytem przez DMA.
+ */
+void ETH_Pool_CleanForDma(const uint8_t *buf, uint32_t len)
+{
+    if (SCB->CCR & SCB_CCR_DC_Msk) {
+        SCB_CleanDCache_by_Addr((uint32_t*)buf, (int32_t)len);
+    }
+}
+
+/**
+ * @brief Unieważnia pamięć podręczną bufora po zapisie przez DMA.
+ */
+void ETH_Pool_InvalidateFromDma(const uint8_t *buf, uint32_t len)
+{
+    if (SCB->CCR & SCB_CCR_DC_Msk) {
+        SCB_InvalidateDCache_by_Addr((uint32_t*)buf, (int32_t)len);
+    }
+}
+
+/**
+ * @brief Zwraca liczniki puli.
+ */
+void ETH_Pool_GetStats(ETH_Pool_Stats *stats)
+{
+    stats->free = eth_pool_count(eth_pool_free_mask);
+    stats->min_free = eth_pool_min_free;
+    stats->failures = eth_pool_failures;
+}
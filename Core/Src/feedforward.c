@@ -0,0 +1,223 @@
+#include "feedforward.h"
+#include <math.h>
+#include <stdio.h>
+
+/**
+ * @file feedforward.c
+ * @brief Implementacja sprzężenia w przód z modelem strat uczonym metodą RLS.
+ */
+
+FF feedforward;
+
+/**
+ * @brief Zeruje model i kowariancję.
+ */
+static void ff_reset_model(FF *ff)
+{
+    ff->a = 0.0;
+    ff->b = 0.0;
+    ff->p00 = FF_P_INIT_OFFSET;
+    ff->p01 = 0.0;
+    ff->p11 = FF_P_INIT_SLOPE;
+    ff->updates = 0;
+    ff->steady_ticks = 0;
+    ff->sum_output = 0.0;
+    ff->sum_temperature = 0.0;
+}
+
+/**
+ * @brief Przenosi zmianę składowej sprzężenia do integratora (wyjście bez skoku).
+ *
+ * @param delta Przyrost składowej dodawanej do wyjścia.
+ */
+static void ff_compensate(FF *ff, double delta)
+{
+    PID *pid = ff->pid;
+
+    // Między obliczeniami PID zwraca zapamiętane wyjście - ono też bez u_ff
+    pid->prev_output -= delta;
+    if (pid->Ki != 0.0) {
+        pid->integral -= delta / pid->Ki;
+        if (pid->integral > pid->integral_max) {
+            pid->integral = pid->integral_max;
+        } else if (pid->integral < pid->integral_min) {
+            pid->integral = pid->integral_min;
+        }
+    }
+}
+
+/**
+ * @brief Wypełnienie ustalone dla temperatury według modelu, w zakresie wyjścia.
+ */
+static double ff_predict(const FF *ff, double temperature)
+{
+    double u = ff->a + ff->b * (temperature - FF_T_REF);
+
+    return fmin(fmax(u, ff->output_min), ff->output_max);
+}
+
+/**
+ * @brief Krok RLS dla próbki (średnia temperatura, średnie wyjście).
+ */
+static void ff_rls_update(FF *ff, double temperature, double output)
+{
+    double x = temperature - FF_T_REF;
+    // P * phi dla phi = [1, x]
+    double g0 = ff->p00 + ff->p01 * x;
+    double g1 = ff->p01 + ff->p11 * x;
+    double denom = FF_FORGETTING + g0 + g1 * x;
+    double error = output - (ff->a + ff->b * x);
+    double k0 = g0 / denom;
+    double k1 = g1 / denom;
+    double lambda;
+
+    ff->a += k0 * error;
+    ff->b += k1 * error;
+
+    // P = (P - k * phi^T * P) / lambda; bez zapominania, gdy kierunek nie jest pobudzany
+    ff->p00 -= k0 * g0;
+    ff->p01 -= k0 * g1;
+    ff->p11 -= k1 * g1;
+    lambda = (ff->p00 + ff->p11 < FF_P_MAX) ? FF_FORGETTING : 1.0;
+    ff->p00 /= lambda;
+    ff->p01 /= lambda;
+    ff->p11 /= lambda;
+
+    ff->updates++;
+}
+
+/**
+ * @brief Inicjalizuje sprzężenie (wyłączone, model pusty).
+ *
+ * @param ff Wskaźnik do struktury sprzężenia.
+ * @param pid Regulator; zapamiętywany jest jego zakres wyjścia.
+ */
+void FF_Init(FF *ff, PID *pid)
+{
+    ff->pid = pid;
+    ff->output_min = pid->output_min;
+    ff->output_max = pid->output_max;
+    ff->enable_request = 0;
+    ff->reset_request = 0;
+    ff->enabled = 0;
+    ff->term = 0.0;
+    ff->setpoint = pid->setpoint;
+    ff_reset_model(ff);
+}
+
+/**
+ * @brief Włącza lub wyłącza sprzężenie (wykonywane w najbliższym FF_Apply).
+ *
+ * @param ff Wskaźnik do struktury sprzężenia.
+ * @param enable 1 - włączenie, 0 - wyłączenie.
+ */
+void FF_Enable(FF *ff, uint8_t enable)
+{
+    ff->enable_request = enable ? 1u : 0u;
+}
+
+/**
+ * @brief Zgłasza wyzerowanie modelu (wykonywane w najbliższym FF_Apply).
+ *
+ * @param ff Wskaźnik do struktury sprzężenia.
+ */
+void FF_Reset(FF *ff)
+{
+    ff->reset_request = 1;
+}
+
+/**
+ * @brief Wyznacza składową u_ff i przesuwa zakres wyjścia PID.
+ *
+ * @param ff Wskaźnik do struktury sprzężenia.
+ * @return Składowa sprzężenia w przód (0, gdy wyłączone).
+ */
+double FF_Apply(FF *ff)
+{
+    PID *pid = ff->pid;
+    uint8_t enabled;
+    double term;
+
+    if (ff->reset_request) {
+        ff->reset_request = 0;
+        ff_reset_model(ff);
+    }
+
+    // Składowa działa dopiero po pierwszej próbce modelu
+    enabled = (ff->enable_request && ff->updates > 0u);
+    term = enabled ? ff_predict(ff, pid->setpoint) : 0.0;
+
+    // Granice integratora: przy włączonym sprzężeniu cały zakres wypełnienia pomniejszony o u_ff
+    // (integrator koryguje model w obie strony), po wyłączeniu granice sprzed włączenia
+    if (enabled && !ff->enabled) {
+        ff->saved_integral_min = pid->integral_min;
+        ff->saved_integral_max = pid->integral_max;
+    }
+    else if (!enabled && ff->enabled) {
+        pid->integral_min = ff->saved_integral_min;
+        pid->integral_max = ff->saved_integral_max;
+    }
+    if (enabled && pid->Ki > 0.0) {
+        pid->integral_min = (ff->output_min - term) / pid->Ki;
+        pid->integral_max = (ff->output_max - term) / pid->Ki;
+    }
+    ff->enabled = enabled;
+
+    // Zmiana bez zmiany zadanej (włączenie, wyłączenie, nowa próbka) przechodzi do integratora
+    if (term != ff->term && pid->setpoint == ff->setpoint) {
+        ff_compensate(ff, term - ff->term);
+    }
+    ff->term = term;
+    ff->setpoint = pid->setpoint;
+
+    // Suma PID + u_ff w zakresie wypełnienia
+    pid->output_min = ff->output_min - term;
+    pid->output_max = ff->output_max - term;
+
+    return term;
+}
+
+/**
+ * @brief Uczy model na podstawie bieżącego taktu.
+ *
+ * @param ff Wskaźnik do struktury sprzężenia.
+ * @param temperature Estymata temperatury [°C].
+ * @param rate Estymata szybkości zmian temperatury [°C/s].
+ * @param output Wyjście podane na grzałkę (PID + u_ff).
+ */
+void FF_Learn(FF *ff, double temperature, double rate, double output)
+{
+    // Bilans cieplny nie wymaga zerowego uchybu - wystarczy stała temperatura
+    if (fabs(rate) > FF_STEADY_RATE || output <= ff->output_min || output >= ff->output_max) {
+        ff->steady_ticks = 0;
+        ff->sum_output = 0.0;
+        ff->sum_temperature = 0.0;
+        return;
+    }
+
+    ff->sum_output += output;
+    ff->sum_temperature += temperature;
+    if (++ff->steady_ticks >= FF_STEADY_TICKS) {
+        ff_rls_update(ff, ff->sum_temperature / ff->steady_ticks, ff->sum_output / ff->steady_ticks);
+        ff->steady_ticks = 0;
+        ff->sum_output = 0.0;
+        ff->sum_temperature = 0.0;
+    }
+}
+
+/**
+ * @brief Zapisuje stan sprzężenia w postaci jednej linii tekstu.
+ *
+ * @param ff Wskaźnik do struktury sprzężenia.
+ * @param line Bufor na linię.
+ * @param size Rozmiar bufora.
+ * @return Długość linii (bez znaku końca napisu).
+ */
+int FF_Format(const FF *ff, char *line, size_t size)
+{
+    int len = snprintf(line, size, "F%u %lu %.4g %.4g %.3f %.3g %.3g\n",
+                       (unsigned)ff->enabled, (unsigned long)ff->updates, ff->a, ff->b, ff->term,
+                       ff->p00, ff->p11);
+
+    return (len < (int)size) ? len : (int)size - 1;
+}
@@ -0,0 +1,176 @@
+#include "gain_schedule.h"
+#include <stdio.h>
+
+/**
+ * @file gain_schedule.c
+ * @brief Implementacja harmonogramu nastaw PID.
+ */
+
+GAINSCHED gain_schedule;
+
+/**
+ * @brief Inicjalizuje harmonogram (wyłączony, nastawy regulatora bez zmian).
+ *
+ * @param gs Wskaźnik do struktury harmonogramu.
+ */
+void GAINSCHED_Init(GAINSCHED *gs)
+{
+    gs->table[0].count = 0;
+    gs->table[1].count = 0;
+    gs->active = 0;
+    gs->segment = 0;
+    gs->x = 0.0;
+}
+
+/**
+ * @brief Wczytuje tablicę i włącza harmonogram. Wywoływać z pętli głównej.
+ *
+ * @param gs Wskaźnik do struktury harmonogramu.
+ * @param source Wielkość indeksująca tablicę.
+ * @param points Punkty w kolejności rosnącej temperatury.
+ * @param count Liczba punktów (1..GAINSCHED_MAX_POINTS).
+ * @return 1, jeżeli tablica jest poprawna i została przełączona.
+ */
+uint8_t GAINSCHED_Load(GAINSCHED *gs, GAINSCHED_Source source, const GAINSCHED_Point *points, uint8_t count)
+{
+    GAINSCHED_Table *t = &gs->table[gs->active ^ 1u];
+
+    if (count == 0u || count > GAINSCHED_MAX_POINTS) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        if (i > 0u && points[i].x <= points[i - 1u].x) {
+            return 0;
+        }
+        if (points[i].value[GAINSCHED_INTEGRAL_MIN] > points[i].value[GAINSCHED_INTEGRAL_MAX]) {
+            return 0;
+        }
+    }
+
+    // Nachylenia odcinków - w takcie zostaje tylko mnożenie z dodawaniem
+    for (uint8_t i = 0; i < count; i++) {
+        t->point[i] = points[i];
+        for (uint8_t p = 0; p < GAINSCHED_PARAMS; p++) {
+            t->slope[i][p] = (i + 1u < count)
+                ? (points[i + 1u].value[p] - points[i].value[p]) / (points[i + 1u].x - points[i].x)
+                : 0.0;
+        }
+    }
+    t->x_min = points[0].x;
+    t->x_max = points[count - 1u].x;
+    t->last_segment = (count > 1u) ? (uint8_t)(count - 2u) : 0u;
+    t->source = source;
+    t->count = count;
+
+    // Przerwanie regulatora ma wyższy priorytet niż pętla główna - przełączenie jednym zapisem
+    gs->segment = 0;
+    gs->active ^= 1u;
+    return 1;
+}
+
+/**
+ * @brief Wyłącza harmonogram; regulator zachowuje ostatnio ustawione nastawy.
+ *
+ * @param gs Wskaźnik do struktury harmonogramu.
+ */
+void GAINSCHED_Disable(GAINSCHED *gs)
+{
+    gs->table[gs->active].count = 0;
+}
+
+/**
+ * @brief Ustawia nastawy regulatora dla bieżącej temperatury.
+ *
+ * @param gs Wskaźnik do struktury harmonogramu.
+ * @param pid Regulator.
+ * @param temperature Estymata temperatury [°C] (używana dla GAINSCHED_TEMPERATURE).
+ * @param apply_limits 0 - granice integratora ustala inny moduł (sprzężenie w przód).
+ */
+void GAINSCHED_Apply(GAINSCHED *gs, PID *pid, double temperature, uint8_t apply_limits)
+{
+    const GAINSCHED_Table *t = &gs->table[gs->active];
+    const double *value, *slope;
+    uint8_t seg = gs->segment;
+    double x, dx, Ki;
+
+    if (t->count == 0u) {
+        return;
+    }
+
+    x = (t->source == GAINSCHED_SETPOINT) ? pid->setpoint : temperature;
+    if (x < t->x_min) {
+        x = t->x_min;
+    } else if (x > t->x_max) {
+        x = t->x_max;
+    }
+    gs->x = x;
+
+    // Temperatura zmienia się wolno - zwykle odcinek z poprzedniego taktu
+    if (seg > t->last_segment) {
+        seg = t->last_segment;
+    }
+    while (seg > 0u && x < t->point[seg].x) {
+        seg--;
+    }
+    while (seg < t->last_segment && x >= t->point[seg + 1u].x) {
+        seg++;
+    }
+    gs->segment = seg;
+
+    value = t->point[seg].value;
+    slope = t->slope[seg];
+    dx = x - t->point[seg].x;
+
+    Ki = value[GAINSCHED_KI] + slope[GAINSCHED_KI] * dx;
+    // Składowa całkująca bez skoku przy zmianie Ki; bez całkowania integrator jest zerowany,
+    // aby po powrocie Ki > 0 nie wróciła stara suma
+    if (Ki == 0.0) {
+        pid->integral = 0.0;
+    } else if (Ki != pid->Ki && pid->Ki != 0.0) {
+        pid->integral *= pid->Ki / Ki;
+    }
+    pid->Ki = Ki;
+    pid->Kp = value[GAINSCHED_KP] + slope[GAINSCHED_KP] * dx;
+    pid->Kd = value[GAINSCHED_KD] + slope[GAINSCHED_KD] * dx;
+    if (!apply_limits) {
+        return;
+    }
+    pid->integral_min = value[GAINSCHED_INTEGRAL_MIN] + slope[GAINSCHED_INTEGRAL_MIN] * dx;
+    pid->integral_max = value[GAINSCHED_INTEGRAL_MAX] + slope[GAINSCHED_INTEGRAL_MAX] * dx;
+
+    // Integrator w nowych granicach już w tym takcie - PID obciąłby go dopiero przy
+    // najbliższym obliczeniu, ze skokiem wyjścia niezwiązanym ze zmianą nastaw
+    if (pid->integral > pid->integral_max) {
+        pid->integral = pid->integral_max;
+    } else if (pid->integral < pid->integral_min) {
+        pid->integral = pid->integral_min;
+    }
+}
+
+/**
+ * @brief Zapisuje harmonogram w postaci jednej linii tekstu.
+ *
+ * @param gs Wskaźnik do struktury harmonogramu.
+ * @param line Bufor na linię.
+ * @param size Rozmiar bufora.
+ * @return Długość linii (bez znaku końca napisu).
+ */
+int GAINSCHED_Format(const GAINSCHED *gs, char *line, size_t size)
+{
+    const GAINSCHED_Table *t = &gs->table[gs->active];
+    int len = snprintf(line, size, "G%c %u %u %.2f",
+                       (t->source == GAINSCHED_SETPOINT) ? 'S' : 'T',
+                       (unsigned)t->count, (unsigned)gs->segment, gs->x);
+
+    for (uint8_t i = 0; i < t->count && len < (int)size; i++) {
+        const double *v = t->point[i].value;
+        len += snprintf(line + len, size - (size_t)len, " %.2f,%.4g,%.4g,%.4g,%.4g,%.4g", t->point[i].x,
+                        v[GAINSCHED_KP], v[GAINSCHED_KI], v[GAINSCHED_KD],
+                        v[GAINSCHED_INTEGRAL_MIN], v[GAINSCHED_INTEGRAL_MAX]);
+    }
+    if (len < (int)size) {
+        len += snprintf(line + len, size - (size_t)len, "\n");
+    }
+
+    return (len < (int)size) ? len : (int)size - 1;
+}
@@ -0,0 +1,198 @@
+#include "idle.h"
+#include "utimer.h"
+#include <stdio.h>
+
+/**
+ * @file idle.c
+ * @brief Implementacja uśpienia rdzenia między taktami regulatora.
+ *
+ * Czas snu mierzony jest licznikiem TIM2 (1 MHz), bo licznik cykli DWT w trybie Sleep
+ * stoi razem z zegarem rdzenia. Sen nie przekracza okresu licznika - przepełnienie TIM2
+ * zawsze budzi rdzeń - więc różnica stanów licznika modulo okres jest jednoznaczna.
+ * WFI wykonywane jest przy ustawionym PRIMASK: przerwanie budzi rdzeń, ale jego obsługa
+ * rusza dopiero po uzupełnieniu liczników, dzięki czemu widzi już poprawny czas.
+ */
+
+static TIM_HandleTypeDef *idle_htim;
+static volatile uint8_t idle_wake_request;
+static uint32_t idle_residual_us;   /**< Część taktu HAL, której nie odliczył SysTick [us] */
+static uint32_t idle_slept_frac_us; /**< Reszta łącznego czasu snu poniżej 1 ms [us] */
+static IDLE_Stats idle_stats;
+
+/**
+ * @brief Wywołanie UTIMER budzące rdzeń w terminie pętli głównej - samo przerwanie wystarcza.
+ */
+static void idle_wakeup(void *ctx)
+{
+    UNUSED(ctx);
+}
+
+/**
+ * @brief Czas do najbliższego zdarzenia licznika taktu lub UTIMER [us].
+ */
+static uint32_t idle_next_event_us(void)
+{
+    TIM_TypeDef *tim = idle_htim->Instance;
+    uint32_t cnt = tim->CNT;
+    uint32_t next = tim->ARR + 1u - cnt;    // przepełnienie
+    uint32_t utimer;
+
+    // Kanały porównania z włączonym przerwaniem (CCR1..CCR4 to kolejne rejestry)
+    for (uint32_t ch = 0; ch < 4u; ch++) {
+        if (tim->DIER & (TIM_DIER_CC1IE << ch)) {
+            uint32_t ccr = (&tim->CCR1)[ch];
+            if (ccr > cnt && ccr - cnt < next) {
+                next = ccr - cnt;
+            }
+        }
+    }
+
+    utimer = UTIMER_NextExpiryUs();
+    return (utimer < next) ? utimer : next;
+}
+
+/**
+ * @brief Inicjalizuje uśpienia.
+ *
+ * @param htim Licznik taktu regulatora zliczający mikrosekundy (mierzy czas snu).
+ */
+void IDLE_Init(TIM_HandleTypeDef *htim)
+{
+    idle_htim = htim;
+    idle_wake_request = 0;
+    idle_residual_us = 0;
+    idle_slept_frac_us = 0;
+    idle_stats.sleeps = 0;
+    idle_stats.skipped = 0;
+    idle_stats.slept_ms = 0;
+    idle_stats.max_us = 0;
+    idle_stats.last_us = 0;
+    // Sleep, nie Stop - peryferia pracują dalej
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+}
+
+/**
+ * @brief Zgłasza pracę dla pętli głównej - najbliższe IDLE_Sleep nie uśpi rdzenia.
+ */
+void IDLE_Wake(void)
+{
+    idle_wake_request = 1;
+}
+
+/**
+ * @brief Usypia rdzeń do najbliższego zdarzenia, najdłużej na podany czas.
+ *
+ * @param max_us Termin pętli głównej [us] (UINT32_MAX - brak).
+ * @return Czas snu [us], 0 jeżeli rdzeń nie został uśpiony.
+ */
+uint32_t IDLE_Sleep(uint32_t max_us)
+{
+    TIM_TypeDef *tim;
+    uint32_t primask, next, per_us, tick_us, period;
+    uint32_t cnt0, cyc0, elapsed_us, slept_us, cycles;
+    int8_t wake_id = -1;
+
+    if (idle_htim == NULL) {
+        return 0;
+    }
+    tim = idle_htim->Instance;
+    per_us = SystemCoreClock / 1000000u;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (idle_wake_request) {
+        idle_wake_request = 0;
+        idle_stats.skipped++;
+        __set_PRIMASK(primask);
+        return 0;
+    }
+
+    next = idle_next_event_us();
+    if (max_us < IDLE_MIN_SLEEP_US || next < IDLE_MIN_SLEEP_US) {
+        idle_stats.skipped++;
+        __set_PRIMASK(primask);
+        return 0;
+    }
+    if (max_us < next) {
+        // Termin pętli wypada przed zdarzeniem licznika - pobudka wywołaniem UTIMER
+        wake_id = UTIMER_Start(max_us, idle_wakeup, NULL);
+        if (wake_id < 0) {
+            idle_stats.skipped++;
+            __set_PRIMASK(primask);
+            return 0;
+        }
+    }
+
+    // SysTick zatrzymany na czas snu; zapamiętana część bieżącego taktu HAL
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    elapsed_us = idle_residual_us + (SysTick->LOAD - SysTick->VAL) / per_us;
+    period = tim->ARR + 1u;
+    cnt0 = tim->CNT;
+    cyc0 = DWT->CYCCNT;
+
+    __DSB();
+    __WFI();
+    __ISB();
+
+    slept_us = (tim->CNT + period - cnt0) % period;
+
+    // Licznik cykli stał w czasie snu - uzupełnienie, aby terminy UTIMER i pomiary opóźnień
+    // nie przesunęły się o czas snu
+    cycles = slept_us * per_us;
+    if (DWT->CYCCNT - cyc0 + per_us < cycles) {
+        DWT->CYCCNT = cyc0 + cycles;
+    }
+
+    // Takty HAL, które SysTick odliczyłby w czasie snu; reszta przechodzi na następny sen
+    tick_us = 1000u * (uint32_t)uwTickFreq;
+    elapsed_us += slept_us;
+    uwTick += (elapsed_us / tick_us) * (uint32_t)uwTickFreq;
+    idle_residual_us = elapsed_us % tick_us;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    // Pobudka przed terminem pętli (inne przerwanie) - wywołanie nie jest już potrzebne
+    if (wake_id >= 0) {
+        UTIMER_Cancel(wake_id);
+    }
+
+    idle_stats.sleeps++;
+    idle_stats.last_us = slept_us;
+    if (slept_us > idle_stats.max_us) {
+        idle_stats.max_us = slept_us;
+    }
+    idle_slept_frac_us += slept_us;
+    idle_stats.slept_ms += idle_slept_frac_us / 1000u;
+    idle_slept_frac_us %= 1000u;
+
+    // Obsługa przerwania, które obudziło rdzeń
+    __set_PRIMASK(primask);
+
+    return slept_us;
+}
+
+/**
+ * @brief Zwraca liczniki uśpień.
+ */
+const IDLE_Stats *IDLE_GetStats(void)
+{
+    return &idle_stats;
+}
+
+/**
+ * @brief Zapisuje liczniki w postaci jednej linii tekstu.
+ *
+ * @param line Bufor na linię.
+ * @param size Rozmiar bufora.
+ * @return Długość linii (bez znaku końca napisu).
+ */
+int IDLE_Format(char *line, size_t size)
+{
+    int len = snprintf(line, size, "I %lu %lu %lu %lu %lu\n",
+                       (unsigned long)idle_stats.sleeps, (unsigned long)idle_stats.skipped,
+                       (unsigned long)idle_stats.slept_ms, (unsigned long)idle_stats.max_us,
+                       (unsigned long)idle_stats.last_us);
+
+    return (len < (int)size) ? len : (int)size - 1;
+}
@@ -0,0 +1,174 @@
+#include "latency.h"
+#include <stdio.h>
+
+/**
+ * @file latency.c
+ * @brief Implementacja pomiaru czasów obsługi i opóźnień przerwań.
+ *
+ * Pomiar to odczyt licznika cykli DWT przy wejściu i wyjściu z obsługi, więc jego koszt jest
+ * stały i pomijalny. Priorytety do oszacowania opóźnień odczytywane są z NVIC w chwili
+ * tworzenia raportu, dzięki czemu zawsze odpowiadają bieżącej konfiguracji.
+ */
+
+static LATENCY_Stat latency_stats[LATENCY_SOURCES];
+static volatile uint32_t latency_pendsv_request;    /**< Chwila zgłoszenia PendSV */
+static uint32_t latency_output_max;
+
+/** Numery przerwań w kolejności LATENCY_Source */
+static const IRQn_Type latency_irqn[LATENCY_SOURCES] = {
+    SysTick_IRQn, USART3_IRQn, DMA2_Stream0_IRQn, DMA2_Stream1_IRQn, TIM2_IRQn, OTG_FS_IRQn, ETH_IRQn, PendSV_IRQn
+};
+
+/**
+ * @brief Przelicza cykle na nanosekundy.
+ */
+static uint32_t latency_ns(uint32_t cycles)
+{
+    return (uint32_t)((uint64_t)cycles * 1000000000u / SystemCoreClock);
+}
+
+/**
+ * @brief Zeruje liczniki.
+ */
+void LATENCY_Init(void)
+{
+    for (uint32_t i = 0; i < LATENCY_SOURCES; i++) {
+        latency_stats[i].count = 0;
+        latency_stats[i].exec_max = 0;
+        latency_stats[i].entry_max = 0;
+    }
+    latency_output_max = 0;
+}
+
+/**
+ * @brief Znacznik wejścia do obsługi przerwania.
+ *
+ * @return Stan licznika cykli, przekazywany do LATENCY_Exit.
+ */
+uint32_t LATENCY_Enter(void)
+{
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief Zapisuje czas obsługi przerwania.
+ *
+ * @param src Źródło.
+ * @param start Wynik LATENCY_Enter z wejścia do obsługi.
+ */
+void LATENCY_Exit(LATENCY_Source src, uint32_t start)
+{
+    uint32_t cycles = DWT->CYCCNT - start;
+    LATENCY_Stat *s = &latency_stats[src];
+
+    s->count++;
+    if (cycles > s->exec_max) {
+        s->exec_max = cycles;
+    }
+}
+
+/**
+ * @brief Zapisuje zmierzone opóźnienie wejścia do obsługi.
+ *
+ * @param src Źródło.
+ * @param cycles Opóźnienie [cykle].
+ */
+void LATENCY_Entry(LATENCY_Source src, uint32_t cycles)
+{
+    if (cycles > latency_stats[src].entry_max) {
+        latency_stats[src].entry_max = cycles;
+    }
+}
+
+/**
+ * @brief Zgłasza PendSV i zapamiętuje chwilę zgłoszenia (pomiar opóźnienia wejścia).
+ */
+void LATENCY_PendSVRequest(void)
+{
+    latency_pendsv_request = DWT->CYCCNT;
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+/**
+ * @brief Wywoływać na początku PendSV_Handler - zapisuje opóźnienie od zgłoszenia.
+ *
+ * @param start Wynik LATENCY_Enter z wejścia do obsługi.
+ */
+void LATENCY_PendSVEntry(uint32_t start)
+{
+    LATENCY_Entry(LATENCY_PENDSV, start - latency_pendsv_request);
+}
+
+/**
+ * @brief Zapisuje czas od zdarzenia taktu do ustawienia wyjścia regulatora.
+ *
+ * @param cycles Czas [cykle].
+ */
+void LATENCY_Output(uint32_t cycles)
+{
+    if (cycles > latency_output_max) {
+        latency_output_max = cycles;
+    }
+}
+
+/**
+ * @brief Zwraca liczniki przerwania.
+ */
+const LATENCY_Stat *LATENCY_Get(LATENCY_Source src)
+{
+    return &latency_stats[src];
+}
+
+/**
+ * @brief Zapisuje raport w postaci linii tekstu.
+ *
+ * @param buf Bufor na raport.
+ * @param size Rozmiar bufora.
+ * @return Długość raportu (bez znaku końca napisu).
+ */
+int LATENCY_Format(char *buf, size_t size)
+{
+    uint32_t prio[LATENCY_SOURCES];
+    size_t pos = 0;
+    int len;
+
+    for (uint32_t i = 0; i < LATENCY_SOURCES; i++) {
+        prio[i] = NVIC_GetPriority(latency_irqn[i]);
+    }
+
+    for (uint32_t i = 0; i < LATENCY_SOURCES && pos < size; i++) {
+        uint32_t same = 0, higher = 0;
+
+        // Oszacowanie: blokada przez przerwanie z tego samego poziomu + wywłaszczenia
+        for (uint32_t j = 0; j < LATENCY_SOURCES; j++) {
+            if (j == i) {
+                continue;
+            }
+            if (prio[j] == prio[i] && latency_stats[j].exec_max > same) {
+                same = latency_stats[j].exec_max;
+            }
+            else if (prio[j] < prio[i]) {
+                higher += latency_stats[j].exec_max;
+            }
+        }
+
+        len = snprintf(buf + pos, size - pos, "L%lu %lu %lu %lu %lu %lu\n",
+                       (unsigned long)i, (unsigned long)prio[i], (unsigned long)latency_stats[i].count,
+                       (unsigned long)latency_ns(latency_stats[i].exec_max),
+                       (unsigned long)latency_ns(latency_stats[i].entry_max),
+                       (unsigned long)latency_ns(same + higher));
+        if (len < 0) {
+            break;
+        }
+        pos += (size_t)len;
+    }
+
+    if (pos < size) {
+        len = snprintf(buf + pos, size - pos, "LO %lu\n", (unsigned long)latency_ns(latency_output_max));
+        if (len > 0) {
+            pos += (size_t)len;
+        }
+    }
+
+    return (pos < size) ? (int)pos : (int)size - 1;
+}
@@ -1,4 +1,5 @@
 #include "lcd.h"
+#include "utimer.h"
 
 /**
  * @brief Funkcja opóźnienia.
@@ -13,6 +14,19 @@ void LCD_Delay(uint32_t delay)
     HAL_Delay(delay);  /**< Funkcja wprowadzająca opóźnienie w milisekundach */
 }
 
+/**
+ * @brief Funkcja opóźnienia mikrosekundowego.
+ *
+ * Czasy wymagane przez kontroler HD44780 (impuls E, wykonanie komendy) są rzędu
+ * mikrosekund, więc odmierzane są licznikiem cykli zamiast pełnymi milisekundami.
+ *
+ * @param delay Czas opóźnienia w mikrosekundach.
+ */
+void LCD_DelayUs(uint32_t delay)
+{
+    UTIMER_DelayUs(delay);
+}
+
 /**
  * @brief Wysyła 4 bity na wyświetlacz LCD.
  * 
@@ -36,9 +50,9 @@ void LCD_SendNibble(uint8_t nibble)
     else HAL_GPIO_WritePin(LCD_GPIO_PORT, LCD_D4_PIN, GPIO_PIN_RESET);
 
     HAL_GPIO_WritePin(LCD_GPIO_PORT, LCD_E_PIN, GPIO_PIN_SET);
-    LCD_Delay(1);  /**< Krótkie opóźnienie */
+    LCD_DelayUs(LCD_E_PULSE_US);  /**< Szerokość impulsu E */
     HAL_GPIO_WritePin(LCD_GPIO_PORT, LCD_E_PIN, GPIO_PIN_RESET);
-    LCD_Delay(1);  /**< Krótkie opóźnienie */
+    LCD_DelayUs(LCD_E_PULSE_US);  /**< Minimalny okres cyklu zapisu */
 }
 
 /**
@@ -56,7 +70,7 @@ void LCD_SendCommand(uint8_t cmd)
     LCD_SendNibble(cmd >> 4);  /**< Wysyłanie wyższej części komendy */
     LCD_SendNibble(cmd & 0x0F); /**< Wysyłanie niższej części komendy */
     
-    LCD_Delay(2); /**< Opóźnienie po wysłaniu komendy */
+    LCD_DelayUs(LCD_EXEC_US); /**< Czas wykonania komendy */
 }
 
 /**
@@ -74,7 +88,7 @@ void LCD_SendData(uint8_t data)
     LCD_SendNibble(data >> 4);  /**< Wysyłanie wyższej części danych */
     LCD_SendNibble(data & 0x0F); /**< Wysyłanie niższej części danych */
     
-    LCD_Delay(1); /**< Opóźnienie po wysłaniu danych */
+    LCD_DelayUs(LCD_EXEC_US); /**< Czas zapisu danych */
 }
 
 /**
@@ -98,11 +112,11 @@ void LCD_Init(void)
     LCD_Delay(50);  /**< Opóźnienie po włączeniu zasilania LCD */
     
     LCD_SendNibble(0x03);  /**< Pierwszy krok inicjalizacji */
-    LCD_Delay(5);  /**< Opóźnienie */
+    LCD_DelayUs(4100);  /**< Co najmniej 4,1 ms */
     LCD_SendNibble(0x03);  /**< Drugi krok inicjalizacji */
-    LCD_Delay(5);  /**< Opóźnienie */
+    LCD_DelayUs(100);  /**< Co najmniej 100 us */
     LCD_SendNibble(0x03);  /**< Trzeci krok inicjalizacji */
-    LCD_Delay(5);  /**< Opóźnienie */
+    LCD_DelayUs(LCD_EXEC_US);  /**< Czas wykonania komendy */
     LCD_SendNibble(0x02);  /**< Czwarty krok inicjalizacji */
     
     LCD_SendCommand(0x28);  /**< Ustawienie trybu 4-bitowego (2 linie, czcionka 5x8) */
@@ -117,7 +131,7 @@ void LCD_Init(void)
 void LCD_Clear(void)
 {
     LCD_SendCommand(0x01);  /**< Komenda wyczyszczenia ekranu */
-    LCD_Delay(2);           /**< Opóźnienie po wysłaniu komendy */
+    LCD_DelayUs(LCD_CLEAR_US);  /**< Czyszczenie trwa dłużej niż pozostałe komendy */
 }
 
 /**
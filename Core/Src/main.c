@@ -28,9 +28,23 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "bmp2_config.h"
+#include "bmp2_array.h"
 #include "pid.h"
 #include "obsluga.h"
 #include "lcd.h"
+#include "scope.h"
+#include "command.h"
+#include "estimator.h"
+#include "sensor_health.h"
+#include "sampling_policy.h"
+#include "usb_cdc.h"
+#include "utimer.h"
+#include "latency.h"
+#include "idle.h"
+#include "autotune.h"
+#include "gain_schedule.h"
+#include "feedforward.h"
+#include <math.h>
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -40,6 +54,15 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+//Parametry estymatora: szum przyspieszenia zmian temperatury [°C/s^2] i szum pomiaru [°C]
+#define ESTYMATOR_SZUM_PROCESU 0.05f
+#define ESTYMATOR_SZUM_POMIARU 0.02f
+//Maksymalny czas oczekiwania na pierwszy pomiar [ms]
+#define CZAS_PIERWSZEGO_POMIARU 10
+//Temperatura zadana po starcie, gdy pierwszy pomiar się nie powiódł [°C]
+#define TEMPERATURA_ZADANA_DOMYSLNA 25.0
+//Okres obsługi interfejsu (enkoder, UART, USB, LCD) [ms]
+#define OKRES_INTERFEJSU 130
 
 
 /* USER CODE END PD */
@@ -56,15 +79,22 @@ double pomiar_temperatury;
 double temperaturowy_sygnal_wyjsciowy;
 int wypelnienie_pwm;
 double temperatura_zadana;
-uint8_t bufor1[7];
 PID regulator;
+ESTIMATOR estymator;
 int poprzednia_wartosc;
+struct bmp2_dev* const czujniki_bmp2[BMP2_NUM_OF_SENSORS] = {&bmp2dev, &bmp2dev_2};
+volatile uint8_t regulacja_aktywna = 0;
+volatile uint8_t pomiar_poprawny = 0;   //Czy pomiar_temperatury pochodzi ze sprawnego czujnika
+HEALTH_Mode tryb_pomiaru;
+volatile uint32_t znacznik_taktu;   //Chwila zdarzenia taktu TIM2 [cykle DWT]
 
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 /* USER CODE BEGIN PFP */
+void ustaw_wyzwalanie_pomiaru(void);
+void zmien_ustawienia_czujnikow(void);
 
 /* USER CODE END PFP */
 
@@ -81,7 +111,11 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
-
+  SCOPE_Sample probka;
+  uint32_t takt, ostatni_takt = 0;
+  uint32_t ostatnia_obsluga = 0;
+  uint32_t uplynelo;
+  uint8_t zrzut_przebiegu;
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -110,14 +144,46 @@ int main(void)
   MX_ETH_Init();
   MX_TIM3_Init();
   /* USER CODE BEGIN 2 */
-  BMP2_Init(&bmp2dev);
+  //Opóźnienia mikrosekundowe sterowników i wywołania jednorazowe (TIM2 kanał 2)
+  UTIMER_Init(&htim2, TIM_CHANNEL_2);
+  LATENCY_Init();
+  IDLE_Init(&htim2);
+  BMP2_Array_Init(&bmp2array, czujniki_bmp2, BMP2_NUM_OF_SENSORS, BMP2_FUSION_MEDIAN);
+  //Start z ustawieniami o najmniejszym opóźnieniu; polityka próbkowania wycisza je w stanie ustalonym
+  BMP2_Array_SetOversampling(&bmp2array, sampling_settings[SAMPLING_LEVEL_FAST].os_mode,
+		  sampling_settings[SAMPLING_LEVEL_FAST].filter);
+  SAMPLING_Init(&sampling_policy, SAMPLING_LEVEL_FAST);
+  //Jedna konwersja (tryb forced) na takt, zakończona tuż przed przerwaniem TIM2;
+  //pierwszą konwersję uruchamia już zmiana trybu
+  if(BMP2_Array_SetForcedMode(&bmp2array) != HAL_BUSY){
+	  HAL_Delay(BMP2_Array_GetTriggerLead(&bmp2array) / 1000 + 1);
+  }
+  SCOPE_Init();
+  ESTIMATOR_InitFromNoise(&estymator,ESTYMATOR_SZUM_PROCESU,ESTYMATOR_SZUM_POMIARU,0.125f);
+  HEALTH_Init(&sensor_health,0.125);
+  //Pierwszy pomiar (regulacja jeszcze nieaktywna), z ograniczonym czasem oczekiwania
+  if(BMP2_Array_StartRead(&bmp2array) == HAL_OK){
+	  uint32_t start = HAL_GetTick();
+	  while(bmp2array.Busy && (HAL_GetTick() - start) < CZAS_PIERWSZEGO_POMIARU);
+	  if(bmp2array.Busy){
+		  BMP2_Array_Abort(&bmp2array);
+	  }
+  }
+  //Bez poprawnego pierwszego pomiaru pomiar_temperatury wynosi 0 - stała wartość zamiast 0 °C
+  temperatura_zadana = pomiar_poprawny ? (double)round(pomiar_temperatury) : TEMPERATURA_ZADANA_DOMYSLNA;
+  PID_Init(&regulator, 20, 0.3, 320.0,temperatura_zadana,1.0,0.125,0,25,0,25);
+  AUTOTUNE_Init(&autotune, &regulator);
+  GAINSCHED_Init(&gain_schedule);
+  FF_Init(&feedforward, &regulator);
+  regulacja_aktywna = 1;
+  ustaw_wyzwalanie_pomiaru();
+  HAL_TIM_OC_Start_IT(&htim2, TIM_CHANNEL_1);
   HAL_TIM_Base_Start_IT(&htim2);
   LCD_Init();
-  pomiar_temperatury = BMP2_ReadTemperature_degC(&bmp2dev);
-  temperatura_zadana = (double)round(pomiar_temperatury);
-  PID_Init(&regulator, 20, 0.3, 320.0,temperatura_zadana,1.0,0.125,0,25,0,25);
   HAL_TIM_Encoder_Start(&htim3, TIM_CHANNEL_ALL);
-  HAL_UART_Receive_IT(&huart3,&bufor1,7);
+  CMD_Init(&huart3,&temperatura_zadana);
+  CDC_Init(&hpcd_USB_OTG_FS);
+  ETH_NetInit();
 
   /* USER CODE END 2 */
 
@@ -125,15 +191,44 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
+	  //Sieć: odbiór ramek i telemetria w każdym takcie regulatora
+	  ETH_Poll();
+	  takt = SCOPE_GetLast(&probka);
+	  if(takt != ostatni_takt){
+		  ostatni_takt = takt;
+		  send_via_eth(&probka,(uint8_t)tryb_pomiaru);
+		  //Ustawienia czujników zależne od stanu regulacji (na początku taktu - najwięcej czasu do wyzwolenia)
+		  if(SAMPLING_Update(&sampling_policy,probka.setpoint - estymator.x,estymator.v)){
+			  zmien_ustawienia_czujnikow();
+		  }
+	  }
+	  //Polecenia z interfejsu
+	  CMD_Process();
+
+	  uplynelo = HAL_GetTick() - ostatnia_obsluga;
+	  if(uplynelo < OKRES_INTERFEJSU){
+		  //Uśpienie rdzenia do najbliższego przerwania, najdłużej do obsługi interfejsu
+		  IDLE_Sleep((OKRES_INTERFEJSU - uplynelo) * 1000u);
+		  continue;
+	  }
+	  ostatnia_obsluga = HAL_GetTick();
 	  //obsługa enkodera
 	  set_temperature_via_encoder(&htim3,&regulator,&temperatura_zadana,&poprzednia_wartosc);
-	  //Wysyłanie do interfejsu
-	  send_via_uart(temperatura_zadana,pomiar_temperatury,&huart3);
+	  //Wysyłanie do interfejsu - bez łącza, którym idzie zarejestrowany przebieg
+	  //(blok binarny zapowiedziany nagłówkiem "SCOPE" musi dotrzeć w całości)
+	  zrzut_przebiegu = (SCOPE_GetState() == SCOPE_DONE);
+	  if(!zrzut_przebiegu || CMD_GetDumpLink() != CMD_LINK_UART){
+		  send_via_uart(temperatura_zadana,pomiar_temperatury,&huart3);
+	  }
+	  if(!zrzut_przebiegu || CMD_GetDumpLink() != CMD_LINK_USB){
+		  send_via_usb(temperatura_zadana,pomiar_temperatury);
+	  }
+	  //Wysyłanie zarejestrowanego przebiegu (porcjami, aby nie blokować pętli) łączem,
+	  //z którego uzbrojono rejestrator
+	  SCOPE_DumpChunk(CMD_WriteDump);
 
 	  //Wyświetlanie do lcd
 	  display_on_LCD(temperatura_zadana,pomiar_temperatury);
-	  //Opóźnienie całości
-	  HAL_Delay(130);
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
@@ -192,20 +287,177 @@ void SystemClock_Config(void)
 
 /* USER CODE BEGIN 4 */
 
+/**
+ * @brief Ustawia kanał 1 TIM2 tak, aby konwersja czujników zaczynała się przed końcem taktu.
+ *
+ * TIM2 zlicza mikrosekundy, więc różnica między zdarzeniem porównania a przepełnieniem
+ * (odczytem) jest równa wyprzedzeniu wyzwolenia. Wywoływać po każdej zmianie ustawień
+ * nadpróbkowania czujników.
+ */
+void ustaw_wyzwalanie_pomiaru(void){
+	uint32_t okres = __HAL_TIM_GET_AUTORELOAD(&htim2) + 1;
+	uint32_t wyprzedzenie = BMP2_Array_GetTriggerLead(&bmp2array);
+
+	if(wyprzedzenie >= okres){
+		wyprzedzenie = okres - 1;
+	}
+	__HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_1, okres - wyprzedzenie);
+}
+
+/**
+ * @brief Zmienia nadpróbkowanie i filtr czujników na poziom wybrany przez politykę próbkowania.
+ *
+ * Rekonfiguracja używa blokującej transmisji SPI, dlatego wykonywana jest tylko wtedy, gdy
+ * do wyzwolenia konwersji zostało co najmniej SAMPLING_RECONFIG_BUDGET_US; w przeciwnym
+ * wypadku jest odkładana do następnego taktu. Jeżeli mimo to się przedłuży (wywłaszczenie
+ * przez inne przerwania), przerwania TIM2 widzą bmp2array.Reconfig i pomijają wyzwolenie
+ * lub odczyt, zamiast zaczynać transmisję DMA na zajętej magistrali.
+ */
+void zmien_ustawienia_czujnikow(void){
+	const SAMPLING_Setting *ustawienia = &sampling_settings[sampling_policy.target];
+	HAL_StatusTypeDef status;
+	uint32_t start;
+
+	if(bmp2array.Busy || __HAL_TIM_GET_COUNTER(&htim2) + SAMPLING_RECONFIG_BUDGET_US
+			> __HAL_TIM_GET_COMPARE(&htim2, TIM_CHANNEL_1)){
+		SAMPLING_Deferred(&sampling_policy);
+		return;
+	}
+
+	start = DWT->CYCCNT;
+	status = BMP2_Array_SetOversampling(&bmp2array, ustawienia->os_mode, ustawienia->filter);
+	ustaw_wyzwalanie_pomiaru();
+	//Dłuższa konwersja przesuwa wyzwolenie wcześniej - jeżeli ta chwila już minęła, wyzwalamy od razu
+	__disable_irq();
+	if(__HAL_TIM_GET_COUNTER(&htim2) >= __HAL_TIM_GET_COMPARE(&htim2, TIM_CHANNEL_1)){
+		BMP2_Array_StartConversion(&bmp2array);
+	}
+	__enable_irq();
+	SAMPLING_Applied(&sampling_policy, status == HAL_OK, (DWT->CYCCNT - start) / (SystemCoreClock / 1000000u));
+}
+
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim){
+
+	if(htim == &htim2 && htim->Channel == HAL_TIM_ACTIVE_CHANNEL_1){
+		//Wyzwolenie konwersji; wynik odczytuje przerwanie aktualizacji na końcu taktu
+		if(bmp2array.Reconfig){
+			//Trwa blokująca rekonfiguracja - wyzwolenie wykona zmien_ustawienia_czujnikow po jej końcu
+			bmp2array.ReconfigSkipCount++;
+		}
+		else if(BMP2_Array_StartConversion(&bmp2array) == HAL_BUSY){
+			//Odczyt z poprzedniego taktu wciąż trwa - jak w przerwaniu taktu zamykamy go jako błędny
+			BMP2_Array_Abort(&bmp2array);
+			BMP2_Array_StartConversion(&bmp2array);
+		}
+	}
+	UTIMER_CompareCallback(htim);
+
+}
+
 void HAL_TIM_PeriodElapsedCallback (TIM_HandleTypeDef * htim){
 
 	if(htim == &htim2){
-		pomiar_temperatury = BMP2_ReadTemperature_degC(&bmp2dev);
-		temperaturowy_sygnal_wyjsciowy = PID_Compute(&regulator,pomiar_temperatury);
-		wypelnienie_pwm = scale_temperature_to_pulse(temperaturowy_sygnal_wyjsciowy);
-		set_PWM(&htim5,TIM_CHANNEL_1,wypelnienie_pwm);
+		//Chwila zdarzenia taktu (licznik TIM2 zlicza mikrosekundy od przepełnienia)
+		znacznik_taktu = UTIMER_Cycles() - __HAL_TIM_GET_COUNTER(htim) * (SystemCoreClock / 1000000u);
+		//Odczyt wszystkich czujników w jednej sekwencji DMA; regulacja po jej zakończeniu
+		if(bmp2array.Reconfig){
+			//Trwa blokująca rekonfiguracja - bez odczytu (i regulacji) w tym takcie
+			bmp2array.ReconfigSkipCount++;
+		}
+		else if(BMP2_Array_StartRead(&bmp2array) == HAL_BUSY){
+			//Poprzednia sekwencja nie zmieściła się w takcie - zamykamy ją jako błędną,
+			//kolejny odczyt rozpocznie się w następnym takcie
+			BMP2_Array_Abort(&bmp2array);
+		}
 	}
 
 }
 
+void BMP2_Array_ReadCpltCallback(BMP2_ArrayTypeDef *arr){
+	UNUSED(arr);
+	//Przerwanie DMA kończy się od razu; obliczenia w PendSV o najniższym priorytecie,
+	//aby nie opóźniały odbioru UART, SysTick ani USB
+	LATENCY_PendSVRequest();
+}
+
+/**
+ * @brief Obliczenia regulatora po zakończeniu odczytu czujników. Wywoływana z PendSV_Handler.
+ */
+void wykonaj_regulacje(void){
+	uint32_t start = DWT->CYCCNT;
+	double pomiar;
+	double sprzezenie_w_przod;
+
+	tryb_pomiaru = HEALTH_Evaluate(&sensor_health,&bmp2array,&pomiar);
+	if(tryb_pomiaru == HEALTH_MODE_OK || tryb_pomiaru == HEALTH_MODE_DEGRADED){
+		pomiar_temperatury = pomiar;
+		pomiar_poprawny = 1;
+		ESTIMATOR_Update(&estymator,(float)pomiar_temperatury);
+	}
+	else{
+		//Brak sprawnego czujnika - tylko predykcja estymatora
+		ESTIMATOR_Predict(&estymator);
+	}
+
+	if(!regulacja_aktywna){
+		return;
+	}
+
+	if(tryb_pomiaru == HEALTH_MODE_SAFE){
+		//Zbyt długo bez pomiaru - bezpieczne wypełnienie zamiast regulacji
+		temperaturowy_sygnal_wyjsciowy = HEALTH_SAFE_OUTPUT;
+		AUTOTUNE_Cancel(&autotune,AUTOTUNE_ERR_SENSOR);
+	}
+	else if(AUTOTUNE_IsActive(&autotune)){
+		//Strojenie przekaźnikowe zamiast PID (po nim pierwszy krok PID z nowymi nastawami)
+		//Sprzężenie w przód wyłączone na czas strojenia - przywraca zakres wyjścia PID
+		FF_Apply(&feedforward);
+		temperaturowy_sygnal_wyjsciowy = AUTOTUNE_Update(&autotune,estymator.x,estymator.v);
+	}
+	else{
+		//Nastawy z harmonogramu (bez zmian, gdy tablica nie jest wczytana); granice integratora
+		//przy włączonym sprzężeniu w przód ustala FF_Apply
+		GAINSCHED_Apply(&gain_schedule,&regulator,estymator.x,!feedforward.enabled);
+		//Wypełnienie ustalone z modelu strat dla temperatury zadanej + korekta PID
+		sprzezenie_w_przod = FF_Apply(&feedforward);
+		temperaturowy_sygnal_wyjsciowy = PID_ComputeWithRate(&regulator,estymator.x,estymator.v) + sprzezenie_w_przod;
+		FF_Learn(&feedforward,estymator.x,estymator.v,temperaturowy_sygnal_wyjsciowy);
+	}
+	wypelnienie_pwm = scale_temperature_to_pulse(temperaturowy_sygnal_wyjsciowy);
+	set_PWM(&htim5,TIM_CHANNEL_1,wypelnienie_pwm);
+	LATENCY_Output(DWT->CYCCNT - znacznik_taktu);
+	SCOPE_Record(&regulator,pomiar_temperatury,temperaturowy_sygnal_wyjsciowy,wypelnienie_pwm,DWT->CYCCNT - start);
+	//Nowa próbka dla pętli głównej (telemetria, polityka próbkowania)
+	IDLE_Wake();
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi){
+	BMP2_Array_SpiTxRxCpltCallback(&bmp2array,hspi);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi){
+	BMP2_Array_SpiErrorCallback(&bmp2array,hspi);
+}
+
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart){
 	if(huart == &huart3){
-		recieve_via_uart(&huart3,&temperatura_zadana,&bufor1);
+		CMD_RxCpltCallback(&huart3);
+	}
+}
+
+void CDC_ReceiveCallback(const uint8_t *data, uint32_t len){
+	CMD_RxUsb(data,len);
+}
+
+void NET_UdpReceiveCallback(uint32_t src_ip, uint16_t src_port, uint16_t dst_port, const uint8_t *data, uint16_t len){
+	if(dst_port == CMD_UDP_PORT){
+		CMD_RxUdp(src_ip,src_port,data,len);
+	}
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart){
+	if(huart == &huart3){
+		CMD_ErrorCallback(&huart3);
 	}
 }
 
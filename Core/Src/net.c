@@ -0,0 +1,611 @@
+#include "net.h"
+#include <string.h>
+
+/**
+ * @file net.c
+ * @brief Implementacja minimalnego stosu UDP/IPv4 z obsługą ARP i ICMP echo.
+ *
+ * Pola nagłówków odczytywane i zapisywane są bajtowo (porządek sieciowy), więc ramki mogą
+ * leżeć pod dowolnym adresem. Odpowiedzi ARP i ICMP echo powstają przez przepisanie nagłówków
+ * odebranej ramki, bez kopiowania danych. Tablica ARP uzupełniana jest z zapytań i odpowiedzi ARP
+ * skierowanych do urządzenia oraz z adresów nadawców datagramów z sieci lokalnej; przy
+ * braku miejsca zastępowany jest najdawniej używany wpis.
+ */
+
+#define NET_ETHERTYPE_IPV4  0x0800u
+#define NET_ETHERTYPE_ARP   0x0806u
+
+#define NET_ARP_LEN         28u
+#define NET_ARP_REQUEST     1u
+#define NET_ARP_REPLY       2u
+
+#define NET_PROTO_ICMP      1u
+#define NET_PROTO_UDP       17u
+
+#define NET_ICMP_ECHO_REPLY   0u
+#define NET_ICMP_ECHO_REQUEST 8u
+
+/**
+ * @brief Wpis tablicy ARP.
+ */
+typedef struct {
+    uint32_t ip;                /**< 0 - wpis wolny */
+    uint8_t mac[6];
+    uint32_t used;              /**< Chwila ostatniego użycia (licznik net_arp_clock) */
+} NET_ArpEntry;
+
+static const NET_Mac *net_mac;
+static NET_Config net_config;
+static NET_Stats net_stats;
+
+static NET_ArpEntry net_arp[NET_ARP_CACHE_LEN];
+static uint32_t net_arp_clock;
+static uint16_t net_ip_id;
+static uint8_t *net_udp_frame;          /**< Bufor przydzielony przez NET_UdpBegin */
+
+static const uint8_t net_broadcast_mac[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+static uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t rd32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void wr16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void wr32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+/**
+ * @brief Dodaje dane do sumy kontrolnej Internetu (bez zwijania przeniesień).
+ */
+static uint32_t net_sum(const uint8_t *data, uint32_t len, uint32_t sum)
+{
+    while (len > 1) {
+        sum += rd16(data);
+        data += 2;
+        len -= 2;
+    }
+    if (len) {
+        sum += (uint32_t)data[0] << 8;
+    }
+    return sum;
+}
+
+/**
+ * @brief Zwija przeniesienia i zwraca dopełnienie sumy.
+ */
+static uint16_t net_fold(uint32_t sum)
+{
+    while (sum >> 16) {
+        sum = (sum & 0xFFFFu) + (sum >> 16);
+    }
+    return (uint16_t)~sum;
+}
+
+/**
+ * @brief Suma pseudo-nagłówka UDP.
+ */
+static uint32_t net_pseudo_sum(uint32_t src, uint32_t dst, uint8_t proto, uint16_t len)
+{
+    return (src >> 16) + (src & 0xFFFFu) + (dst >> 16) + (dst & 0xFFFFu) + proto + len;
+}
+
+static uint8_t net_is_local(uint32_t ip)
+{
+    return ((ip ^ net_config.ip) & net_config.netmask) == 0;
+}
+
+static uint8_t net_is_broadcast(uint32_t ip)
+{
+    return ip == 0xFFFFFFFFu || (net_is_local(ip) && (ip | net_config.netmask) == 0xFFFFFFFFu);
+}
+
+static uint8_t net_is_multicast(uint32_t ip)
+{
+    return (ip & 0xF0000000u) == 0xE0000000u;
+}
+
+/**
+ * @brief Wyszukuje adres MAC w tablicy ARP.
+ */
+static const uint8_t *net_arp_lookup(uint32_t ip)
+{
+    for (uint32_t i = 0; i < NET_ARP_CACHE_LEN; i++) {
+        if (net_arp[i].ip == ip) {
+            net_arp[i].used = ++net_arp_clock;
+            return net_arp[i].mac;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Aktualizuje wpis tablicy ARP.
+ *
+ * @param create Czy utworzyć wpis, jeżeli adresu nie ma w tablicy.
+ */
+static void net_arp_update(uint32_t ip, const uint8_t *mac, uint8_t create)
+{
+    NET_ArpEntry *victim = &net_arp[0];
+
+    if (ip == 0 || !net_is_local(ip)) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < NET_ARP_CACHE_LEN; i++) {
+        if (net_arp[i].ip == ip) {
+            memcpy(net_arp[i].mac, mac, 6);
+            net_arp[i].used = ++net_arp_clock;
+            return;
+        }
+        if (net_arp[i].used < victim->used) {
+            victim = &net_arp[i];
+        }
+    }
+
+    if (create) {
+        victim->ip = ip;
+        memcpy(victim->mac, mac, 6);
+        victim->used = ++net_arp_clock;
+    }
+}
+
+/**
+ * @brief Zapisuje nagłówek Ethernet.
+ */
+static void net_eth_header(uint8_t *frame, const uint8_t *dst, uint16_t type)
+{
+    memcpy(frame, dst, 6);
+    memcpy(frame + 6, net_mac->addr, 6);
+    wr16(frame + 12, type);
+}
+
+/**
+ * @brief Zapisuje nagłówek IPv4 (bez opcji).
+ *
+ * @param payload_len Długość danych za nagłówkiem IP.
+ */
+static void net_ip_header(uint8_t *ip, uint8_t proto, uint32_t dst, uint16_t payload_len, uint8_t ttl)
+{
+    ip[0] = 0x45;
+    ip[1] = 0;
+    wr16(ip + 2, (uint16_t)(NET_IP_HDR_LEN + payload_len));
+    wr16(ip + 4, net_ip_id++);
+    wr16(ip + 6, 0x4000);                   /* DF */
+    ip[8] = ttl;
+    ip[9] = proto;
+    wr16(ip + 10, 0);
+    wr32(ip + 12, net_config.ip);
+    wr32(ip + 16, dst);
+    if (!net_mac->checksum_offload) {
+        wr16(ip + 10, net_fold(net_sum(ip, NET_IP_HDR_LEN, 0)));
+    }
+}
+
+/**
+ * @brief Przekazuje gotową ramkę do sterownika.
+ */
+static NET_Status net_transmit(uint8_t *frame, uint16_t len)
+{
+    NET_Status status = net_mac->tx_send(net_mac->ctx, frame, len);
+
+    if (status == NET_OK) {
+        net_stats.tx_frames++;
+    } else {
+        net_stats.tx_dropped++;
+    }
+    return status;
+}
+
+/**
+ * @brief Wysyła zapytanie lub odpowiedź ARP.
+ *
+ * @param op NET_ARP_REQUEST lub NET_ARP_REPLY.
+ * @param eth_dst Adres MAC odbiorcy ramki.
+ * @param target_mac Adres MAC w polu docelowym pakietu ARP.
+ * @param target_ip Adres IP w polu docelowym pakietu ARP.
+ */
+static void net_arp_send(uint16_t op, const uint8_t *eth_dst, const uint8_t *target_mac, uint32_t target_ip)
+{
+    uint8_t *frame = net_mac->tx_alloc(net_mac->ctx);
+    uint8_t *arp;
+
+    if (frame == NULL) {
+        net_stats.tx_dropped++;
+        return;
+    }
+
+    net_eth_header(frame, eth_dst, NET_ETHERTYPE_ARP);
+    arp = frame + NET_ETH_HDR_LEN;
+    wr16(arp, 1);                           /* Ethernet */
+    wr16(arp + 2, NET_ETHERTYPE_IPV4);
+    arp[4] = 6;
+    arp[5] = 4;
+    wr16(arp + 6, op);
+    memcpy(arp + 8, net_mac->addr, 6);
+    wr32(arp + 14, net_config.ip);
+    memcpy(arp + 18, target_mac, 6);
+    wr32(arp + 24, target_ip);
+
+    net_transmit(frame, NET_ETH_HDR_LEN + NET_ARP_LEN);
+}
+
+/**
+ * @brief Wyznacza adres MAC następnego węzła.
+ *
+ * @return NET_OK, NET_BUSY (wysłano zapytanie ARP) lub NET_ERROR (adres nieosiągalny).
+ */
+static NET_Status net_resolve(uint32_t ip, uint8_t *mac)
+{
+    static const uint8_t zero_mac[6] = {0};
+    const uint8_t *cached;
+    uint32_t next_hop = ip;
+
+    if (net_is_multicast(ip)) {
+        mac[0] = 0x01;
+        mac[1] = 0x00;
+        mac[2] = 0x5E;
+        mac[3] = (uint8_t)((ip >> 16) & 0x7Fu);
+        mac[4] = (uint8_t)(ip >> 8);
+        mac[5] = (uint8_t)ip;
+        return NET_OK;
+    }
+    if (net_is_broadcast(ip)) {
+        memcpy(mac, net_broadcast_mac, 6);
+        return NET_OK;
+    }
+    if (!net_is_local(ip)) {
+        if (net_config.gateway == 0) {
+            return NET_ERROR;
+        }
+        next_hop = net_config.gateway;
+    }
+
+    cached = net_arp_lookup(next_hop);
+    if (cached == NULL) {
+        net_stats.arp_misses++;
+        net_arp_send(NET_ARP_REQUEST, net_broadcast_mac, zero_mac, next_hop);
+        return NET_BUSY;
+    }
+    memcpy(mac, cached, 6);
+    return NET_OK;
+}
+
+/**
+ * @brief Obsługuje pakiet ARP; odpowiedź powstaje w buforze zapytania.
+ *
+ * @return 1, jeżeli bufor ramki został wysłany jako odpowiedź.
+ */
+static uint8_t net_arp_input(uint8_t *frame, uint16_t len)
+{
+    uint8_t *arp = frame + NET_ETH_HDR_LEN;
+    uint8_t sender_mac[6];
+    uint32_t sender_ip, target_ip;
+
+    if (len < NET_ETH_HDR_LEN + NET_ARP_LEN || rd16(arp) != 1 || rd16(arp + 2) != NET_ETHERTYPE_IPV4
+        || arp[4] != 6 || arp[5] != 4) {
+        net_stats.rx_dropped++;
+        return 0;
+    }
+
+    memcpy(sender_mac, arp + 8, 6);
+    sender_ip = rd32(arp + 14);
+    target_ip = rd32(arp + 24);
+
+    if (target_ip != net_config.ip) {
+        // Cudze zapytanie - tylko odświeżenie istniejącego wpisu
+        net_arp_update(sender_ip, sender_mac, 0);
+        return 0;
+    }
+
+    net_arp_update(sender_ip, sender_mac, 1);
+    if (rd16(arp + 6) != NET_ARP_REQUEST) {
+        return 0;
+    }
+
+    net_eth_header(frame, sender_mac, NET_ETHERTYPE_ARP);
+    wr16(arp + 6, NET_ARP_REPLY);
+    memcpy(arp + 18, sender_mac, 6);
+    wr32(arp + 24, sender_ip);
+    memcpy(arp + 8, net_mac->addr, 6);
+    wr32(arp + 14, net_config.ip);
+
+    net_transmit(frame, NET_ETH_HDR_LEN + NET_ARP_LEN);
+    return 1;
+}
+
+/**
+ * @brief Odpowiada na zapytanie ICMP echo (ping) w buforze zapytania.
+ *
+ * @param frame Odebrana ramka.
+ * @param len Długość komunikatu ICMP (za nagłówkiem IP bez opcji).
+ * @param src Adres IP nadawcy.
+ * @return 1, jeżeli bufor ramki został wysłany jako odpowiedź.
+ */
+static uint8_t net_icmp_input(uint8_t *frame, uint16_t len, uint32_t src)
+{
+    uint8_t *icmp = frame + NET_ETH_HDR_LEN + NET_IP_HDR_LEN;
+    uint8_t src_mac[6];
+
+    if (len < 8 || icmp[0] != NET_ICMP_ECHO_REQUEST || icmp[1] != 0) {
+        net_stats.rx_dropped++;
+        return 0;
+    }
+    if (!net_mac->checksum_offload && net_fold(net_sum(icmp, len, 0)) != 0) {
+        net_stats.rx_dropped++;
+        return 0;
+    }
+
+    // Odpowiedź bezpośrednio na adres MAC nadawcy, bez udziału tablicy ARP
+    memcpy(src_mac, frame + 6, 6);
+    net_eth_header(frame, src_mac, NET_ETHERTYPE_IPV4);
+    net_ip_header(frame + NET_ETH_HDR_LEN, NET_PROTO_ICMP, src, len, NET_TTL);
+    icmp[0] = NET_ICMP_ECHO_REPLY;
+    wr16(icmp + 2, 0);
+    if (!net_mac->checksum_offload) {
+        wr16(icmp + 2, net_fold(net_sum(icmp, len, 0)));
+    }
+
+    net_stats.icmp_echo++;
+    net_transmit(frame, (uint16_t)(NET_ETH_HDR_LEN + NET_IP_HDR_LEN + len));
+    return 1;
+}
+
+/**
+ * @brief Obsługuje datagram UDP.
+ */
+static void net_udp_input(const uint8_t *udp, uint16_t len, uint32_t src, uint32_t dst)
+{
+    uint16_t udp_len;
+
+    if (len < NET_UDP_HDR_LEN) {
+        net_stats.rx_dropped++;
+        return;
+    }
+    udp_len = rd16(udp + 4);
+    if (udp_len < NET_UDP_HDR_LEN || udp_len > len) {
+        net_stats.rx_dropped++;
+        return;
+    }
+    if (!net_mac->checksum_offload && rd16(udp + 6) != 0
+        && net_fold(net_sum(udp, udp_len, net_pseudo_sum(src, dst, NET_PROTO_UDP, udp_len))) != 0) {
+        net_stats.rx_dropped++;
+        return;
+    }
+
+    NET_UdpReceiveCallback(src, rd16(udp), rd16(udp + 2), udp + NET_UDP_HDR_LEN,
+                           (uint16_t)(udp_len - NET_UDP_HDR_LEN));
+}
+
+/**
+ * @brief Obsługuje datagram IPv4.
+ */
+static uint8_t net_ip_input(uint8_t *frame, uint16_t len)
+{
+    const uint8_t *ip = frame + NET_ETH_HDR_LEN;
+    uint16_t hdr_len, total_len;
+    uint32_t src, dst;
+
+    len = (uint16_t)(len - NET_ETH_HDR_LEN);
+    if (len < NET_IP_HDR_LEN || (ip[0] >> 4) != 4) {
+        net_stats.rx_dropped++;
+        return 0;
+    }
+    hdr_len = (uint16_t)((ip[0] & 0x0Fu) * 4u);
+    total_len = rd16(ip + 2);
+    // Fragmenty (MF lub niezerowe przesunięcie) nie są składane
+    if (hdr_len < NET_IP_HDR_LEN || total_len < hdr_len || total_len > len || (rd16(ip + 6) & 0x3FFFu) != 0) {
+        net_stats.rx_dropped++;
+        return 0;
+    }
+    if (!net_mac->checksum_offload && net_fold(net_sum(ip, hdr_len, 0)) != 0) {
+        net_stats.rx_dropped++;
+        return 0;
+    }
+
+    src = rd32(ip + 12);
+    dst = rd32(ip + 16);
+    if (dst != net_config.ip && !(ip[9] == NET_PROTO_UDP && net_is_broadcast(dst))) {
+        net_stats.rx_dropped++;
+        return 0;
+    }
+
+    net_arp_update(src, frame + 6, 1);
+
+    switch (ip[9]) {
+    case NET_PROTO_ICMP:
+        // Odpowiedź w miejscu zapytania wymaga nagłówka bez opcji
+        if (dst == net_config.ip && hdr_len == NET_IP_HDR_LEN) {
+            return net_icmp_input(frame, (uint16_t)(total_len - hdr_len), src);
+        }
+        net_stats.rx_dropped++;
+        break;
+    case NET_PROTO_UDP:
+        net_udp_input(ip + hdr_len, (uint16_t)(total_len - hdr_len), src, dst);
+        break;
+    default:
+        net_stats.rx_dropped++;
+        break;
+    }
+    return 0;
+}
+
+/**
+ * @brief Inicjalizuje stos.
+ *
+ * @param mac Sterownik karty sieciowej (struktura musi istnieć przez cały czas pracy).
+ * @param config Konfiguracja adresów (kopiowana).
+ */
+void NET_Init(const NET_Mac *mac, const NET_Config *config)
+{
+    net_mac = mac;
+    net_config = *config;
+    memset(&net_stats, 0, sizeof(net_stats));
+    memset(net_arp, 0, sizeof(net_arp));
+    net_arp_clock = 0;
+    net_ip_id = 0;
+    net_udp_frame = NULL;
+}
+
+/**
+ * @brief Przetwarza odebraną ramkę Ethernet (bez sumy CRC).
+ *
+ * @param frame Ramka.
+ * @param len Długość ramki w bajtach.
+ * @return 1, jeżeli bufor został przekazany do NET_Mac.tx_send, 0 w przeciwnym wypadku.
+ */
+uint8_t NET_Input(uint8_t *frame, uint16_t len)
+{
+    if (net_mac == NULL) {
+        return 0;
+    }
+
+    net_stats.rx_frames++;
+    if (len < NET_ETH_HDR_LEN) {
+        net_stats.rx_dropped++;
+        return 0;
+    }
+
+    switch (rd16(frame + 12)) {
+    case NET_ETHERTYPE_ARP:
+        return net_arp_input(frame, len);
+    case NET_ETHERTYPE_IPV4:
+        return net_ip_input(frame, len);
+    default:
+        net_stats.rx_dropped++;
+        return 0;
+    }
+}
+
+/**
+ * @brief Przydziela bufor nadawczy dla datagramu UDP.
+ *
+ * @return Miejsce na dane (NET_UDP_PAYLOAD_MAX bajtów) lub NULL, gdy brak wolnego bufora.
+ */
+uint8_t *NET_UdpBegin(void)
+{
+    if (net_mac == NULL) {
+        return NULL;
+    }
+    if (net_udp_frame == NULL) {
+        net_udp_frame = net_mac->tx_alloc(net_mac->ctx);
+        if (net_udp_frame == NULL) {
+            net_stats.tx_dropped++;
+            return NULL;
+        }
+    }
+    return net_udp_frame + NET_ETH_HDR_LEN + NET_IP_HDR_LEN + NET_UDP_HDR_LEN;
+}
+
+/**
+ * @brief Uzupełnia nagłówki i wysyła datagram przygotowany przez NET_UdpBegin.
+ *
+ * @param dst_ip Adres odbiorcy.
+ * @param dst_port Port odbiorcy.
+ * @param src_port Port nadawcy.
+ * @param len Liczba bajtów danych (co najwyżej NET_UDP_PAYLOAD_MAX).
+ * @return NET_OK, NET_BUSY lub NET_ERROR.
+ */
+NET_Status NET_UdpEnd(uint32_t dst_ip, uint16_t dst_port, uint16_t src_port, uint16_t len)
+{
+    uint8_t dst_mac[6];
+    uint8_t *frame = net_udp_frame;
+    uint8_t *udp;
+    uint16_t udp_len = (uint16_t)(NET_UDP_HDR_LEN + len);
+    NET_Status status;
+
+    if (frame == NULL) {
+        return NET_ERROR;
+    }
+    net_udp_frame = NULL;
+
+    status = (len > NET_UDP_PAYLOAD_MAX) ? NET_ERROR : net_resolve(dst_ip, dst_mac);
+    if (status != NET_OK) {
+        net_mac->tx_release(net_mac->ctx, frame);
+        return status;
+    }
+
+    net_eth_header(frame, dst_mac, NET_ETHERTYPE_IPV4);
+    net_ip_header(frame + NET_ETH_HDR_LEN, NET_PROTO_UDP, dst_ip, udp_len,
+                  net_is_multicast(dst_ip) ? NET_MULTICAST_TTL : NET_TTL);
+
+    udp = frame + NET_ETH_HDR_LEN + NET_IP_HDR_LEN;
+    wr16(udp, src_port);
+    wr16(udp + 2, dst_port);
+    wr16(udp + 4, udp_len);
+    wr16(udp + 6, 0);
+    if (!net_mac->checksum_offload) {
+        uint16_t sum = net_fold(net_sum(udp, udp_len, net_pseudo_sum(net_config.ip, dst_ip, NET_PROTO_UDP, udp_len)));
+        wr16(udp + 6, sum == 0 ? 0xFFFFu : sum);
+    }
+
+    return net_transmit(frame, (uint16_t)(NET_ETH_HDR_LEN + NET_IP_HDR_LEN + udp_len));
+}
+
+/**
+ * @brief Wysyła datagram UDP z kopią podanych danych (NET_UdpBegin + NET_UdpEnd).
+ *
+ * @param dst_ip Adres odbiorcy.
+ * @param dst_port Port odbiorcy.
+ * @param src_port Port nadawcy.
+ * @param data Dane.
+ * @param len Liczba bajtów (co najwyżej NET_UDP_PAYLOAD_MAX).
+ * @return NET_OK, NET_BUSY lub NET_ERROR.
+ */
+NET_Status NET_UdpSend(uint32_t dst_ip, uint16_t dst_port, uint16_t src_port, const uint8_t *data, uint16_t len)
+{
+    uint8_t *payload;
+
+    if (len > NET_UDP_PAYLOAD_MAX) {
+        return NET_ERROR;
+    }
+    payload = NET_UdpBegin();
+    if (payload == NULL) {
+        return NET_BUSY;
+    }
+    memcpy(payload, data, len);
+    return NET_UdpEnd(dst_ip, dst_port, src_port, len);
+}
+
+/**
+ * @brief Funkcja zwrotna odbioru datagramu UDP. Domyślnie dane są odrzucane.
+ */
+__attribute__((weak)) void NET_UdpReceiveCallback(uint32_t src_ip, uint16_t src_port, uint16_t dst_port,
+                                                  const uint8_t *data, uint16_t len)
+{
+    (void)src_ip;
+    (void)src_port;
+    (void)dst_port;
+    (void)data;
+    (void)len;
+}
+
+/**
+ * @brief Zwraca konfigurację adresów.
+ */
+const NET_Config *NET_GetConfig(void)
+{
+    return &net_config;
+}
+
+/**
+ * @brief Zwraca liczniki stosu.
+ */
+const NET_Stats *NET_GetStats(void)
+{
+    return &net_stats;
+}
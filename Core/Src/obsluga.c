@@ -1,5 +1,8 @@
 #include <obsluga.h>
 #include <math.h>
+#include <stdio.h>
+#include "usb_cdc.h"
+#include "eth.h"
 
 /**
  * @file obsluga.c
@@ -113,29 +116,36 @@ void send_via_uart(double set, double measure, UART_HandleTypeDef *huart)
     HAL_UART_Transmit(huart, bufor, 13, 100);
 }
 
-/**
- * @brief Odbiera dane przez UART.
- *
- * Funkcja ta odbiera dane zawierające ustawioną temperaturę przez interfejs UART,
- * następnie przetwarza odebrane dane na wartość temperatury.
- *
- * @param huart Wskaźnik na strukturę UART, z której będą odbierane dane.
- * @param set Wskaźnik na zmienną, w której będzie zapisana odbierana temperatura.
- * @param bufor1 Bufor do przechowywania danych odbieranych przez UART.
- */
-void recieve_via_uart(UART_HandleTypeDef *huart, double *set, uint8_t *bufor1)
+void send_via_usb(double set, double measure)
+{
+    char bufor[32];
+    int len;
+
+    if (!CDC_IsConnected()) {
+        return;
+    }
+    len = snprintf(bufor, sizeof(bufor), "Z%.2fA%.2f\n", set, measure);
+    CDC_Transmit((uint8_t*)bufor, (uint16_t)len);
+}
+
+void send_via_eth(const SCOPE_Sample *sample, uint8_t mode)
 {
-    HAL_UART_Receive_IT(huart, bufor1, 7);
-    uint8_t bufor2[2];
-    double c;
-    double pp;
-    for (int i = 1; i < 3; i++) {
-        bufor2[i - 1] = bufor1[i];
+    static uint32_t seq = 0;
+    TELEMETRY_Frame *frame;
+
+    if (!ETH_IsLinkUp()) {
+        return;
     }
-    c = (double)atoi(bufor2);
-    for (int i = 4; i < 6; i++) {
-        bufor2[i - 4] = bufor1[i];
+    // Ramka budowana bezpośrednio w buforze nadawczym ETH
+    frame = (TELEMETRY_Frame*)NET_UdpBegin();
+    if (frame == NULL) {
+        return;
     }
-    pp = (double)(atoi(bufor2) / 100.0);
-    *set = c + pp;
+    frame->magic = TELEMETRY_MAGIC;
+    frame->device = ETH_DeviceId();
+    frame->seq = seq++;
+    frame->mode = mode;
+    frame->reserved[0] = frame->reserved[1] = frame->reserved[2] = 0;
+    frame->sample = *sample;
+    NET_UdpEnd(TELEMETRY_GROUP, TELEMETRY_PORT, TELEMETRY_PORT, sizeof(TELEMETRY_Frame));
 }
@@ -40,19 +40,21 @@ void PID_Init(PID *pid, double Kp, double Ki, double Kd, double setpoint,
 
     pid->prev_input = 0.0; // Zainicjalizuj poprzednią próbkę wejściową
     pid->prev_output = 0.0; // Zainicjalizuj poprzednią próbkę wyjściową
+
+    pid->p_term = 0.0;
+    pid->i_term = 0.0;
+    pid->d_term = 0.0;
 }
 
 /**
- * @brief Oblicza wyjście PID z uwzględnieniem opóźnienia transportowego i systemu anty wind-up.
- *
- * Funkcja ta oblicza wartość wyjściową kontrolera PID, biorąc pod uwagę opóźnienie transportowe
- * w systemie oraz zapobiegając przeciążeniu integratora (wind-up) przez ograniczenie jego wartości.
+ * @brief Wspólny krok algorytmu PID dla podanej wartości różnicy wejścia.
  *
  * @param pid Wskaźnik do struktury PID.
  * @param input Aktualna wartość wejściowa do algorytmu PID.
- * @return Wyjście algorytmu PID z uwzględnieniem opóźnienia transportowego i systemu anty wind-up.
+ * @param derivative Zmiana wejścia na jeden okres próbkowania.
+ * @return Wyjście algorytmu PID.
  */
-double PID_Compute(PID *pid, double input)
+static double pid_step(PID *pid, double input, double derivative)
 {
     pid->sample_count++;
 
@@ -75,11 +77,11 @@ double PID_Compute(PID *pid, double input)
         pid->integral = pid->integral_min;
     }
 
-    // Oblicz pochodną (na podstawie różnicy pomiędzy aktualną próbą a poprzednią)
-    double derivative = input - pid->prev_input;
-
-    // Oblicz wyjście PID
-    double output = pid->Kp * error + pid->Ki * pid->integral + pid->Kd * derivative;
+    // Oblicz składowe i wyjście PID (składowe zapamiętujemy do diagnostyki)
+    pid->p_term = pid->Kp * error;
+    pid->i_term = pid->Ki * pid->integral;
+    pid->d_term = pid->Kd * derivative;
+    double output = pid->p_term + pid->i_term + pid->d_term;
 
     // Ogranicz wyjście PID, aby nie przekroczyło zakresu
     if (output > pid->output_max) {
@@ -98,6 +100,38 @@ double PID_Compute(PID *pid, double input)
     return output;
 }
 
+/**
+ * @brief Oblicza wyjście PID z uwzględnieniem opóźnienia transportowego i systemu anty wind-up.
+ *
+ * Funkcja ta oblicza wartość wyjściową kontrolera PID, biorąc pod uwagę opóźnienie transportowe
+ * w systemie oraz zapobiegając przeciążeniu integratora (wind-up) przez ograniczenie jego wartości.
+ *
+ * @param pid Wskaźnik do struktury PID.
+ * @param input Aktualna wartość wejściowa do algorytmu PID.
+ * @return Wyjście algorytmu PID z uwzględnieniem opóźnienia transportowego i systemu anty wind-up.
+ */
+double PID_Compute(PID *pid, double input)
+{
+    // Pochodna na podstawie różnicy pomiędzy aktualną próbą a poprzednią
+    return pid_step(pid, input, input - pid->prev_input);
+}
+
+/**
+ * @brief Oblicza wyjście PID dla estymaty wejścia i jej pochodnej.
+ *
+ * Działa jak PID_Compute, lecz składowa różniczkująca korzysta z podanej szybkości zmian
+ * (np. z estymatora stanu) zamiast z różnicy dwóch zaszumionych próbek.
+ *
+ * @param pid Wskaźnik do struktury PID.
+ * @param input Estymata wartości wejściowej.
+ * @param rate Estymata szybkości zmian wejścia na sekundę.
+ * @return Wyjście algorytmu PID z uwzględnieniem opóźnienia transportowego i systemu anty wind-up.
+ */
+double PID_ComputeWithRate(PID *pid, double input, double rate)
+{
+    return pid_step(pid, input, rate * pid->sampling_time);
+}
+
 /**
  * @brief Zmienia punkt zadany (setpoint) w algorytmie PID.
  *
@@ -0,0 +1,177 @@
+#include "sampling_policy.h"
+#include "bmp2_defs.h"
+#include <math.h>
+#include <stdio.h>
+
+/**
+ * @file sampling_policy.c
+ * @brief Implementacja doboru ustawień czujników BMP2 do stanu regulacji.
+ *
+ * Progi wejścia na poziom są o połowę węższe od progów jego opuszczenia, a wejście wymaga
+ * dodatkowo serii spokojnych taktów, dzięki czemu szum pomiaru nie powoduje przełączania
+ * ustawień tam i z powrotem. Poziom szybki nie ma progów - jest zawsze dopuszczalny.
+ */
+
+SAMPLING_POLICY sampling_policy;
+
+/**
+ * Czasy konwersji (typowe): 5,5 ms, 11,5 ms i 37,5 ms - wszystkie mieszczą się z zapasem
+ * w takcie 125 ms. Filtr 8 ustala 75% skoku po ok. 11 próbkach, dlatego używany jest
+ * tylko w stanie ustalonym.
+ */
+const SAMPLING_Setting sampling_settings[SAMPLING_LEVELS] = {
+    [SAMPLING_LEVEL_FAST] = {
+        BMP2_OS_MODE_ULTRA_LOW_POWER, BMP2_FILTER_OFF, INFINITY, INFINITY, INFINITY, INFINITY
+    },
+    [SAMPLING_LEVEL_BALANCED] = {
+        BMP2_OS_MODE_STANDARD_RESOLUTION, BMP2_FILTER_COEFF_2, 1.0f, 0.20f, 0.5f, 0.10f
+    },
+    [SAMPLING_LEVEL_QUIET] = {
+        BMP2_OS_MODE_ULTRA_HIGH_RESOLUTION, BMP2_FILTER_COEFF_8, 0.4f, 0.06f, 0.2f, 0.03f
+    },
+};
+
+/**
+ * @brief Inicjalizuje politykę.
+ *
+ * @param p Wskaźnik do struktury polityki.
+ * @param level Poziom ustawiony w czujnikach przy inicjalizacji.
+ */
+void SAMPLING_Init(SAMPLING_POLICY *p, SAMPLING_Level level)
+{
+    p->level = level;
+    p->target = level;
+    p->pinned = -1;
+    p->calm_ticks = 0;
+    p->since_change = SAMPLING_MIN_INTERVAL;
+    p->changes = 0;
+    p->deferred = 0;
+    p->failures = 0;
+    p->last_us = 0;
+    p->max_us = 0;
+}
+
+/**
+ * @brief Aktualizuje poziom wymagany przez stan regulacji. Wywoływać raz na takt.
+ *
+ * @param p Wskaźnik do struktury polityki.
+ * @param error Uchyb regulacji [°C].
+ * @param rate Szybkość zmian temperatury [°C/s].
+ * @return 1, jeżeli ustawienia czujników należy zmienić na p->target, 0 w przeciwnym wypadku.
+ */
+uint8_t SAMPLING_Update(SAMPLING_POLICY *p, float error, float rate)
+{
+    SAMPLING_Level level = p->level;
+    const SAMPLING_Setting *next;
+
+    error = fabsf(error);
+    rate = fabsf(rate);
+
+    if (p->since_change < SAMPLING_MIN_INTERVAL) {
+        p->since_change++;
+    }
+
+    if (p->pinned >= 0) {
+        p->target = (SAMPLING_Level)p->pinned;
+        p->calm_ticks = 0;
+    }
+    else {
+        // Stan nieustalony: od razu na poziom, którego progi nie są przekroczone
+        while (level > SAMPLING_LEVEL_FAST &&
+               (error > sampling_settings[level].error_stay || rate > sampling_settings[level].rate_stay)) {
+            level--;
+        }
+
+        if (level < p->level) {
+            p->target = level;
+            p->calm_ticks = 0;
+        }
+        else if (p->level + 1 < SAMPLING_LEVELS) {
+            // Stan ustalony: o jeden poziom ciszej po serii spokojnych taktów
+            next = &sampling_settings[p->level + 1];
+            if (error < next->error_enter && rate < next->rate_enter) {
+                if (p->calm_ticks < SAMPLING_CALM_TICKS) {
+                    p->calm_ticks++;
+                }
+            }
+            else {
+                p->calm_ticks = 0;
+            }
+            p->target = (p->calm_ticks >= SAMPLING_CALM_TICKS) ? (SAMPLING_Level)(p->level + 1) : p->level;
+        }
+        else {
+            p->target = p->level;
+        }
+    }
+
+    return p->target != p->level && p->since_change >= SAMPLING_MIN_INTERVAL;
+}
+
+/**
+ * @brief Zapisuje wynik rekonfiguracji czujników.
+ *
+ * @param p Wskaźnik do struktury polityki.
+ * @param ok Czy czujniki przyjęły ustawienia poziomu p->target.
+ * @param duration_us Czas rekonfiguracji [us].
+ */
+void SAMPLING_Applied(SAMPLING_POLICY *p, uint8_t ok, uint32_t duration_us)
+{
+    if (ok) {
+        p->level = p->target;
+        p->changes++;
+    }
+    else {
+        p->failures++;
+    }
+
+    // Odstęp liczony także po błędzie - nieudane próby nie mogą powtarzać się w każdym takcie
+    p->since_change = 0;
+    p->calm_ticks = 0;
+    p->last_us = duration_us;
+    if (duration_us > p->max_us) {
+        p->max_us = duration_us;
+    }
+}
+
+/**
+ * @brief Zlicza rekonfigurację odłożoną do następnego taktu.
+ *
+ * @param p Wskaźnik do struktury polityki.
+ */
+void SAMPLING_Deferred(SAMPLING_POLICY *p)
+{
+    p->deferred++;
+}
+
+/**
+ * @brief Wymusza poziom lub przywraca wybór automatyczny.
+ *
+ * @param p Wskaźnik do struktury polityki.
+ * @param level Poziom (0..SAMPLING_LEVELS-1) lub -1 dla wyboru automatycznego.
+ */
+void SAMPLING_Pin(SAMPLING_POLICY *p, int8_t level)
+{
+    if (level >= (int8_t)SAMPLING_LEVELS) {
+        return;
+    }
+    p->pinned = (level < 0) ? -1 : level;
+    p->calm_ticks = 0;
+}
+
+/**
+ * @brief Zapisuje stan polityki w postaci jednej linii tekstu.
+ *
+ * @param p Wskaźnik do struktury polityki.
+ * @param line Bufor na linię.
+ * @param size Rozmiar bufora.
+ * @return Długość linii (bez znaku końca napisu).
+ */
+int SAMPLING_Format(const SAMPLING_POLICY *p, char *line, size_t size)
+{
+    int len = snprintf(line, size, "P%u %u %d %lu %lu %lu %lu %lu\n",
+                       (unsigned)p->level, (unsigned)p->target, (int)p->pinned,
+                       (unsigned long)p->changes, (unsigned long)p->deferred, (unsigned long)p->failures,
+                       (unsigned long)p->last_us, (unsigned long)p->max_us);
+
+    return (len < (int)size) ? len : (int)size - 1;
+}
@@ -0,0 +1,241 @@
+#include "scope.h"
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @file scope.c
+ * @brief Implementacja rejestratora próbek pętli regulacji (tryb oscyloskopu).
+ *
+ * Bufor jest zapisywany cyklicznie od chwili uzbrojenia. Wyzwolenie jest przyjmowane
+ * dopiero, gdy w buforze zgromadzono co najmniej zadaną liczbę próbek sprzed zdarzenia,
+ * dzięki czemu okno przed wyzwoleniem jest zawsze kompletne. Zapis odbywa się wyłącznie
+ * w przerwaniu regulatora, a odczyt wyłącznie w stanie SCOPE_DONE z pętli głównej.
+ */
+
+static SCOPE_Sample scope_buffer[SCOPE_BUFFER_LEN];
+
+static volatile SCOPE_State scope_state = SCOPE_IDLE;
+static volatile uint8_t scope_trigger_request = 0;
+
+static uint32_t scope_pre;              /**< Liczba próbek sprzed wyzwolenia */
+static uint32_t scope_post;             /**< Liczba próbek po wyzwoleniu */
+static SCOPE_TriggerMode scope_mode;    /**< Warunek wyzwolenia */
+static float scope_level;               /**< Poziom wyzwolenia [°C] */
+
+static volatile uint32_t scope_tick;    /**< Licznik taktów regulatora */
+static SCOPE_Sample scope_last;         /**< Próbka ostatniego taktu (niezależnie od stanu) */
+static uint32_t scope_write_idx;        /**< Indeks następnego zapisu */
+static uint32_t scope_filled;           /**< Liczba ważnych próbek w buforze */
+static uint32_t scope_remaining;        /**< Próbki do zapisania po wyzwoleniu */
+static uint32_t scope_start_idx;        /**< Indeks najstarszej próbki okna */
+
+static uint32_t scope_dump_pos;         /**< Liczba wysłanych próbek */
+static uint8_t scope_dump_header_sent;  /**< Czy nagłówek został już wysłany */
+
+static float scope_prev_measurement;
+static float scope_prev_setpoint;
+
+/**
+ * @brief Inicjalizuje rejestrator.
+ *
+ * Czas obsługi taktu mierzony jest licznikiem cykli DWT uruchamianym przez UTIMER_Init
+ * (licznik nie jest tu zerowany - odmierza też terminy UTIMER).
+ */
+void SCOPE_Init(void)
+{
+    scope_state = SCOPE_IDLE;
+    scope_trigger_request = 0;
+    scope_tick = 0;
+}
+
+/**
+ * @brief Uzbraja rejestrator.
+ *
+ * @param pre Liczba próbek sprzed wyzwolenia.
+ * @param post Liczba próbek po wyzwoleniu (łącznie z próbką wyzwalającą).
+ * @param mode Warunek wyzwolenia.
+ * @param level Poziom temperatury dla wyzwolenia zboczem [°C].
+ * @return HAL_OK lub HAL_ERROR, gdy pre + post przekracza SCOPE_BUFFER_LEN albo post == 0.
+ */
+HAL_StatusTypeDef SCOPE_Arm(uint32_t pre, uint32_t post, SCOPE_TriggerMode mode, float level)
+{
+    if (post == 0 || pre + post > SCOPE_BUFFER_LEN) {
+        return HAL_ERROR;
+    }
+
+    // Zatrzymujemy zapis na czas zmiany konfiguracji
+    scope_state = SCOPE_IDLE;
+
+    scope_pre = pre;
+    scope_post = post;
+    scope_mode = mode;
+    scope_level = level;
+    scope_write_idx = 0;
+    scope_filled = 0;
+    scope_remaining = 0;
+    scope_dump_pos = 0;
+    scope_dump_header_sent = 0;
+    scope_trigger_request = 0;
+
+    scope_state = SCOPE_ARMED;
+    return HAL_OK;
+}
+
+/**
+ * @brief Wymusza wyzwolenie uzbrojonego rejestratora (wykonywane w najbliższym takcie).
+ */
+void SCOPE_Trigger(void)
+{
+    scope_trigger_request = 1;
+}
+
+/**
+ * @brief Przerywa rejestrację lub wysyłanie i wraca do stanu SCOPE_IDLE.
+ */
+void SCOPE_Abort(void)
+{
+    scope_state = SCOPE_IDLE;
+    scope_trigger_request = 0;
+}
+
+/**
+ * @brief Sprawdza, czy bieżąca próbka spełnia warunek wyzwolenia.
+ */
+static uint8_t scope_trigger_condition(float measurement, float setpoint)
+{
+    if (scope_trigger_request) {
+        return 1;
+    }
+
+    switch (scope_mode) {
+    case SCOPE_TRIG_RISING:
+        return (scope_prev_measurement < scope_level) && (measurement >= scope_level);
+    case SCOPE_TRIG_FALLING:
+        return (scope_prev_measurement > scope_level) && (measurement <= scope_level);
+    case SCOPE_TRIG_SETPOINT:
+        return setpoint != scope_prev_setpoint;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Zapisuje próbkę bieżącego taktu. Wywoływana z przerwania regulatora.
+ *
+ * @param pid Wskaźnik do struktury PID (źródło składowych P/I/D i wartości zadanej).
+ * @param measurement Zmierzona temperatura.
+ * @param output Wyjście regulatora.
+ * @param duty Wypełnienie PWM.
+ * @param isr_cycles Czas obsługi taktu w cyklach rdzenia.
+ */
+void SCOPE_Record(const PID *pid, double measurement, double output, int duty, uint32_t isr_cycles)
+{
+    float meas = (float)measurement;
+    float setpoint = (float)pid->setpoint;
+
+    scope_last.tick = scope_tick + 1;
+    scope_last.measurement = meas;
+    scope_last.setpoint = setpoint;
+    scope_last.p_term = (float)pid->p_term;
+    scope_last.i_term = (float)pid->i_term;
+    scope_last.d_term = (float)pid->d_term;
+    scope_last.output = (float)output;
+    scope_last.duty = (uint32_t)duty;
+    scope_last.isr_cycles = isr_cycles;
+    scope_tick++;
+
+    if (scope_state == SCOPE_ARMED || scope_state == SCOPE_TRIGGERED) {
+        scope_buffer[scope_write_idx] = scope_last;
+        scope_write_idx = (scope_write_idx + 1) % SCOPE_BUFFER_LEN;
+        if (scope_filled < SCOPE_BUFFER_LEN) {
+            scope_filled++;
+        }
+
+        if (scope_state == SCOPE_ARMED) {
+            // Wyzwolenie dopiero po zgromadzeniu pełnego okna sprzed zdarzenia
+            if (scope_filled > scope_pre && scope_trigger_condition(meas, setpoint)) {
+                scope_trigger_request = 0;
+                scope_remaining = scope_post - 1;
+                scope_state = SCOPE_TRIGGERED;
+            }
+        } else {
+            scope_remaining--;
+        }
+
+        if (scope_state == SCOPE_TRIGGERED && scope_remaining == 0) {
+            scope_start_idx = (scope_write_idx + SCOPE_BUFFER_LEN - (scope_pre + scope_post)) % SCOPE_BUFFER_LEN;
+            scope_state = SCOPE_DONE;
+        }
+    }
+
+    scope_prev_measurement = meas;
+    scope_prev_setpoint = setpoint;
+}
+
+/**
+ * @brief Kopiuje próbkę ostatniego taktu regulatora.
+ *
+ * @param sample Miejsce na kopię próbki.
+ * @return Numer taktu próbki (0 - brak próbek).
+ */
+uint32_t SCOPE_GetLast(SCOPE_Sample *sample)
+{
+    uint32_t tick;
+
+    // Takt może nadpisać próbkę w trakcie kopiowania - wtedy kopiujemy ponownie
+    do {
+        tick = scope_tick;
+        *sample = scope_last;
+    } while (tick != scope_tick);
+
+    return tick;
+}
+
+/**
+ * @brief Zwraca bieżący stan rejestratora.
+ */
+SCOPE_State SCOPE_GetState(void)
+{
+    return scope_state;
+}
+
+/**
+ * @brief Wysyła kolejną porcję zarejestrowanych danych.
+ *
+ * @param write Funkcja wysyłająca dane.
+ * @return 1, jeżeli pozostały dane do wysłania, 0 w przeciwnym wypadku.
+ */
+uint8_t SCOPE_DumpChunk(SCOPE_WriteFn write)
+{
+    uint32_t total;
+
+    if (scope_state != SCOPE_DONE) {
+        return 0;
+    }
+
+    total = scope_pre + scope_post;
+
+    if (!scope_dump_header_sent) {
+        char header[40];
+        int len = snprintf(header, sizeof(header), "SCOPE %lu %u %lu\n",
+                           (unsigned long)total, (unsigned)sizeof(SCOPE_Sample), (unsigned long)scope_pre);
+        if (write((const uint8_t*)header, (uint16_t)len) == HAL_OK) {
+            scope_dump_header_sent = 1;
+        }
+        return 1;
+    }
+
+    for (uint32_t n = 0; n < SCOPE_DUMP_CHUNK && scope_dump_pos < total; n++) {
+        uint32_t idx = (scope_start_idx + scope_dump_pos) % SCOPE_BUFFER_LEN;
+        if (write((const uint8_t*)&scope_buffer[idx], sizeof(SCOPE_Sample)) != HAL_OK) {
+            break;
+        }
+        scope_dump_pos++;
+    }
+
+    if (scope_dump_pos >= total) {
+        scope_state = SCOPE_IDLE;
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,190 @@
+#include "sensor_health.h"
+#include <math.h>
+#include <stdio.h>
+
+/**
+ * @file sensor_health.c
+ * @brief Implementacja nadzoru toru pomiarowego temperatury.
+ *
+ * Ocena wykonywana jest w przerwaniu po zakończeniu sekwencji odczytu, więc wszystkie
+ * kontrole są proste i mają stały czas wykonania. Błąd transmisji nie powoduje ponowienia
+ * odczytu - czujnik jest pomijany w bieżącym takcie, a kolejna próba następuje w następnym.
+ */
+
+SENSOR_HEALTH sensor_health;
+
+/**
+ * @brief Inicjalizuje nadzór toru pomiarowego.
+ *
+ * @param h Wskaźnik do struktury nadzoru.
+ * @param dt Okres próbkowania w sekundach.
+ */
+void HEALTH_Init(SENSOR_HEALTH *h, double dt)
+{
+    for (uint8_t i = 0; i < BMP2_NUM_OF_SENSORS; i++) {
+        h->sensor[i].last_temp = 0.0;
+        h->sensor[i].has_last = 0;
+        h->sensor[i].faults = 0;
+        h->sensor[i].excluded = 0;
+        h->sensor[i].stuck_ticks = 0;
+        h->sensor[i].good_ticks = 0;
+    }
+    for (uint8_t i = 0; i < HEALTH_FAULT_TYPES; i++) {
+        h->fault_events[i] = 0;
+    }
+
+    h->dt = dt;
+    h->mode = HEALTH_MODE_OK;
+    h->holdover_ticks = 0;
+    h->last_timeouts = 0;
+    h->failover_events = 0;
+    h->holdover_events = 0;
+    h->safe_events = 0;
+}
+
+/**
+ * @brief Zlicza zdarzenia - każda flaga liczona jest tylko przy pojawieniu się błędu.
+ */
+static void health_count_faults(SENSOR_HEALTH *h, uint8_t previous, uint8_t current)
+{
+    uint8_t rising = current & (uint8_t)~previous;
+
+    for (uint8_t i = 0; i < HEALTH_FAULT_TYPES; i++) {
+        if (rising & (1u << i)) {
+            h->fault_events[i]++;
+        }
+    }
+}
+
+/**
+ * @brief Wyznacza flagi błędów czujnika na podstawie bieżącej próbki.
+ */
+static uint8_t health_check_sensor(SENSOR_HEALTH *h, HEALTH_Sensor *s, uint8_t valid, double temp)
+{
+    uint8_t faults = 0;
+
+    if (!valid) {
+        return HEALTH_FAULT_SPI;
+    }
+
+    if (temp < HEALTH_TEMP_MIN || temp > HEALTH_TEMP_MAX) {
+        faults |= HEALTH_FAULT_RANGE;
+    }
+
+    if (s->has_last) {
+        if (fabs(temp - s->last_temp) > HEALTH_MAX_RATE * h->dt) {
+            faults |= HEALTH_FAULT_RATE;
+        }
+
+        if (temp == s->last_temp) {
+            if (s->stuck_ticks < HEALTH_STUCK_TICKS) {
+                s->stuck_ticks++;
+            }
+        } else {
+            s->stuck_ticks = 0;
+        }
+        if (s->stuck_ticks >= HEALTH_STUCK_TICKS) {
+            faults |= HEALTH_FAULT_STUCK;
+        }
+    }
+
+    s->last_temp = temp;
+    s->has_last = 1;
+    return faults;
+}
+
+/**
+ * @brief Ocenia wyniki ostatniej sekwencji odczytu i wyznacza pomiar dla regulatora.
+ *
+ * @param h Wskaźnik do struktury nadzoru.
+ * @param arr Wskaźnik do zestawu czujników po zakończonej sekwencji.
+ * @param measurement Wskaźnik na zmienną, w której zostanie zapisany pomiar.
+ * @return Tryb pracy toru pomiarowego w bieżącym takcie.
+ */
+HEALTH_Mode HEALTH_Evaluate(SENSOR_HEALTH *h, BMP2_ArrayTypeDef *arr, double *measurement)
+{
+    uint8_t healthy = 0;
+    uint8_t timeout = 0;
+    HEALTH_Mode mode;
+    double temp = NAN;
+
+    // Sekwencje przerwane od poprzedniej oceny (nie zmieściły się w takcie)
+    if (arr->TimeoutCount != h->last_timeouts) {
+        h->last_timeouts = arr->TimeoutCount;
+        health_count_faults(h, 0, HEALTH_FAULT_TIMEOUT);
+        timeout = HEALTH_FAULT_TIMEOUT;
+    }
+
+    for (uint8_t i = 0; i < arr->Count; i++) {
+        HEALTH_Sensor *s = &h->sensor[i];
+        uint8_t faults;
+
+        if ((arr->ActiveMask & (1u << i)) == 0) {
+            continue;
+        }
+
+        faults = health_check_sensor(h, s, (arr->ValidMask >> i) & 1u, arr->Temp[i]);
+        health_count_faults(h, s->faults & (uint8_t)~HEALTH_FAULT_TIMEOUT, faults);
+        s->faults = faults | timeout;
+
+        // Czujnik z błędem wraca do fuzji dopiero po serii poprawnych próbek
+        if (faults) {
+            s->excluded = 1;
+            s->good_ticks = 0;
+        } else if (s->excluded && ++s->good_ticks >= HEALTH_RECOVER_TICKS) {
+            s->excluded = 0;
+        }
+
+        if (!s->excluded) {
+            healthy |= (1u << i);
+        }
+    }
+
+    if (healthy) {
+        BMP2_Array_Fuse(arr, healthy, &temp, NULL);
+    }
+
+    if (!isnan(temp)) {
+        *measurement = temp;
+        h->holdover_ticks = 0;
+        mode = (healthy == arr->ActiveMask) ? HEALTH_MODE_OK : HEALTH_MODE_DEGRADED;
+    } else if (h->holdover_ticks < HEALTH_HOLDOVER_TICKS) {
+        h->holdover_ticks++;
+        mode = HEALTH_MODE_HOLDOVER;
+    } else {
+        mode = HEALTH_MODE_SAFE;
+    }
+
+    if (mode != h->mode) {
+        if (mode == HEALTH_MODE_DEGRADED) {
+            h->failover_events++;
+        } else if (mode == HEALTH_MODE_HOLDOVER) {
+            h->holdover_events++;
+        } else if (mode == HEALTH_MODE_SAFE) {
+            h->safe_events++;
+        }
+        h->mode = mode;
+    }
+
+    return mode;
+}
+
+/**
+ * @brief Zapisuje liczniki zdarzeń w postaci jednej linii tekstu.
+ *
+ * @param h Wskaźnik do struktury nadzoru.
+ * @param line Bufor na linię.
+ * @param size Rozmiar bufora.
+ * @return Długość linii (bez znaku końca napisu).
+ */
+int HEALTH_Format(const SENSOR_HEALTH *h, char *line, size_t size)
+{
+    int len = snprintf(line, size, "H%u %lu %lu %lu %lu %lu %lu %lu %lu\n",
+                       (unsigned)h->mode,
+                       (unsigned long)h->fault_events[0], (unsigned long)h->fault_events[1],
+                       (unsigned long)h->fault_events[2], (unsigned long)h->fault_events[3],
+                       (unsigned long)h->fault_events[4], (unsigned long)h->failover_events,
+                       (unsigned long)h->holdover_events, (unsigned long)h->safe_events);
+
+    return (len < (int)size) ? len : (int)size - 1;
+}
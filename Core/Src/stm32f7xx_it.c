@@ -22,6 +22,7 @@
 #include "stm32f7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "latency.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -58,6 +59,10 @@
 extern TIM_HandleTypeDef htim2;
 extern UART_HandleTypeDef huart3;
 /* USER CODE BEGIN EV */
+extern DMA_HandleTypeDef hdma_spi4_rx;
+extern DMA_HandleTypeDef hdma_spi4_tx;
+extern PCD_HandleTypeDef hpcd_USB_OTG_FS;
+extern ETH_HandleTypeDef heth;
 
 /* USER CODE END EV */
 
@@ -171,10 +176,14 @@ void DebugMon_Handler(void)
 void PendSV_Handler(void)
 {
   /* USER CODE BEGIN PendSV_IRQn 0 */
+  /* Lowest priority: control computation deferred from the sensor read completion */
+  uint32_t start = LATENCY_Enter();
 
+  LATENCY_PendSVEntry(start);
+  wykonaj_regulacje();
   /* USER CODE END PendSV_IRQn 0 */
   /* USER CODE BEGIN PendSV_IRQn 1 */
-
+  LATENCY_Exit(LATENCY_PENDSV, start);
   /* USER CODE END PendSV_IRQn 1 */
 }
 
@@ -184,11 +193,11 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  uint32_t start = LATENCY_Enter();
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
-
+  LATENCY_Exit(LATENCY_SYSTICK, start);
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -205,11 +214,17 @@ void SysTick_Handler(void)
 void TIM2_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM2_IRQn 0 */
+  uint32_t start = LATENCY_Enter();
 
+  /* TIM2 counts microseconds from the update event - its value at entry is the entry latency */
+  if (__HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_UPDATE) != RESET)
+  {
+    LATENCY_Entry(LATENCY_TIM2, htim2.Instance->CNT * (SystemCoreClock / 1000000U));
+  }
   /* USER CODE END TIM2_IRQn 0 */
   HAL_TIM_IRQHandler(&htim2);
   /* USER CODE BEGIN TIM2_IRQn 1 */
-
+  LATENCY_Exit(LATENCY_TIM2, start);
   /* USER CODE END TIM2_IRQn 1 */
 }
 
@@ -219,14 +234,58 @@ void TIM2_IRQHandler(void)
 void USART3_IRQHandler(void)
 {
   /* USER CODE BEGIN USART3_IRQn 0 */
-
+  uint32_t start = LATENCY_Enter();
   /* USER CODE END USART3_IRQn 0 */
   HAL_UART_IRQHandler(&huart3);
   /* USER CODE BEGIN USART3_IRQn 1 */
-
+  LATENCY_Exit(LATENCY_USART3, start);
   /* USER CODE END USART3_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles DMA2 stream0 global interrupt (SPI4_RX).
+  */
+void DMA2_Stream0_IRQHandler(void)
+{
+  uint32_t start = LATENCY_Enter();
+
+  HAL_DMA_IRQHandler(&hdma_spi4_rx);
+  LATENCY_Exit(LATENCY_DMA_SPI_RX, start);
+}
+
+/**
+  * @brief This function handles DMA2 stream1 global interrupt (SPI4_TX).
+  */
+void DMA2_Stream1_IRQHandler(void)
+{
+  uint32_t start = LATENCY_Enter();
+
+  HAL_DMA_IRQHandler(&hdma_spi4_tx);
+  LATENCY_Exit(LATENCY_DMA_SPI_TX, start);
+}
+
+/**
+  * @brief This function handles USB On The Go FS global interrupt.
+  */
+void OTG_FS_IRQHandler(void)
+{
+  uint32_t start = LATENCY_Enter();
+
+  HAL_PCD_IRQHandler(&hpcd_USB_OTG_FS);
+  LATENCY_Exit(LATENCY_OTG_FS, start);
+}
+
+/**
+  * @brief This function handles Ethernet global interrupt.
+  */
+void ETH_IRQHandler(void)
+{
+  uint32_t start = LATENCY_Enter();
+
+  HAL_ETH_IRQHandler(&heth);
+  LATENCY_Exit(LATENCY_ETH, start);
+}
+
 /* USER CODE END 1 */
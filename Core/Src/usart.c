@@ -94,7 +94,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
     HAL_GPIO_Init(GPIOD, &GPIO_InitStruct);
 
     /* USART3 interrupt Init */
-    HAL_NVIC_SetPriority(USART3_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(USART3_IRQn, 1, 0);
     HAL_NVIC_EnableIRQ(USART3_IRQn);
   /* USER CODE BEGIN USART3_MspInit 1 */
 
@@ -129,4 +129,62 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief  Zwraca częstotliwość zegara USART (USART3 taktowany z PCLK1, patrz HAL_UART_MspInit).
+  */
+static uint32_t usart_clock(const UART_HandleTypeDef *huart)
+{
+  UNUSED(huart);
+  return HAL_RCC_GetPCLK1Freq();
+}
+
+/**
+  * @brief  Sprawdza, czy prędkość jest osiągalna z zegara USART z błędem nie większym
+  *         niż USART_BAUD_MAX_ERROR_PCT (nadpróbkowanie x16, a powyżej fck/16 - x8).
+  * @param  huart Wskaźnik na strukturę UART.
+  * @param  baud Prędkość transmisji [bit/s].
+  * @retval HAL_OK lub HAL_ERROR
+  */
+HAL_StatusTypeDef USART_CheckBaudRate(const UART_HandleTypeDef *huart, uint32_t baud)
+{
+  uint32_t fck = usart_clock(huart);
+  uint32_t oversampling, div, actual, diff;
+
+  if (baud == 0 || baud > fck / 8)
+  {
+    return HAL_ERROR;
+  }
+
+  oversampling = (baud > fck / 16) ? 8 : 16;
+  div = (fck + baud / 2) / baud;
+  if (div < oversampling || div > 0xFFFF)
+  {
+    return HAL_ERROR;
+  }
+
+  actual = fck / div;
+  diff = (actual > baud) ? actual - baud : baud - actual;
+  return (diff * 100u <= baud * USART_BAUD_MAX_ERROR_PCT) ? HAL_OK : HAL_ERROR;
+}
+
+/**
+  * @brief  Zmienia prędkość transmisji. Przerywa trwający odbiór - wywołujący musi go wznowić.
+  * @note   Wywoływać tylko, gdy nie trwa nadawanie (nadawanie odbywa się w pętli głównej).
+  * @param  huart Wskaźnik na strukturę UART.
+  * @param  baud Prędkość transmisji [bit/s].
+  * @retval HAL_OK lub HAL_ERROR
+  */
+HAL_StatusTypeDef USART_ChangeBaudRate(UART_HandleTypeDef *huart, uint32_t baud)
+{
+  if (USART_CheckBaudRate(huart, baud) != HAL_OK)
+  {
+    return HAL_ERROR;
+  }
+
+  HAL_UART_AbortReceive(huart);
+  huart->Init.BaudRate = baud;
+  huart->Init.OverSampling = (baud > usart_clock(huart) / 16) ? UART_OVERSAMPLING_8 : UART_OVERSAMPLING_16;
+  return HAL_UART_Init(huart);
+}
+
 /* USER CODE END 1 */
@@ -0,0 +1,513 @@
+#include "usb_cdc.h"
+#include <string.h>
+
+/**
+ * @file usb_cdc.c
+ * @brief Implementacja wirtualnego portu szeregowego USB (CDC-ACM) na sterowniku HAL PCD.
+ *
+ * Wszystkie funkcje zwrotne HAL_PCD_* wykonywane są w przerwaniu OTG_FS. Transfery EP0 są
+ * wysyłane pakietami (sterownik OTG ogranicza transfer EP0 do jednego pakietu).
+ */
+
+#define USB_EP0_SIZE            64u
+
+/* Żądania standardowe */
+#define USB_REQ_GET_STATUS          0x00u
+#define USB_REQ_CLEAR_FEATURE       0x01u
+#define USB_REQ_SET_FEATURE         0x03u
+#define USB_REQ_SET_ADDRESS         0x05u
+#define USB_REQ_GET_DESCRIPTOR      0x06u
+#define USB_REQ_GET_CONFIGURATION   0x08u
+#define USB_REQ_SET_CONFIGURATION   0x09u
+#define USB_REQ_GET_INTERFACE       0x0Au
+#define USB_REQ_SET_INTERFACE       0x0Bu
+
+/* Żądania klasy CDC */
+#define CDC_SET_LINE_CODING         0x20u
+#define CDC_GET_LINE_CODING         0x21u
+#define CDC_SET_CONTROL_LINE_STATE  0x22u
+#define CDC_SEND_BREAK              0x23u
+
+#define USB_REQ_TYPE_MASK           0x60u
+#define USB_REQ_TYPE_STANDARD       0x00u
+#define USB_REQ_TYPE_CLASS          0x20u
+#define USB_REQ_RECIPIENT_MASK      0x1Fu
+#define USB_REQ_RECIPIENT_ENDPOINT  0x02u
+
+#define USB_DESC_DEVICE             0x01u
+#define USB_DESC_CONFIGURATION      0x02u
+#define USB_DESC_STRING             0x03u
+
+#define USB_VID                     0x0483u     /* STMicroelectronics */
+#define USB_PID                     0x5740u     /* Virtual COM Port */
+
+#define LOBYTE(x)  ((uint8_t)((x) & 0xFFu))
+#define HIBYTE(x)  ((uint8_t)(((x) >> 8) & 0xFFu))
+
+typedef struct {
+    uint8_t bmRequestType;
+    uint8_t bRequest;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+} USB_Setup;
+
+static const uint8_t usb_device_desc[18] = {
+    0x12, USB_DESC_DEVICE, 0x00, 0x02,          /* USB 2.0 */
+    0x02, 0x00, 0x00,                           /* klasa CDC */
+    USB_EP0_SIZE,
+    LOBYTE(USB_VID), HIBYTE(USB_VID), LOBYTE(USB_PID), HIBYTE(USB_PID),
+    0x00, 0x02,                                 /* bcdDevice */
+    1, 2, 3,                                    /* indeksy napisów */
+    1                                           /* liczba konfiguracji */
+};
+
+#define USB_CONFIG_DESC_LEN 67u
+
+static const uint8_t usb_config_desc[USB_CONFIG_DESC_LEN] = {
+    0x09, USB_DESC_CONFIGURATION, USB_CONFIG_DESC_LEN, 0x00, 2, 1, 0, 0xC0, 50,
+    /* Interfejs 0: zarządzanie CDC (ACM) */
+    0x09, 0x04, 0, 0, 1, 0x02, 0x02, 0x01, 0,
+    0x05, 0x24, 0x00, 0x10, 0x01,               /* Header */
+    0x05, 0x24, 0x01, 0x00, 0x01,               /* Call Management */
+    0x04, 0x24, 0x02, 0x02,                     /* ACM: SET/GET_LINE_CODING, SET_CONTROL_LINE_STATE */
+    0x05, 0x24, 0x06, 0x00, 0x01,               /* Union */
+    0x07, 0x05, CDC_CMD_EP, 0x03, CDC_CMD_PACKET_SIZE, 0x00, 0x10,
+    /* Interfejs 1: dane */
+    0x09, 0x04, 1, 0, 2, 0x0A, 0x00, 0x00, 0,
+    0x07, 0x05, CDC_DATA_OUT_EP, 0x02, CDC_PACKET_SIZE, 0x00, 0x00,
+    0x07, 0x05, CDC_DATA_IN_EP, 0x02, CDC_PACKET_SIZE, 0x00, 0x00
+};
+
+static const char *const usb_strings[] = {
+    NULL,                       /* 0: języki (obsługiwany osobno) */
+    "Politechnika Poznanska",
+    "Uklad regulacji temperatury",
+    NULL                        /* 3: numer seryjny z UID */
+};
+
+static PCD_HandleTypeDef *usb_hpcd;
+static uint8_t usb_configuration = 0;
+static volatile uint8_t cdc_dtr = 0;
+
+/* EP0 */
+static uint8_t usb_ep0_buffer[USB_EP0_SIZE];
+static uint8_t usb_string_buffer[2 + 2 * 32];
+static const uint8_t *usb_ep0_data;
+static uint16_t usb_ep0_remaining;
+static uint8_t usb_ep0_zlp;
+static uint8_t usb_ep0_out_request;
+
+/* Ustawienia linii (przechowywane tylko dla hosta, transmisja USB nie zależy od nich) */
+static uint8_t cdc_line_coding[7] = { 0x80, 0x25, 0x00, 0x00, 0, 0, 8 };  /* 9600 8N1 */
+
+/* Podwójne bufory danych */
+static uint8_t cdc_tx_buffer[2][CDC_TX_BUFFER_LEN];
+static uint16_t cdc_tx_len[2];
+static uint8_t cdc_tx_fill;                     /**< Indeks bufora zapełnianego przez aplikację */
+static volatile uint8_t cdc_tx_busy;            /**< Czy trwa transmisja drugiego bufora */
+static uint8_t cdc_tx_zlp;                      /**< Czy po transferze wysłać pakiet zerowy */
+
+static uint8_t cdc_rx_buffer[2][CDC_PACKET_SIZE];
+static uint8_t cdc_rx_index;
+
+/**
+ * @brief Tworzy deskryptor napisu (UTF-16LE) z napisu ASCII.
+ */
+static uint16_t usb_string_desc(const char *text)
+{
+    uint16_t n = 0;
+
+    while (text[n] != '\0' && n < 32) {
+        usb_string_buffer[2 + 2 * n] = (uint8_t)text[n];
+        usb_string_buffer[3 + 2 * n] = 0;
+        n++;
+    }
+    usb_string_buffer[0] = (uint8_t)(2 + 2 * n);
+    usb_string_buffer[1] = USB_DESC_STRING;
+    return usb_string_buffer[0];
+}
+
+/**
+ * @brief Numer seryjny: 96-bitowy identyfikator układu zapisany szesnastkowo (skrót 48-bitowy).
+ */
+static uint16_t usb_serial_desc(void)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    char serial[13];
+    uint32_t a = HAL_GetUIDw0() + HAL_GetUIDw2();
+    uint32_t b = HAL_GetUIDw1();
+
+    for (int i = 0; i < 8; i++) {
+        serial[i] = hex[(a >> (28 - 4 * i)) & 0xF];
+    }
+    for (int i = 0; i < 4; i++) {
+        serial[8 + i] = hex[(b >> (28 - 4 * i)) & 0xF];
+    }
+    serial[12] = '\0';
+    return usb_string_desc(serial);
+}
+
+static void usb_ep0_stall(void)
+{
+    HAL_PCD_EP_SetStall(usb_hpcd, 0x80);
+    HAL_PCD_EP_SetStall(usb_hpcd, 0x00);
+}
+
+static void usb_ep0_send_status(void)
+{
+    HAL_PCD_EP_Transmit(usb_hpcd, 0x80, NULL, 0);
+}
+
+/**
+ * @brief Wysyła kolejny pakiet fazy danych EP0.
+ */
+static void usb_ep0_continue(void)
+{
+    uint16_t chunk = (usb_ep0_remaining > USB_EP0_SIZE) ? USB_EP0_SIZE : usb_ep0_remaining;
+
+    HAL_PCD_EP_Transmit(usb_hpcd, 0x80, (uint8_t*)usb_ep0_data, chunk);
+    usb_ep0_data += chunk;
+    usb_ep0_remaining -= chunk;
+}
+
+/**
+ * @brief Rozpoczyna fazę danych IN na EP0 (odpowiedź skracana do wLength).
+ */
+static void usb_ep0_send(const uint8_t *data, uint16_t len, uint16_t requested)
+{
+    if (len > requested) {
+        len = requested;
+    }
+    // Krótsza odpowiedź będąca wielokrotnością pakietu musi być zakończona pakietem zerowym
+    usb_ep0_zlp = (len < requested) && (len % USB_EP0_SIZE == 0);
+    usb_ep0_data = data;
+    usb_ep0_remaining = len;
+    usb_ep0_continue();
+}
+
+static void cdc_open_endpoints(void)
+{
+    HAL_PCD_EP_Open(usb_hpcd, CDC_DATA_IN_EP, CDC_PACKET_SIZE, EP_TYPE_BULK);
+    HAL_PCD_EP_Open(usb_hpcd, CDC_DATA_OUT_EP, CDC_PACKET_SIZE, EP_TYPE_BULK);
+    HAL_PCD_EP_Open(usb_hpcd, CDC_CMD_EP, CDC_CMD_PACKET_SIZE, EP_TYPE_INTR);
+
+    cdc_tx_len[0] = cdc_tx_len[1] = 0;
+    cdc_tx_fill = 0;
+    cdc_tx_busy = 0;
+    cdc_tx_zlp = 0;
+    cdc_rx_index = 0;
+    HAL_PCD_EP_Receive(usb_hpcd, CDC_DATA_OUT_EP, cdc_rx_buffer[0], CDC_PACKET_SIZE);
+}
+
+static void cdc_close_endpoints(void)
+{
+    HAL_PCD_EP_Close(usb_hpcd, CDC_DATA_IN_EP);
+    HAL_PCD_EP_Close(usb_hpcd, CDC_DATA_OUT_EP);
+    HAL_PCD_EP_Close(usb_hpcd, CDC_CMD_EP);
+    cdc_tx_busy = 0;
+    cdc_dtr = 0;
+}
+
+/**
+ * @brief Rozpoczyna transmisję zapełnionego bufora i przełącza aplikację na drugi bufor.
+ * @note Wywoływać z wyłączonymi przerwaniami lub z przerwania USB.
+ */
+static void cdc_start_tx(void)
+{
+    uint8_t send = cdc_tx_fill;
+
+    if (cdc_tx_busy || cdc_tx_len[send] == 0) {
+        return;
+    }
+
+    cdc_tx_fill ^= 1u;
+    cdc_tx_len[cdc_tx_fill] = 0;
+    cdc_tx_busy = 1;
+    cdc_tx_zlp = (cdc_tx_len[send] % CDC_PACKET_SIZE) == 0;
+    HAL_PCD_EP_Transmit(usb_hpcd, CDC_DATA_IN_EP, cdc_tx_buffer[send], cdc_tx_len[send]);
+}
+
+static uint8_t usb_standard_request(const USB_Setup *req)
+{
+    switch (req->bRequest) {
+    case USB_REQ_GET_DESCRIPTOR:
+        switch (HIBYTE(req->wValue)) {
+        case USB_DESC_DEVICE:
+            usb_ep0_send(usb_device_desc, sizeof(usb_device_desc), req->wLength);
+            return 1;
+        case USB_DESC_CONFIGURATION:
+            usb_ep0_send(usb_config_desc, sizeof(usb_config_desc), req->wLength);
+            return 1;
+        case USB_DESC_STRING:
+            switch (LOBYTE(req->wValue)) {
+            case 0:
+                usb_string_buffer[0] = 4;
+                usb_string_buffer[1] = USB_DESC_STRING;
+                usb_string_buffer[2] = 0x09;    /* 0x0409: angielski (USA) */
+                usb_string_buffer[3] = 0x04;
+                usb_ep0_send(usb_string_buffer, 4, req->wLength);
+                return 1;
+            case 1:
+            case 2:
+                usb_ep0_send(usb_string_buffer, usb_string_desc(usb_strings[LOBYTE(req->wValue)]), req->wLength);
+                return 1;
+            case 3:
+                usb_ep0_send(usb_string_buffer, usb_serial_desc(), req->wLength);
+                return 1;
+            default:
+                return 0;
+            }
+        default:
+            // Między innymi deskryptor kwalifikatora - urządzenie wyłącznie Full Speed
+            return 0;
+        }
+
+    case USB_REQ_SET_ADDRESS:
+        HAL_PCD_SetAddress(usb_hpcd, (uint8_t)(req->wValue & 0x7F));
+        usb_ep0_send_status();
+        return 1;
+
+    case USB_REQ_SET_CONFIGURATION:
+        if (req->wValue > 1) {
+            return 0;
+        }
+        if (usb_configuration != 0) {
+            cdc_close_endpoints();
+        }
+        usb_configuration = (uint8_t)req->wValue;
+        if (usb_configuration != 0) {
+            cdc_open_endpoints();
+        }
+        usb_ep0_send_status();
+        return 1;
+
+    case USB_REQ_GET_CONFIGURATION:
+        usb_ep0_buffer[0] = usb_configuration;
+        usb_ep0_send(usb_ep0_buffer, 1, req->wLength);
+        return 1;
+
+    case USB_REQ_GET_STATUS:
+        usb_ep0_buffer[0] = 0;
+        usb_ep0_buffer[1] = 0;
+        usb_ep0_send(usb_ep0_buffer, 2, req->wLength);
+        return 1;
+
+    case USB_REQ_GET_INTERFACE:
+        usb_ep0_buffer[0] = 0;
+        usb_ep0_send(usb_ep0_buffer, 1, req->wLength);
+        return 1;
+
+    case USB_REQ_CLEAR_FEATURE:
+        if ((req->bmRequestType & USB_REQ_RECIPIENT_MASK) == USB_REQ_RECIPIENT_ENDPOINT &&
+            (req->wIndex & 0x7F) != 0) {
+            HAL_PCD_EP_ClrStall(usb_hpcd, (uint8_t)req->wIndex);
+        }
+        usb_ep0_send_status();
+        return 1;
+
+    case USB_REQ_SET_FEATURE:
+    case USB_REQ_SET_INTERFACE:
+        usb_ep0_send_status();
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+static uint8_t cdc_class_request(const USB_Setup *req)
+{
+    switch (req->bRequest) {
+    case CDC_SET_LINE_CODING:
+        // Dane przychodzą w fazie OUT - potwierdzenie po ich odebraniu
+        usb_ep0_out_request = CDC_SET_LINE_CODING;
+        HAL_PCD_EP_Receive(usb_hpcd, 0x00, usb_ep0_buffer, sizeof(cdc_line_coding));
+        return 1;
+    case CDC_GET_LINE_CODING:
+        usb_ep0_send(cdc_line_coding, sizeof(cdc_line_coding), req->wLength);
+        return 1;
+    case CDC_SET_CONTROL_LINE_STATE:
+        cdc_dtr = (uint8_t)(req->wValue & 0x01);
+        usb_ep0_send_status();
+        return 1;
+    case CDC_SEND_BREAK:
+        usb_ep0_send_status();
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Uruchamia urządzenie USB (podział FIFO, start PCD).
+ *
+ * @param hpcd Wskaźnik do zainicjalizowanej struktury PCD (MX_USB_OTG_FS_PCD_Init).
+ */
+void CDC_Init(PCD_HandleTypeDef *hpcd)
+{
+    usb_hpcd = hpcd;
+    usb_configuration = 0;
+    cdc_dtr = 0;
+
+    // FIFO OTG_FS: 320 słów łącznie (odbiór wspólny, nadawanie osobno dla każdego EP IN)
+    HAL_PCDEx_SetRxFiFo(hpcd, 0x80);
+    HAL_PCDEx_SetTxFiFo(hpcd, 0, 0x20);
+    HAL_PCDEx_SetTxFiFo(hpcd, CDC_DATA_IN_EP & 0x7F, 0x80);
+    HAL_PCDEx_SetTxFiFo(hpcd, CDC_CMD_EP & 0x7F, 0x10);
+
+    HAL_PCD_Start(hpcd);
+}
+
+/**
+ * @brief Czy host skonfigurował urządzenie i otworzył port (sygnał DTR).
+ */
+uint8_t CDC_IsConnected(void)
+{
+    return usb_configuration != 0 && cdc_dtr;
+}
+
+/**
+ * @brief Umieszcza dane w buforze nadawczym; nie czeka na zakończenie transmisji.
+ *
+ * @param data Dane do wysłania.
+ * @param len Liczba bajtów (co najwyżej CDC_TX_BUFFER_LEN).
+ * @return HAL_OK, HAL_BUSY gdy bufor jest pełny lub HAL_ERROR gdy port nie jest otwarty.
+ */
+HAL_StatusTypeDef CDC_Transmit(const uint8_t *data, uint16_t len)
+{
+    uint32_t primask;
+    uint8_t fill;
+
+    if (!CDC_IsConnected()) {
+        return HAL_ERROR;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    fill = cdc_tx_fill;
+    if (cdc_tx_len[fill] + len > CDC_TX_BUFFER_LEN) {
+        __set_PRIMASK(primask);
+        return HAL_BUSY;
+    }
+    memcpy(&cdc_tx_buffer[fill][cdc_tx_len[fill]], data, len);
+    cdc_tx_len[fill] += len;
+    cdc_start_tx();
+
+    __set_PRIMASK(primask);
+    return HAL_OK;
+}
+
+/**
+ * @brief Wywoływana z przerwania USB po odebraniu pakietu danych.
+ * @note Funkcja słaba, do nadpisania przez aplikację.
+ */
+__weak void CDC_ReceiveCallback(const uint8_t *data, uint32_t len)
+{
+    UNUSED(data);
+    UNUSED(len);
+}
+
+/* Funkcje zwrotne sterownika HAL PCD ----------------------------------------*/
+
+void HAL_PCD_SetupStageCallback(PCD_HandleTypeDef *hpcd)
+{
+    const uint8_t *raw = (const uint8_t*)hpcd->Setup;
+    USB_Setup req;
+
+    req.bmRequestType = raw[0];
+    req.bRequest = raw[1];
+    req.wValue = (uint16_t)(raw[2] | (raw[3] << 8));
+    req.wIndex = (uint16_t)(raw[4] | (raw[5] << 8));
+    req.wLength = (uint16_t)(raw[6] | (raw[7] << 8));
+
+    usb_ep0_remaining = 0;
+    usb_ep0_zlp = 0;
+    usb_ep0_out_request = 0;
+
+    switch (req.bmRequestType & USB_REQ_TYPE_MASK) {
+    case USB_REQ_TYPE_STANDARD:
+        if (!usb_standard_request(&req)) {
+            usb_ep0_stall();
+        }
+        break;
+    case USB_REQ_TYPE_CLASS:
+        if (!cdc_class_request(&req)) {
+            usb_ep0_stall();
+        }
+        break;
+    default:
+        usb_ep0_stall();
+        break;
+    }
+}
+
+void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
+{
+    if (epnum == 0) {
+        if (usb_ep0_remaining > 0) {
+            usb_ep0_continue();
+        } else if (usb_ep0_zlp) {
+            usb_ep0_zlp = 0;
+            HAL_PCD_EP_Transmit(hpcd, 0x80, NULL, 0);
+        } else if (usb_ep0_data != NULL) {
+            // Koniec fazy danych - faza statusu (pakiet zerowy od hosta)
+            usb_ep0_data = NULL;
+            HAL_PCD_EP_Receive(hpcd, 0x00, NULL, 0);
+        }
+        return;
+    }
+
+    if (epnum == (CDC_DATA_IN_EP & 0x7F)) {
+        if (cdc_tx_zlp) {
+            cdc_tx_zlp = 0;
+            HAL_PCD_EP_Transmit(hpcd, CDC_DATA_IN_EP, NULL, 0);
+            return;
+        }
+        cdc_tx_busy = 0;
+        cdc_start_tx();
+    }
+}
+
+void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum)
+{
+    if (epnum == 0) {
+        if (usb_ep0_out_request == CDC_SET_LINE_CODING) {
+            memcpy(cdc_line_coding, usb_ep0_buffer, sizeof(cdc_line_coding));
+            usb_ep0_out_request = 0;
+            usb_ep0_send_status();
+        }
+        return;
+    }
+
+    if (epnum == CDC_DATA_OUT_EP) {
+        uint32_t len = HAL_PCD_EP_GetRxCount(hpcd, CDC_DATA_OUT_EP);
+        const uint8_t *data = cdc_rx_buffer[cdc_rx_index];
+
+        // Odbiór kolejnego pakietu do drugiego bufora przed przetworzeniem bieżącego
+        cdc_rx_index ^= 1u;
+        HAL_PCD_EP_Receive(hpcd, CDC_DATA_OUT_EP, cdc_rx_buffer[cdc_rx_index], CDC_PACKET_SIZE);
+        CDC_ReceiveCallback(data, len);
+    }
+}
+
+void HAL_PCD_ResetCallback(PCD_HandleTypeDef *hpcd)
+{
+    if (usb_configuration != 0) {
+        cdc_close_endpoints();
+    }
+    usb_configuration = 0;
+    cdc_dtr = 0;
+
+    HAL_PCD_EP_Open(hpcd, 0x00, USB_EP0_SIZE, EP_TYPE_CTRL);
+    HAL_PCD_EP_Open(hpcd, 0x80, USB_EP0_SIZE, EP_TYPE_CTRL);
+}
+
+void HAL_PCD_DisconnectCallback(PCD_HandleTypeDef *hpcd)
+{
+    UNUSED(hpcd);
+    usb_configuration = 0;
+    cdc_dtr = 0;
+    cdc_tx_busy = 0;
+}
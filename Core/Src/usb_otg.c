@@ -101,6 +101,9 @@ void HAL_PCD_MspInit(PCD_HandleTypeDef* pcdHandle)
     /* USB_OTG_FS clock enable */
     __HAL_RCC_USB_OTG_FS_CLK_ENABLE();
   /* USER CODE BEGIN USB_OTG_FS_MspInit 1 */
+    /* USB_OTG_FS interrupt Init */
+    HAL_NVIC_SetPriority(OTG_FS_IRQn, IRQ_PRIO_USB, 0);
+    HAL_NVIC_EnableIRQ(OTG_FS_IRQn);
 
   /* USER CODE END USB_OTG_FS_MspInit 1 */
   }
@@ -128,6 +131,8 @@ void HAL_PCD_MspDeInit(PCD_HandleTypeDef* pcdHandle)
                           |USB_DP_Pin);
 
   /* USER CODE BEGIN USB_OTG_FS_MspDeInit 1 */
+    /* USB_OTG_FS interrupt Deinit */
+    HAL_NVIC_DisableIRQ(OTG_FS_IRQn);
 
   /* USER CODE END USB_OTG_FS_MspDeInit 1 */
   }
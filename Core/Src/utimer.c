@@ -0,0 +1,325 @@
+#include "utimer.h"
+
+/**
+ * @file utimer.c
+ * @brief Implementacja mikrosekundowych opóźnień, terminów i wywołań jednorazowych.
+ *
+ * Terminy przechowywane są w cyklach rdzenia względem chwili ustawienia, więc porównanie
+ * (teraz - start) >= cykle jest poprawne także po przepełnieniu licznika. Kanał porównania
+ * jest ustawiany na najbliższy termin, a jeżeli ten wypada po końcu okresu licznika -
+ * na koniec okresu, po czym termin jest przeliczany ponownie.
+ */
+
+typedef struct {
+    UTIMER_Deadline deadline;
+    UTIMER_Callback callback;
+    void *ctx;
+} UTIMER_Slot;
+
+static TIM_HandleTypeDef *utimer_htim;
+static uint32_t utimer_it;                      /**< Flaga przerwania kanału (TIM_IT_CCx) */
+static uint32_t utimer_egr;                     /**< Bit programowego zdarzenia kanału (TIM_EGR_CCxG) */
+static uint32_t utimer_channel;
+static UTIMER_Slot utimer_slots[UTIMER_SLOTS];
+
+/**
+ * @brief Uruchamia licznik cykli rdzenia, jeżeli jeszcze nie działa.
+ */
+static void utimer_start_counter(void)
+{
+    if (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) {
+        return;
+    }
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**
+ * @brief Liczba cykli rdzenia na mikrosekundę.
+ */
+static uint32_t utimer_cycles_per_us(void)
+{
+    return SystemCoreClock / 1000000u;
+}
+
+/**
+ * @brief Przelicza mikrosekundy na cykle z ograniczeniem do UTIMER_MAX_CYCLES.
+ */
+static uint32_t utimer_us_to_cycles(uint32_t us)
+{
+    uint32_t per_us = utimer_cycles_per_us();
+
+    return (us > UTIMER_MAX_CYCLES / per_us) ? UTIMER_MAX_CYCLES : us * per_us;
+}
+
+/**
+ * @brief Cykle pozostałe do terminu (0, jeżeli minął).
+ */
+static uint32_t utimer_remaining(const UTIMER_Deadline *d, uint32_t now)
+{
+    uint32_t elapsed = now - d->start;
+
+    return (elapsed >= d->cycles) ? 0u : d->cycles - elapsed;
+}
+
+/**
+ * @brief Ustawia kanał porównania na najbliższy termin. Wywoływać przy wyłączonych przerwaniach.
+ */
+static void utimer_schedule(void)
+{
+    TIM_TypeDef *tim;
+    uint32_t now = DWT->CYCCNT;
+    uint32_t next = UINT32_MAX;
+    uint32_t period, delta, cnt;
+
+    if (utimer_htim == NULL) {
+        return;
+    }
+    tim = utimer_htim->Instance;
+
+    for (uint32_t i = 0; i < UTIMER_SLOTS; i++) {
+        if (utimer_slots[i].callback != NULL) {
+            uint32_t rem = utimer_remaining(&utimer_slots[i].deadline, now);
+            if (rem < next) {
+                next = rem;
+            }
+        }
+    }
+
+    if (next == UINT32_MAX) {
+        __HAL_TIM_DISABLE_IT(utimer_htim, utimer_it);
+        return;
+    }
+
+    // Zaokrąglenie w górę - przerwanie nie może wyprzedzić terminu liczonego w cyklach
+    delta = (next + utimer_cycles_per_us() - 1u) / utimer_cycles_per_us();
+    period = tim->ARR + 1u;
+    if (delta >= period) {
+        delta = period - 1u;
+    }
+    if (delta < UTIMER_MIN_LEAD_US) {
+        delta = UTIMER_MIN_LEAD_US;
+    }
+
+    cnt = tim->CNT;
+    __HAL_TIM_CLEAR_FLAG(utimer_htim, utimer_it);
+    __HAL_TIM_SET_COMPARE(utimer_htim, utimer_channel, (cnt + delta) % period);
+    __HAL_TIM_ENABLE_IT(utimer_htim, utimer_it);
+
+    // Licznik minął wartość porównania przed jej zapisaniem - zdarzenie generowane programowo
+    if ((tim->CNT + period - cnt) % period >= delta) {
+        tim->EGR = utimer_egr;
+    }
+}
+
+/**
+ * @brief Uruchamia licznik cykli i przypisuje kanał porównania do wywołań jednorazowych.
+ *
+ * @param htim Licznik taktujący mikrosekundami.
+ * @param channel Kanał porównania (TIM_CHANNEL_x) skonfigurowany w trybie TIM_OCMODE_TIMING.
+ */
+void UTIMER_Init(TIM_HandleTypeDef *htim, uint32_t channel)
+{
+    utimer_start_counter();
+
+    for (uint32_t i = 0; i < UTIMER_SLOTS; i++) {
+        utimer_slots[i].callback = NULL;
+    }
+
+    // TIM_CHANNEL_1..4 = 0x0, 0x4, 0x8, 0xC; flagi i zdarzenia kanałów to kolejne bity od CC1
+    utimer_channel = channel;
+    utimer_it = TIM_IT_CC1 << (channel >> 2);
+    utimer_egr = TIM_EGR_CC1G << (channel >> 2);
+    utimer_htim = htim;
+    __HAL_TIM_DISABLE_IT(htim, utimer_it);
+}
+
+/**
+ * @brief Zwraca stan licznika cykli rdzenia.
+ */
+uint32_t UTIMER_Cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief Przelicza cykle rdzenia na mikrosekundy.
+ */
+uint32_t UTIMER_CyclesToUs(uint32_t cycles)
+{
+    return cycles / utimer_cycles_per_us();
+}
+
+/**
+ * @brief Czeka aktywnie podaną liczbę mikrosekund.
+ *
+ * @param us Czas oczekiwania [us].
+ */
+void UTIMER_DelayUs(uint32_t us)
+{
+    uint32_t per_us, chunk;
+    UTIMER_Deadline d;
+
+    utimer_start_counter();
+    per_us = utimer_cycles_per_us();
+
+    while (us > 0u) {
+        chunk = (us > UTIMER_MAX_CYCLES / per_us) ? UTIMER_MAX_CYCLES / per_us : us;
+        UTIMER_DeadlineSet(&d, chunk);
+        while (!UTIMER_DeadlineExpired(&d)) {
+        }
+        us -= chunk;
+    }
+}
+
+/**
+ * @brief Ustawia termin za podaną liczbę mikrosekund (ograniczoną do UTIMER_MAX_CYCLES).
+ *
+ * @param d Termin.
+ * @param us Czas do terminu [us].
+ */
+void UTIMER_DeadlineSet(UTIMER_Deadline *d, uint32_t us)
+{
+    d->start = DWT->CYCCNT;
+    d->cycles = utimer_us_to_cycles(us);
+}
+
+/**
+ * @brief Sprawdza, czy termin minął.
+ *
+ * @param d Termin.
+ * @return 1, jeżeli termin minął, 0 w przeciwnym wypadku.
+ */
+uint8_t UTIMER_DeadlineExpired(const UTIMER_Deadline *d)
+{
+    return (DWT->CYCCNT - d->start) >= d->cycles;
+}
+
+/**
+ * @brief Zwraca czas pozostały do terminu.
+ *
+ * @param d Termin.
+ * @return Czas do terminu [us], 0 jeżeli termin minął.
+ */
+uint32_t UTIMER_DeadlineRemainingUs(const UTIMER_Deadline *d)
+{
+    return utimer_remaining(d, DWT->CYCCNT) / utimer_cycles_per_us();
+}
+
+/**
+ * @brief Planuje jednorazowe wywołanie funkcji po podanym czasie.
+ *
+ * @param us Czas do wywołania [us] (ograniczony do UTIMER_MAX_CYCLES).
+ * @param callback Funkcja wywoływana w przerwaniu licznika.
+ * @param ctx Argument funkcji.
+ * @return Numer wywołania (do UTIMER_Cancel) lub -1, gdy brak wolnego miejsca.
+ */
+int8_t UTIMER_Start(uint32_t us, UTIMER_Callback callback, void *ctx)
+{
+    uint32_t primask;
+    int8_t id = -1;
+
+    if (callback == NULL) {
+        return -1;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0; i < UTIMER_SLOTS; i++) {
+        if (utimer_slots[i].callback == NULL) {
+            UTIMER_DeadlineSet(&utimer_slots[i].deadline, us);
+            utimer_slots[i].callback = callback;
+            utimer_slots[i].ctx = ctx;
+            id = (int8_t)i;
+            break;
+        }
+    }
+    if (id >= 0) {
+        utimer_schedule();
+    }
+    __set_PRIMASK(primask);
+
+    return id;
+}
+
+/**
+ * @brief Odwołuje zaplanowane wywołanie. Wywołanie już wykonane jest ignorowane.
+ *
+ * @param id Numer zwrócony przez UTIMER_Start.
+ */
+void UTIMER_Cancel(int8_t id)
+{
+    uint32_t primask;
+
+    if (id < 0 || (uint32_t)id >= UTIMER_SLOTS) {
+        return;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    utimer_slots[id].callback = NULL;
+    utimer_schedule();
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Zwraca czas do najbliższego zaplanowanego wywołania.
+ *
+ * @return Czas [us] lub UINT32_MAX, gdy nic nie jest zaplanowane.
+ */
+uint32_t UTIMER_NextExpiryUs(void)
+{
+    uint32_t now = DWT->CYCCNT;
+    uint32_t next = UINT32_MAX;
+
+    for (uint32_t i = 0; i < UTIMER_SLOTS; i++) {
+        if (utimer_slots[i].callback != NULL) {
+            uint32_t rem = utimer_remaining(&utimer_slots[i].deadline, now);
+            if (rem < next) {
+                next = rem;
+            }
+        }
+    }
+    return (next == UINT32_MAX) ? UINT32_MAX : next / utimer_cycles_per_us();
+}
+
+/**
+ * @brief Obsługa przerwania porównania. Wywoływać z HAL_TIM_OC_DelayElapsedCallback.
+ *
+ * @param htim Licznik, który zgłosił przerwanie (inne kanały i liczniki są ignorowane).
+ */
+void UTIMER_CompareCallback(TIM_HandleTypeDef *htim)
+{
+    uint32_t primask;
+
+    if (htim != utimer_htim
+        || htim->Channel != (HAL_TIM_ActiveChannel)(HAL_TIM_ACTIVE_CHANNEL_1 << (utimer_channel >> 2))) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < UTIMER_SLOTS; i++) {
+        UTIMER_Callback callback;
+        void *ctx;
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+        callback = utimer_slots[i].callback;
+        ctx = utimer_slots[i].ctx;
+        if (callback == NULL || utimer_remaining(&utimer_slots[i].deadline, DWT->CYCCNT) != 0u) {
+            __set_PRIMASK(primask);
+            continue;
+        }
+        // Miejsce zwalniane przed wywołaniem - funkcja może zaplanować się ponownie
+        utimer_slots[i].callback = NULL;
+        __set_PRIMASK(primask);
+
+        callback(ctx);
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    utimer_schedule();
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,184 @@
+import csv
+import os
+import struct
+import threading
+import time
+from datetime import datetime
+
+import tsdb
+
+# Format binarny: nagłówek pliku, a następnie rekordy o stałej długości (little-endian)
+BIN_MAGIC = b"PPLOG1\n\0"
+BIN_RECORD = struct.Struct("<dff")  # czas UNIX [s], wartość aktualna, wartość zadana
+
+DEFAULT_FLUSH_PERIOD_S = 1.0           # maksymalny czas przebywania danych w pamięci
+DEFAULT_MAX_BYTES = 64 * 1024 * 1024   # rotacja po przekroczeniu rozmiaru pliku
+DEFAULT_MAX_AGE_S = 24 * 3600          # rotacja po czasie
+
+
+class _CsvWriter:
+    extension = ".csv"
+
+    def __init__(self, path):
+        self.file = open(path, mode="a", newline="")
+        self.writer = csv.writer(self.file)
+
+    def write(self, rows):
+        self.writer.writerows(
+            (datetime.fromtimestamp(t).strftime("%Y-%m-%d %H:%M:%S.%f")[:-3], a, z) for t, a, z in rows)
+
+    def tell(self):
+        return self.file.tell()
+
+    def flush(self):
+        self.file.flush()
+
+    def close(self):
+        self.file.close()
+
+
+class _BinaryWriter:
+    extension = ".bin"
+
+    def __init__(self, path):
+        self.file = open(path, mode="ab")
+        if self.file.tell() == 0:
+            self.file.write(BIN_MAGIC)
+
+    def write(self, rows):
+        self.file.write(b"".join(BIN_RECORD.pack(*row) for row in rows))
+
+    def tell(self):
+        return self.file.tell()
+
+    def flush(self):
+        self.file.flush()
+
+    def close(self):
+        self.file.close()
+
+
+class _TimeSeriesWriter:
+    """Skompresowany format kolumnowy (tsdb); czas zapisywany w milisekundach.
+
+    flush() zapisuje także niepełny blok, więc po awarii lub odłączeniu tracone są tylko
+    próbki z ostatniego okresu zapisu. Blok ten jest nadpisywany przy kolejnych zapisach
+    aż do zapełnienia, więc kompresja jest taka sama jak bez okresowego zapisu.
+    """
+    extension = ".ts"
+    channels = ("aktualna", "zadana")
+
+    def __init__(self, path):
+        self.writer = tsdb.Writer(path, self.channels)
+
+    def write(self, rows):
+        for t, a, z in rows:
+            self.writer.append(int(round(t * 1000)), a, z)
+
+    def tell(self):
+        return self.writer.tell()
+
+    def flush(self):
+        self.writer.flush(partial=True)
+
+    def close(self):
+        self.writer.close()
+
+
+WRITERS = {"csv": _CsvWriter, "bin": _BinaryWriter, "ts": _TimeSeriesWriter}
+
+
+class DataLogger(threading.Thread):
+    """Rejestrator próbek zapisujący dane porcjami w wątku tła.
+
+    Metoda log() jedynie dopisuje próbkę do listy w pamięci. Wątek co flush_period sekund
+    przejmuje zgromadzoną porcję, zapisuje ją jednym wywołaniem do otwartego pliku i opróżnia
+    bufory systemowe. Nowy plik (z datą w nazwie) zakładany jest po przekroczeniu max_bytes
+    lub max_age_s.
+    """
+
+    def __init__(self, directory=".", prefix="dane", fmt="bin", flush_period=DEFAULT_FLUSH_PERIOD_S,
+                 max_bytes=DEFAULT_MAX_BYTES, max_age_s=DEFAULT_MAX_AGE_S):
+        super().__init__(daemon=True)
+        if fmt not in WRITERS:
+            raise ValueError(f"Nieznany format zapisu: {fmt}")
+        self.directory = directory
+        self.prefix = prefix
+        self.writer_class = WRITERS[fmt]
+        self.flush_period = flush_period
+        self.max_bytes = max_bytes
+        self.max_age_s = max_age_s
+
+        self.pending = []
+        self.lock = threading.Lock()
+        self.wakeup = threading.Event()
+        self.running = threading.Event()
+        self.writer = None
+        self.opened_at = 0.0
+        self.path = None
+        self.file_index = 0
+        self.written = 0
+        self.errors = 0
+
+    def log(self, timestamp, actual_value, desired_value):
+        with self.lock:
+            self.pending.append((timestamp, actual_value, desired_value))
+
+    def start(self):
+        self.running.set()
+        super().start()
+
+    def stop(self, timeout=2.0):
+        """Zapisuje pozostałe dane i zamyka plik."""
+        self.running.clear()
+        self.wakeup.set()
+        if self.is_alive():
+            self.join(timeout)
+
+    def _open(self):
+        # Numer kolejny rozróżnia pliki założone w tej samej sekundzie
+        name = (f"{self.prefix}_{datetime.now().strftime('%Y%m%d_%H%M%S')}_{self.file_index:03d}"
+                f"{self.writer_class.extension}")
+        self.file_index += 1
+        self.path = os.path.join(self.directory, name)
+        self.writer = self.writer_class(self.path)
+        self.opened_at = time.monotonic()
+
+    def _rotate_if_needed(self):
+        if self.writer is None:
+            self._open()
+        elif self.writer.tell() >= self.max_bytes or time.monotonic() - self.opened_at >= self.max_age_s:
+            self.writer.close()
+            self._open()
+
+    def _write_pending(self):
+        with self.lock:
+            rows, self.pending = self.pending, []
+        if not rows:
+            return
+        try:
+            self._rotate_if_needed()
+            self.writer.write(rows)
+            self.writer.flush()
+            self.written += len(rows)
+        except OSError as e:
+            self.errors += 1
+            print(f"Błąd zapisu danych: {e}")
+
+    def run(self):
+        while self.running.is_set():
+            self.wakeup.wait(self.flush_period)
+            self._write_pending()
+        self._write_pending()
+        if self.writer is not None:
+            self.writer.close()
+
+
+def read_binary(path):
+    """Wczytuje plik w formacie binarnym; zwraca listę krotek (czas, aktualna, zadana)."""
+    with open(path, "rb") as file:
+        if file.read(len(BIN_MAGIC)) != BIN_MAGIC:
+            raise ValueError(f"{path}: nieprawidłowy nagłówek pliku")
+        data = file.read()
+    usable = len(data) - len(data) % BIN_RECORD.size  # pomijamy niepełny ostatni rekord
+    return list(BIN_RECORD.iter_unpack(data[:usable]))
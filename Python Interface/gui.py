@@ -1,33 +1,43 @@
-import csv
+import threading
 from tkinter import *
 import customtkinter
 import serial
+import serial_reader
+import live_plot
+import data_logger
 from PIL import Image, ImageTk
 from datetime import datetime
 from matplotlib.figure import Figure
 from matplotlib.backends.backend_tkagg import FigureCanvasTkAgg
 
-# Inicjalizacja portu szeregowego
+# Inicjalizacja portu szeregowego; zamiast portu można podać adres kolektora telemetrii
+# (Tools/collector), np. "socket://localhost:5760", aby współdzielić sterownik z innymi programami
+SERIAL_PORT = "COM3"
+# Prędkość uzgadniana ze sterownikiem po otwarciu portu (połączenie zawsze startuje z 9600);
+# None wyłącza negocjację. Nie dotyczy połączenia przez kolektor - prędkość ustawia kolektor.
+TARGET_BAUD = 115200
 try:
-    ser = serial.Serial(port="COM3", baudrate=9600, timeout=1)
+    ser = serial.serial_for_url(SERIAL_PORT, baudrate=9600, timeout=1)
 except serial.SerialException as e:
-    print(f"Nie udało się otworzyć portu COM3: {e}")
+    print(f"Nie udało się otworzyć portu {SERIAL_PORT}: {e}")
     ser = None
 
-# Globalne zmienne do przechowywania danych dla wykresu
-times = []  # Czas
-actual_values = []  # Wartości aktualne
+# Okres odświeżania interfejsu [ms] - dane z wątku odczytu pobierane są porcjami
+REFRESH_PERIOD_MS = 100
+reader = None
+
+# Okres taktu rysowania wykresu [ms]; liczba klatek i tak ograniczona przez live_plot
+PLOT_PERIOD_MS = 50
+
+# Globalne zmienne do przechowywania ostatnich wartości
+actual_value = None  # Wartość aktualna
 desired_value = None  # Wartość zadana
 
-# Funkcja zapisu danych do pliku CSV
-def save_to_csv(time, actual_value, desired_value):
-    try:
-        with open('dane.csv', mode='a', newline='') as file:
-            writer = csv.writer(file)
-            writer.writerow([time, actual_value, desired_value])
-            print(f"Zapisano do pliku CSV: {time}, {actual_value}, {desired_value}")
-    except Exception as e:
-        print(f"Błąd zapisu do pliku CSV: {e}")
+# Zapis danych: porcjami w wątku tła ("ts" - skompresowany format kolumnowy tsdb,
+# "bin" - rekordy binarne o stałej długości, "csv" - tekstowy)
+LOG_FORMAT = "ts"
+logger = data_logger.DataLogger(prefix="dane", fmt=LOG_FORMAT)
+logger.start()
 
 # Funkcja obsługująca kliknięcie przycisku wysyłającego
 def button_callback():
@@ -36,67 +46,68 @@ def button_callback():
             value = entry.get()
             if value.isdigit() or value.replace(".", "", 1).isdigit():
                 ser.write(f"Z{value}\n".encode())
-                print(f"Wiadomość 'Z{value}' wysłana przez port COM3.")
+                print(f"Wiadomość 'Z{value}' wysłana przez port {SERIAL_PORT}.")
             else:
                 print("Proszę wpisać poprawną wartość liczbową.")
         except serial.SerialException as e:
             print(f"Błąd podczas wysyłania wiadomości: {e}")
     else:
-        print("Port COM3 nie jest otwarty.")
+        print(f"Port {SERIAL_PORT} nie jest otwarty.")
 
-# Funkcja przetwarzająca dane z portu szeregowego
-def process_serial_data(data):
-    global desired_value
+# Funkcja przetwarzająca jedną linię z portu szeregowego; zwraca True dla poprawnej próbki
+def process_serial_data(data, timestamp):
+    global desired_value, actual_value
     try:
         if data.startswith("Z") and "A" in data:
             zadana = float(data.split("A")[0][1:])  # Wartość po 'Z', przed 'A'
             aktualna = float(data.split("A")[1])   # Wartość po 'A'
             desired_value = zadana  # Aktualizacja wartości zadanej
+            actual_value = aktualna
 
-            # Aktualizacja etykiet
-            label_zadana.configure(text=f"Wartość zadana: {zadana}")
-            label_aktualna.configure(text=f"Wartość aktualna: {aktualna}")
+            # Aktualizacja danych dla wykresu (czas odbioru, a nie czas przetworzenia)
+            plot.add(timestamp, aktualna, zadana)
 
-            # Aktualizacja danych dla wykresu
-            current_time = datetime.now().strftime("%H:%M:%S")
-            times.append(current_time)
-            actual_values.append(aktualna)
-
-            # Zapisz dane do pliku CSV
-            save_to_csv(current_time, aktualna, desired_value)
-
-            update_plot()
+            # Zapis danych (wyłącznie dopisanie do bufora, plik zapisywany w tle)
+            logger.log(timestamp, aktualna, zadana)
+            return True
         else:
             print(f"Nieprawidłowy format danych: {data}")
     except Exception as e:
         print(f"Błąd przetwarzania danych: {e}")
+    return False
+
+# Zapis rejestratora (nagłówek SCOPE + blok binarny)
+scope_capture = None
+
+def process_scope_data(capture):
+    global scope_capture
+    scope_capture = capture
+    count, size, pre, _ = capture
+    print(f"Odebrano zapis rejestratora: {count} próbek po {size} B, {pre} przed wyzwoleniem")
 
-# Funkcja do odczytu danych z portu szeregowego z wykorzystaniem after()
+# Pobieranie porcji danych z wątku odczytu w takcie odświeżania interfejsu
 def read_serial():
-    if ser and ser.is_open:
-        try:
-            if ser.in_waiting > 0:  # Sprawdzanie, czy są dane na porcie
-                data = ser.readline().decode().strip()
-                if data:
-                    process_serial_data(data)
-        except serial.SerialException as e:
-            print(f"Błąd podczas odczytu danych: {e}")
-        except Exception as e:
-            print(f"Nieoczekiwany błąd: {e}")
-    app.after(500, read_serial)  # Wywołanie co 500 ms
+    new_samples = False
+    for kind, timestamp, payload in reader.drain():
+        if kind == serial_reader.LINE:
+            new_samples |= process_serial_data(payload, timestamp)
+        elif kind == serial_reader.SCOPE:
+            process_scope_data(payload)
+
+    if new_samples:
+        # Etykiety odświeżane raz na porcję, z ostatnią wartością
+        label_zadana.configure(text=f"Wartość zadana: {desired_value}")
+        label_aktualna.configure(text=f"Wartość aktualna: {actual_value}")
+
+    if reader.is_alive():
+        app.after(REFRESH_PERIOD_MS, read_serial)
+    else:
+        print("Wątek odczytu portu zakończony.")
 
-# Aktualizacja wykresu
+# Aktualizacja wykresu - takt niezależny od tempa napływu danych
 def update_plot():
-    ax.clear()
-    ax.plot(times, actual_values, label="Wartość aktualna", marker='o')
-    if desired_value is not None:
-        ax.axhline(y=desired_value, color='r', linestyle='--', label=f"Wartość zadana ({desired_value})")
-    ax.legend()
-    ax.set_title("Wykres wartości aktualnej")
-    ax.set_xlabel("Czas")
-    ax.set_ylabel("Wartość")
-    ax.grid()
-    canvas.draw()
+    plot.tick()
+    app.after(PLOT_PERIOD_MS, update_plot)
 
 # Okno aplikacji
 app = customtkinter.CTk()
@@ -151,17 +162,34 @@ fig = Figure(figsize=(8, 4), dpi=100)
 ax = fig.add_subplot(111)
 canvas = FigureCanvasTkAgg(fig, master=app)
 canvas.get_tk_widget().place(relx=0.5, rely=0.8, anchor="center", width=900, height=300)
+plot = live_plot.LivePlot(canvas, ax)
+update_plot()
 
 # Zamknięcie portu szeregowego
 def close_port():
+    if reader:
+        reader.stop()
     if ser and ser.is_open:
         ser.close()
         print("Port COM zamknięty.")
+    logger.stop()
+    app.destroy()
 
 app.protocol("WM_DELETE_WINDOW", close_port)
 
 # Uruchomienie odczytu z portu szeregowego
 if ser and ser.is_open:
+    reader = serial_reader.SerialReader(ser)
+    reader.start()
     read_serial()
 
+    if TARGET_BAUD and isinstance(ser, serial.Serial):
+        def negotiate():
+            if reader.negotiate_baud(TARGET_BAUD):
+                print(f"Prędkość transmisji: {TARGET_BAUD}")
+            else:
+                print(f"Nie udało się uzgodnić prędkości {TARGET_BAUD}, pozostaje {ser.baudrate}")
+
+        threading.Thread(target=negotiate, daemon=True).start()
+
 app.mainloop()
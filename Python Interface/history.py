@@ -0,0 +1,205 @@
+import numpy as np
+
+# Domyślna konfiguracja magazynu historii
+DEFAULT_RAW_CAPACITY = 1_000_000   # liczba przechowywanych surowych próbek
+DEFAULT_LEVEL_CAPACITY = 262_144   # liczba przechowywanych kubełków na poziom
+DEFAULT_FACTOR = 16                # liczba elementów poziomu niższego w kubełku
+DEFAULT_LEVELS = 4                 # kubełki po 16, 256, 4096 i 65536 próbek
+LTTB_MAX_RATIO = 8                 # LTTB na surowych danych do 8x max_points
+RAW_MINMAX_MAX_RATIO = 64          # obwiednia min/max z surowych danych do 64x max_points
+
+
+class _Columns:
+    """Kolumny numpy o stałej pojemności; po zapełnieniu odrzucana jest najstarsza połowa.
+
+    Tablice mają podwójną pojemność, więc przesunięcie danych następuje raz na capacity
+    zapisów - koszt zapisu jest stały w ujęciu zamortyzowanym, a odczyt to wycinek tablicy.
+    """
+
+    def __init__(self, capacity, names):
+        self.capacity = capacity
+        self.columns = {name: np.empty(2 * capacity) for name in names}
+        self.size = 0
+        self.trimmed = False  # czy najstarsze dane zostały już odrzucone
+
+    def append(self, **values):
+        if self.size == 2 * self.capacity:
+            for column in self.columns.values():
+                column[:self.capacity] = column[self.capacity:]
+            self.size = self.capacity
+            self.trimmed = True
+        for name, value in values.items():
+            self.columns[name][self.size] = value
+        self.size += 1
+
+    def __getitem__(self, name):
+        return self.columns[name][:self.size]
+
+    def covers(self, t0):
+        """Czy przechowywane dane obejmują cały okres od chwili t0."""
+        return not self.trimmed or (self.size > 0 and self.columns["t"][0] <= t0)
+
+    def span(self, t0, t1):
+        t = self["t"]
+        return np.searchsorted(t, t0, "left"), np.searchsorted(t, t1, "right")
+
+
+class _Bucket:
+    """Kubełek w trakcie agregacji."""
+
+    __slots__ = ("t", "min", "max", "sum", "count", "items")
+
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        self.t = None
+        self.min = np.inf
+        self.max = -np.inf
+        self.sum = 0.0
+        self.count = 0
+        self.items = 0
+
+    def add(self, t, vmin, vmax, vsum, count):
+        if self.t is None:
+            self.t = t
+        self.min = min(self.min, vmin)
+        self.max = max(self.max, vmax)
+        self.sum += vsum
+        self.count += count
+        self.items += 1
+
+
+class HistoryStore:
+    """Wielorozdzielczy magazyn historii pomiarów.
+
+    Surowe próbki przechowywane są w ograniczonej liczbie, a dodatkowo na kilku poziomach
+    agregowane do kubełków (czas początku, minimum, maksimum, suma, liczba próbek). Każdy
+    poziom łączy DEFAULT_FACTOR kubełków poziomu niższego, więc koszt dodania próbki jest
+    stały. Zapytanie o przedział czasu wybiera najdokładniejszy poziom, z którego wynik
+    zmieści się w zadanej liczbie punktów: surowe dane (ew. zredukowane algorytmem LTTB)
+    albo obwiednię min/max kubełków.
+    """
+
+    def __init__(self, raw_capacity=DEFAULT_RAW_CAPACITY, level_capacity=DEFAULT_LEVEL_CAPACITY,
+                 factor=DEFAULT_FACTOR, levels=DEFAULT_LEVELS):
+        self.factor = factor
+        self.raw = _Columns(raw_capacity, ("t", "y"))
+        self.levels = [_Columns(level_capacity, ("t", "min", "max", "sum", "count")) for _ in range(levels)]
+        self.pending = [_Bucket() for _ in range(levels)]
+
+    def append(self, t, y):
+        self.raw.append(t=t, y=y)
+        item = (t, y, y, y, 1)
+        for level, bucket in zip(self.levels, self.pending):
+            bucket.add(*item)
+            if bucket.items < self.factor:
+                break
+            level.append(t=bucket.t, min=bucket.min, max=bucket.max, sum=bucket.sum, count=bucket.count)
+            item = (bucket.t, bucket.min, bucket.max, bucket.sum, bucket.count)
+            bucket.reset()
+
+    def __len__(self):
+        return self.raw.size
+
+    def query(self, t0, t1, max_points):
+        """Zwraca (czasy, wartości) z przedziału [t0, t1] w co najwyżej ok. max_points punktach."""
+        raw_t = self.raw["t"]
+        i0, i1 = self.raw.span(t0, t1)
+
+        if self.raw.covers(t0) or not self.levels:
+            if i1 - i0 <= max_points:
+                return raw_t[i0:i1], self.raw["y"][i0:i1]
+            if i1 - i0 <= LTTB_MAX_RATIO * max_points:
+                return lttb(raw_t[i0:i1], self.raw["y"][i0:i1], max_points)
+            if i1 - i0 <= RAW_MINMAX_MAX_RATIO * max_points or not self.levels:
+                y = self.raw["y"][i0:i1]
+                return min_max_envelope(*min_max_decimate(raw_t[i0:i1], y, y, max_points // 2))
+
+        # Obwiednia min/max (dwa punkty na kubełek) z najdokładniejszego poziomu, który po
+        # scaleniu kubełków wymaga przetworzenia co najwyżej factor razy więcej elementów
+        for index, level in enumerate(self.levels):
+            j0, j1 = level.span(t0, t1)
+            if j1 - j0 <= self.factor * (max_points // 2) and level.covers(t0):
+                return self._envelope(index, j0, j1, t1, max_points)
+
+        index = len(self.levels) - 1
+        return self._envelope(index, *self.levels[index].span(t0, t1), t1, max_points)
+
+    def _envelope(self, index, j0, j1, t1, max_points):
+        level = self.levels[index]
+        t = level["t"][j0:j1]
+        vmin = level["min"][j0:j1]
+        vmax = level["max"][j0:j1]
+
+        # Kubełek w trakcie agregacji uzupełnia prawą krawędź wykresu
+        bucket = self.pending[index]
+        if bucket.items and bucket.t <= t1:
+            t = np.append(t, bucket.t)
+            vmin = np.append(vmin, bucket.min)
+            vmax = np.append(vmax, bucket.max)
+
+        return min_max_envelope(*min_max_decimate(t, vmin, vmax, max_points // 2))
+
+    def mean(self, index):
+        """Zwraca (czasy, średnie) kubełków zadanego poziomu."""
+        level = self.levels[index]
+        return level["t"], level["sum"] / level["count"]
+
+
+def min_max_decimate(t, vmin, vmax, buckets):
+    """Łączy kolejne elementy w co najwyżej buckets grup, zachowując minimum i maksimum."""
+    n = len(t)
+    if n <= buckets or buckets < 1:
+        return t, vmin, vmax
+    starts = np.unique(np.linspace(0, n, buckets, endpoint=False).astype(np.int64))
+    return t[starts], np.minimum.reduceat(vmin, starts), np.maximum.reduceat(vmax, starts)
+
+
+def min_max_envelope(t, vmin, vmax):
+    """Łączy minima i maksima kubełków w jedną linię (dwa punkty na kubełek)."""
+    out_t = np.repeat(t, 2)
+    out_y = np.empty(2 * len(t))
+    out_y[0::2] = vmin
+    out_y[1::2] = vmax
+    return out_t, out_y
+
+
+def lttb(t, y, threshold):
+    """Redukcja liczby punktów algorytmem Largest-Triangle-Three-Buckets.
+
+    Wszystkie kubełki liczone są naraz operacjami numpy: lewym wierzchołkiem trójkąta jest
+    średnia poprzedniego kubełka (a nie punkt w nim wybrany, co wymagałoby pętli po
+    kubełkach), prawym - średnia następnego, jak w LTTB.
+    """
+    n = len(t)
+    if threshold >= n or threshold < 3:
+        return t, y
+
+    # Kubełki [edges[k], edges[k + 1]) - niepuste, bo threshold < n
+    edges = np.linspace(1, n - 1, threshold - 1).astype(np.int64)
+    starts = edges[:-1]
+    lengths = np.diff(edges)
+    mean_t = np.add.reduceat(t[:edges[-1]], starts) / lengths
+    mean_y = np.add.reduceat(y[:edges[-1]], starts) / lengths
+
+    # Wierzchołki: lewy - pierwszy punkt lub średnia poprzedniego kubełka, prawy - średnia
+    # następnego lub ostatni punkt
+    left_t = np.repeat(np.concatenate(([t[0]], mean_t[:-1])), lengths)
+    left_y = np.repeat(np.concatenate(([y[0]], mean_y[:-1])), lengths)
+    right_t = np.repeat(np.concatenate((mean_t[1:], [t[-1]])), lengths)
+    right_y = np.repeat(np.concatenate((mean_y[1:], [y[-1]])), lengths)
+
+    tc = t[1:edges[-1]]
+    yc = y[1:edges[-1]]
+    area = np.abs((left_t - right_t) * (yc - left_y) - (left_t - tc) * (right_y - left_y))
+
+    # Pierwsze maksimum w każdym kubełku
+    offsets = starts - 1
+    is_max = area >= np.repeat(np.maximum.reduceat(area, offsets), lengths)
+    bucket = np.repeat(np.arange(len(starts)), lengths)
+    candidates = np.flatnonzero(is_max)
+    first = np.concatenate(([True], bucket[candidates[1:]] != bucket[candidates[:-1]]))
+
+    out = np.concatenate(([0], candidates[first] + 1, [n - 1]))
+    return t[out], y[out]
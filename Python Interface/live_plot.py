@@ -0,0 +1,154 @@
+import time
+
+import numpy as np
+
+import history
+
+# Domyślne parametry wykresu
+DEFAULT_CAPACITY = 2048     # maksymalna liczba punktów w oknie
+DEFAULT_WINDOW_S = 120.0    # szerokość okna czasowego [s]
+DEFAULT_MAX_FPS = 10.0      # maksymalna częstotliwość odświeżania [klatki/s]
+Y_MARGIN = 0.5              # zapas osi Y przy zmianie zakresu
+MIN_WINDOW_S = 10.0         # najwęższe okno przy przybliżaniu [s]
+MAX_WINDOW_S = 30 * 24 * 3600.0  # najszersze okno przy oddalaniu [s]
+ZOOM_STEP = 2.0             # zmiana szerokości okna na jeden krok kółka myszy
+MAX_POINTS = 2000           # liczba punktów rysowanych z historii (ok. 2 na piksel)
+
+
+class RingBuffer:
+    """Bufor pierścieniowy o stałej pojemności na tablicach numpy.
+
+    Każda próbka zapisywana jest dwukrotnie (pod indeksem i oraz i + pojemność), dzięki
+    czemu ostatnie próbki w kolejności chronologicznej są zawsze ciągłym wycinkiem
+    tablicy - odczyt nie wymaga kopiowania.
+    """
+
+    def __init__(self, capacity):
+        self.capacity = capacity
+        self.t = np.zeros(2 * capacity)
+        self.y = np.zeros(2 * capacity)
+        self.index = 0
+        self.count = 0
+
+    def append(self, t, y):
+        i = self.index
+        self.t[i] = self.t[i + self.capacity] = t
+        self.y[i] = self.y[i + self.capacity] = y
+        self.index = (i + 1) % self.capacity
+        self.count = min(self.count + 1, self.capacity)
+
+    def view(self):
+        """Zwraca (czasy, wartości) od najstarszej do najnowszej próbki."""
+        end = self.index + self.capacity
+        start = end - self.count
+        return self.t[start:end], self.y[start:end]
+
+
+class LivePlot:
+    """Wykres bieżący z przesuwanym oknem, odświeżany przez blitting.
+
+    Dane dodawane są metodą add() w dowolnym tempie, a rysowanie odbywa się w osobnym
+    takcie (metoda tick() wywoływana cyklicznie) nie częściej niż max_fps razy na sekundę
+    i tylko po pojawieniu się nowych danych. Oś X pokazuje czas względem najnowszej próbki,
+    więc jej zakres jest stały; pełne przerysowanie następuje tylko przy zmianie zakresu osi Y.
+
+    Kółko myszy zmienia szerokość okna. Dopóki okno mieści się w buforze bieżącym, rysowane
+    są wszystkie próbki; szersze okna rysowane są z wielorozdzielczej historii (HistoryStore).
+    """
+
+    def __init__(self, canvas, ax, capacity=DEFAULT_CAPACITY, window_s=DEFAULT_WINDOW_S,
+                 max_fps=DEFAULT_MAX_FPS):
+        self.canvas = canvas
+        self.ax = ax
+        self.window_s = window_s
+        self.min_period = 1.0 / max_fps
+        self.data = RingBuffer(capacity)
+        self.history = history.HistoryStore()
+        self.setpoint = None
+        self.dirty = False
+        self.last_draw = 0.0
+        self.background = None
+
+        self.line, = ax.plot([], [], label="Wartość aktualna", marker='o', markersize=2, animated=True)
+        self.setpoint_line = ax.axhline(y=0.0, color='r', linestyle='--', label="Wartość zadana",
+                                        animated=True, visible=False)
+        ax.set_xlim(-window_s, 0.0)
+        ax.set_ylim(0.0, 1.0)
+        ax.legend(loc="upper left")
+        ax.set_title("Wykres wartości aktualnej")
+        ax.set_xlabel("Czas [s]")
+        ax.set_ylabel("Wartość")
+        ax.grid()
+
+        canvas.mpl_connect("draw_event", self._on_draw)
+        canvas.mpl_connect("scroll_event", self._on_scroll)
+
+    def add(self, timestamp, value, setpoint=None):
+        self.data.append(timestamp, value)
+        self.history.append(timestamp, value)
+        if setpoint is not None:
+            self.setpoint = setpoint
+        self.dirty = True
+
+    def _on_draw(self, event):
+        # Tło (osie, siatka, legenda) zapamiętywane po każdym pełnym przerysowaniu
+        self.background = self.canvas.copy_from_bbox(self.ax.bbox)
+        self._draw_artists()
+
+    def _on_scroll(self, event):
+        factor = 1.0 / ZOOM_STEP if event.button == "up" else ZOOM_STEP
+        self.window_s = min(max(self.window_s * factor, MIN_WINDOW_S), MAX_WINDOW_S)
+        self.ax.set_xlim(-self.window_s, 0.0)
+        # Zmiana osi wymaga pełnego przerysowania, wykonywanego w najbliższym takcie
+        self.background = None
+        self.dirty = True
+
+    def _window_data(self):
+        """Zwraca dane okna: z bufora bieżącego, jeżeli obejmuje całe okno, inaczej z historii."""
+        t, y = self.data.view()
+        if self.data.count < self.data.capacity or t[-1] - t[0] >= self.window_s:
+            start = np.searchsorted(t, t[-1] - self.window_s)
+            return t[start:], y[start:]
+        return self.history.query(t[-1] - self.window_s, t[-1], MAX_POINTS)
+
+    def _draw_artists(self):
+        self.ax.draw_artist(self.line)
+        if self.setpoint_line.get_visible():
+            self.ax.draw_artist(self.setpoint_line)
+
+    def _rescale_needed(self, y):
+        low, high = self.ax.get_ylim()
+        values = [y.min(), y.max()]
+        if self.setpoint is not None:
+            values.append(self.setpoint)
+        vmin, vmax = min(values), max(values)
+        if vmin >= low and vmax <= high:
+            return False
+        self.ax.set_ylim(vmin - Y_MARGIN, vmax + Y_MARGIN)
+        return True
+
+    def tick(self):
+        """Rysuje nową klatkę, jeżeli są nowe dane i minął minimalny odstęp."""
+        now = time.monotonic()
+        if not self.dirty or now - self.last_draw < self.min_period or self.data.count == 0:
+            return
+        self.dirty = False
+        self.last_draw = now
+
+        latest = self.data.view()[0][-1]
+        t, y = self._window_data()
+        if len(t) == 0:
+            return
+        self.line.set_data(t - latest, y)
+        self.line.set_marker('o' if len(t) <= self.data.capacity // 4 else '')
+        if self.setpoint is not None:
+            self.setpoint_line.set_ydata([self.setpoint, self.setpoint])
+            self.setpoint_line.set_visible(True)
+
+        if self.background is None or self._rescale_needed(y):
+            self.canvas.draw()
+            return
+
+        self.canvas.restore_region(self.background)
+        self._draw_artists()
+        self.canvas.blit(self.ax.bbox)
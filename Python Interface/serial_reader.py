@@ -0,0 +1,168 @@
+import threading
+import time
+from collections import deque
+
+import serial
+
+# Domyślna pojemność bufora (linie telemetrii co ~130 ms -> kilka minut zapasu)
+DEFAULT_CAPACITY = 4096
+
+# Rodzaje elementów w buforze
+LINE = "line"    # linia tekstowa bez znaku końca linii
+SCOPE = "scope"  # zapis rejestratora: (liczba próbek, rozmiar próbki, próbki przed wyzwoleniem, dane)
+
+# Negocjacja prędkości (polecenia "B<prędkość>" i "BP" firmware)
+REPLY_TIMEOUT_S = 0.5   # czas na odpowiedź sterownika (polecenia wykonywane w pętli głównej)
+PROBE_ATTEMPTS = 3      # liczba próbek "BP" po przełączeniu
+MCU_FALLBACK_S = 1.2    # nieco więcej niż CMD_BAUD_PROBE_TIMEOUT w firmware
+
+
+class SerialReader(threading.Thread):
+    """Wątek opróżniający port szeregowy do ograniczonego bufora pierścieniowego.
+
+    Wątek czyta port w sposób ciągły, dzieli strumień na linie i umieszcza je w buforze
+    razem z czasem odbioru. Blok binarny rejestratora (nagłówek "SCOPE <n> <rozmiar> <pre>")
+    jest odczytywany w całości i przekazywany jako jeden element. Interfejs pobiera dane
+    porcjami metodą drain() w swoim takcie odświeżania.
+    """
+
+    def __init__(self, ser, capacity=DEFAULT_CAPACITY):
+        super().__init__(daemon=True)
+        self.ser = ser
+        self.buffer = deque(maxlen=capacity)
+        self.lock = threading.Lock()
+        self.running = threading.Event()
+        self.dropped = 0  # elementy nadpisane przy przepełnieniu bufora
+        self.errors = 0
+        self._pending = bytearray()
+        self._expect = None          # prefiks oczekiwanej odpowiedzi (przechwytywanej z bufora)
+        self._reply = None
+        self._reply_event = threading.Event()
+
+    def start(self):
+        self.running.set()
+        super().start()
+
+    def stop(self, timeout=1.0):
+        self.running.clear()
+        if self.is_alive():
+            self.join(timeout)
+
+    def drain(self, max_items=None):
+        """Zwraca listę (rodzaj, czas, dane) odebranych od ostatniego wywołania."""
+        with self.lock:
+            if max_items is None or max_items >= len(self.buffer):
+                items = list(self.buffer)
+                self.buffer.clear()
+            else:
+                items = [self.buffer.popleft() for _ in range(max_items)]
+        return items
+
+    def _request(self, command, prefix, timeout=REPLY_TIMEOUT_S):
+        """Wysyła polecenie i czeka na linię zaczynającą się od prefix; zwraca ją lub None."""
+        with self.lock:
+            self._expect = prefix
+            self._reply = None
+            self._reply_event.clear()
+        self.ser.write(command.encode())
+        self._reply_event.wait(timeout)
+        with self.lock:
+            self._expect = None
+            return self._reply
+
+    def _probe(self, baud, attempts=PROBE_ATTEMPTS):
+        for _ in range(attempts):
+            if self._request("BP\n", "BP ") == f"BP {baud}":
+                return True
+        return False
+
+    def negotiate_baud(self, baud):
+        """Uzgadnia ze sterownikiem nową prędkość transmisji; zwraca True po potwierdzeniu.
+
+        Sterownik odpowiada na "B<prędkość>" jeszcze starą prędkością i przełącza się;
+        host przełącza port i wysyła próbki "BP". Bez potwierdzenia obie strony wracają do
+        poprzedniej prędkości. Jeżeli zgubiona została tylko odpowiedź na próbkę (sterownik
+        przyjął nową prędkość), wykrywa to ponowna próbka na nowej prędkości.
+        Funkcja blokująca - wywoływać poza wątkiem interfejsu.
+        """
+        old = self.ser.baudrate
+        if baud == old:
+            return True
+        if self._request(f"B{baud}\n", f"B{baud} ") != f"B{baud} OK":
+            return False
+
+        self.ser.baudrate = baud
+        if self._probe(baud):
+            return True
+
+        # Sterownik powinien wrócić do poprzedniej prędkości po swoim czasie oczekiwania
+        self.ser.baudrate = old
+        time.sleep(MCU_FALLBACK_S)
+        if self._probe(old):
+            return False
+        self.ser.baudrate = baud
+        if self._probe(baud):
+            return True
+        self.ser.baudrate = old
+        return False
+
+    def _push(self, kind, payload):
+        with self.lock:
+            if len(self.buffer) == self.buffer.maxlen:
+                self.dropped += 1
+            self.buffer.append((kind, time.time(), payload))
+
+    def _read_exact(self, size):
+        # Dane bloku mogą już częściowo znajdować się w buforze podziału na linie
+        data = self._pending[:size]
+        del self._pending[:size]
+        while len(data) < size and self.running.is_set():
+            chunk = self.ser.read(size - len(data))
+            if not chunk:
+                break
+            data += chunk
+        return bytes(data)
+
+    def _handle_line(self, raw):
+        text = raw.decode(errors="replace").strip()
+        if not text:
+            return
+        with self.lock:
+            if self._expect is not None and text.startswith(self._expect):
+                self._reply = text
+                self._reply_event.set()
+                return
+        if text.startswith("SCOPE "):
+            try:
+                count, size, pre = (int(v) for v in text.split()[1:4])
+            except ValueError:
+                self.errors += 1
+                return
+            data = self._read_exact(count * size)
+            if len(data) == count * size:
+                self._push(SCOPE, (count, size, pre, data))
+            else:
+                self.errors += 1
+            return
+        self._push(LINE, text)
+
+    def run(self):
+        while self.running.is_set():
+            try:
+                # Blokujący odczyt co najmniej jednego bajtu (z limitem czasu portu),
+                # a następnie wszystkiego, co czeka w buforze systemowym
+                chunk = self.ser.read(max(1, self.ser.in_waiting))
+            except (serial.SerialException, OSError, TypeError):
+                # Port zamknięty lub odłączony
+                self.errors += 1
+                break
+            if not chunk:
+                continue
+            self._pending += chunk
+            while self.running.is_set():
+                end = self._pending.find(b"\n")
+                if end < 0:
+                    break
+                raw = bytes(self._pending[:end])
+                del self._pending[:end + 1]
+                self._handle_line(raw)
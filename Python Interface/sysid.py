@@ -0,0 +1,487 @@
+import argparse
+import csv
+import math
+import os
+import sys
+from datetime import datetime
+
+import numpy as np
+
+import data_logger
+import tsdb
+
+# Identyfikacja modelu obiektu z zapisanych przebiegów (pliki .csv, .bin i .ts z data_logger).
+#
+# Dane czytane są porcjami, więc rozmiar dziennika nie jest ograniczony pamięcią. Każda porcja
+# jest przepróbkowana na równomierną siatkę (przerwy dłuższe niż --gap dzielą dane na odcinki),
+# a do identyfikacji brane są tylko próbki do --window sekund po zmianie wejścia - skoki
+# i odcinki PRBS; długie okresy stanu ustalonego nie niosą informacji o dynamice.
+#
+# Modele dyskretne ARX z opóźnieniem d próbek, dopasowywane metodą najmniejszych kwadratów:
+#   FOPDT:  y[k+1] = a*y[k] + b*u[k-d] + c
+#   SOPDT:  y[k+1] = a1*y[k] + a2*y[k-1] + b1*u[k-d] + b2*u[k-d-1] + c
+# Dla wszystkich opóźnień od 0 do --max-dead naraz sumowane są równania normalne (macierze
+# 5x5), więc jedno przejście przez dane wystarcza do wyboru opóźnienia o najmniejszej sumie
+# kwadratów reszt. Drugie przejście liczy reszty wybranych modeli: ich autokorelacja
+# (zwykle duża - reszty nie są białe) zwiększa wariancję parametrów przez efektywną liczbę
+# próbek. Przedziały ufności parametrów ciągłych (K, stałe czasowe, temperatura bazowa)
+# wyznaczane są metodą delta, a przedział opóźnienia z profilu sumy kwadratów reszt.
+#
+# Wejście u to wyjście regulatora (4. kolumna CSV lub kanał "wyjscie" pliku .ts). Dzienniki
+# z gui.py zawierają tylko temperaturę zadaną - wtedy wejściem jest temperatura zadana,
+# a model opisuje zamkniętą pętlę regulacji (nie sam obiekt).
+#
+# Użycie:
+#   python sysid.py dane.csv [dane2.bin ...] [--dt 0.13] [--max-dead 20] [--window 900]
+
+DEFAULT_GAP_S = 2.0            # przerwa w danych dzieląca odcinki
+DEFAULT_MAX_DEAD_S = 20.0      # największe sprawdzane opóźnienie
+DEFAULT_WINDOW_S = 900.0       # okres po zmianie wejścia brany do identyfikacji
+DEFAULT_STEP_MIN = 0.05        # najmniejsza zmiana wejścia uznawana za pobudzenie
+PRBS_MAX_GAP_S = 120.0         # zmiany wejścia bliżej siebie należą do jednego odcinka PRBS
+PRBS_MIN_SWITCHES = 4
+READ_CHUNK = 65536             # liczba próbek w porcji odczytu
+CONFIDENCE_Z = 1.96            # 95%
+CHI2_1_95 = 3.841
+
+MODELS = ("fopdt", "sopdt")
+OUTPUT_CHANNEL = "wyjscie"
+
+
+# --- Odczyt dzienników porcjami: (czas [s], aktualna, zadana, wyjście lub None) ---
+
+def _read_csv(path, chunk):
+    with open(path, newline="") as file:
+        rows = []
+        for row in csv.reader(file):
+            if len(row) < 3:
+                continue
+            try:
+                t = datetime.fromisoformat(row[0]).timestamp()
+                values = [float(v) for v in row[1:4]]
+            except ValueError:
+                continue  # nagłówek lub uszkodzona linia
+            rows.append([t] + values + ([math.nan] if len(values) < 3 else []))
+            if len(rows) == chunk:
+                yield _columns(np.array(rows))
+                rows = []
+        if rows:
+            yield _columns(np.array(rows))
+
+
+def _columns(array):
+    u = array[:, 3]
+    return array[:, 0], array[:, 1], array[:, 2], (None if np.isnan(u).all() else u)
+
+
+def _read_bin(path, chunk):
+    dtype = np.dtype([("t", "<f8"), ("a", "<f4"), ("z", "<f4")])
+    assert dtype.itemsize == data_logger.BIN_RECORD.size
+    offset = len(data_logger.BIN_MAGIC)
+    count = (os.path.getsize(path) - offset) // dtype.itemsize  # bez niepełnego ostatniego rekordu
+    if count <= 0:
+        return
+    records = np.memmap(path, dtype=dtype, mode="r", offset=offset, shape=(count,))
+    for start in range(0, count, chunk):
+        part = records[start:start + chunk]
+        yield part["t"].astype(float), part["a"].astype(float), part["z"].astype(float), None
+
+
+def _read_ts(path, chunk):
+    with tsdb.Reader(path) as reader:
+        span = reader.time_range()
+        if span is None:
+            return
+        # Zakresy czasu o ok. chunk próbkach (okres próbkowania ok. 130 ms)
+        step_ms = chunk * 130
+        for t0 in range(span[0], span[1] + 1, step_ms):
+            times, columns = reader.read(t0, t0 + step_ms - 1)
+            if not times:
+                continue
+            u = columns.get(OUTPUT_CHANNEL)
+            yield (np.asarray(times, dtype=float) / 1000.0, np.asarray(columns["aktualna"], dtype=float),
+                   np.asarray(columns["zadana"], dtype=float), None if u is None else np.asarray(u, dtype=float))
+
+
+READERS = {".csv": _read_csv, ".bin": _read_bin, ".ts": _read_ts}
+
+
+def read_log(path, chunk=READ_CHUNK):
+    extension = os.path.splitext(path)[1].lower()
+    if extension not in READERS:
+        raise ValueError(f"Nieznany format dziennika: {path}")
+    return READERS[extension](path, chunk)
+
+
+# --- Przepróbkowanie i wybór próbek z pobudzeniem ---
+
+class _Resampler:
+    """Przepróbkowanie na siatkę dt: temperatura liniowo, wejście jak ekstrapolator zerowego rzędu."""
+
+    def __init__(self, dt, gap):
+        self.dt = dt
+        self.gap = gap
+        self.prev = None      # ostatnia surowa próbka (t, y, u)
+        self.next_t = None    # następny punkt siatki
+
+    def feed(self, t, y, u):
+        """Zwraca listę (y, u, nowy_odcinek) dla kolejnych fragmentów siatki."""
+        order = np.argsort(t, kind="stable")
+        t, y, u = t[order], y[order], u[order]
+        pieces = []
+        breaks = np.flatnonzero(np.diff(t) > self.gap) + 1
+        for part_t, part_y, part_u in zip(np.split(t, breaks), np.split(y, breaks), np.split(u, breaks)):
+            if part_t.size == 0:
+                continue
+            new_segment = self.prev is None or part_t[0] - self.prev[0] > self.gap
+            if new_segment:
+                self.next_t = part_t[0]
+            else:
+                part_t = np.concatenate(([self.prev[0]], part_t))
+                part_y = np.concatenate(([self.prev[1]], part_y))
+                part_u = np.concatenate(([self.prev[2]], part_u))
+            self.prev = (part_t[-1], part_y[-1], part_u[-1])
+            if part_t[-1] < self.next_t:
+                continue
+            grid = np.arange(self.next_t, part_t[-1] + 1e-9, self.dt)
+            self.next_t = grid[-1] + self.dt
+            hold = np.clip(np.searchsorted(part_t, grid, "right") - 1, 0, part_t.size - 1)
+            pieces.append((np.interp(grid, part_t, part_y), part_u[hold], new_segment))
+        return pieces
+
+
+class _Excitation:
+    """Maska próbek do window próbek po zmianie wejścia oraz liczniki skoków i odcinków PRBS."""
+
+    def __init__(self, window_n, step_min, prbs_gap_n):
+        self.window_n = window_n
+        self.step_min = step_min
+        self.prbs_gap_n = prbs_gap_n
+        self.position = 0           # numer próbki od początku danych
+        self.last_u = None
+        self.last_event = None
+        self.burst = 0              # liczba zmian w bieżącej serii
+        self.steps = 0
+        self.prbs = 0
+
+    def _close_burst(self):
+        if self.burst >= PRBS_MIN_SWITCHES:
+            self.prbs += 1
+        elif self.burst > 0:
+            self.steps += self.burst
+        self.burst = 0
+
+    def feed(self, u, new_segment):
+        if new_segment:
+            self._close_burst()
+            self.last_u = u[0]
+            self.last_event = None
+        index = self.position + np.arange(u.size)
+        events = np.abs(np.diff(np.concatenate(([self.last_u], u)))) > self.step_min
+        event_index = index[events]
+        carried = -1 if self.last_event is None else self.last_event
+
+        for i in event_index:
+            if self.last_event is None or i - self.last_event > self.prbs_gap_n:
+                self._close_burst()
+            self.burst += 1
+            self.last_event = i
+
+        # Numer ostatniej zmiany wejścia przed każdą próbką (także z poprzednich porcji)
+        latest = np.maximum(np.maximum.accumulate(np.where(events, index, -1)), carried)
+        mask = (latest >= 0) & (index - latest <= self.window_n)
+
+        self.position += u.size
+        self.last_u = u[-1]
+        return mask
+
+    def finish(self):
+        self._close_burst()
+
+
+def stream(paths, dt, gap, window_s, step_min, source, excitation=None):
+    """Przepróbkowane fragmenty (y, u, maska, nowy_odcinek) kolejnych dzienników."""
+    resampler = _Resampler(dt, gap)
+    if excitation is None:
+        excitation = _Excitation(int(window_s / dt), step_min, int(PRBS_MAX_GAP_S / dt))
+    for path in paths:
+        for t, y, z, u in read_log(path):
+            if source == "output" and u is None:
+                raise ValueError(f"Brak kolumny wyjścia regulatora w {path}")
+            if source == "setpoint" or u is None:
+                u = z
+            for ry, ru, new_segment in resampler.feed(t, y, u):
+                yield ry, ru, excitation.feed(ru, new_segment), new_segment
+    excitation.finish()
+
+
+def estimate_dt(paths, default=0.13):
+    for path in paths:
+        for t, _, _, _ in read_log(path, 4096):
+            steps = np.diff(np.sort(t))
+            steps = steps[steps > 0]
+            if steps.size:
+                return float(np.median(steps))
+    return default
+
+
+# --- Równania normalne dla wszystkich opóźnień ---
+
+class _Regression:
+    """Sumy równań normalnych modelu dla opóźnień 0..max_dead (porcjami, z historią między porcjami)."""
+
+    def __init__(self, model, max_dead):
+        self.model = model
+        self.max_dead = max_dead
+        self.params = 3 if model == "fopdt" else 5
+        self.history = max_dead + 3
+        self.A = np.zeros((max_dead + 1, self.params, self.params))
+        self.b = np.zeros((max_dead + 1, self.params))
+        self.yy = 0.0
+        self.n = 0
+        self.reset()
+
+    def reset(self):
+        self.tail_y = np.empty(0)
+        self.tail_u = np.empty(0)
+
+    def rows(self, y, u, mask, d):
+        """Macierz regresji i wartości docelowe nowych wierszy dla opóźnienia d."""
+        Y = np.concatenate((self.tail_y, y))
+        U = np.concatenate((self.tail_u, u))
+        M = np.concatenate((np.zeros(self.tail_y.size, dtype=bool), mask))
+        first = max(self.tail_y.size, self.history)
+        j = np.arange(first, Y.size)
+        j = j[M[j]]
+        ones = np.ones(j.size)
+        if self.model == "fopdt":
+            phi = np.column_stack((Y[j - 1], U[j - 1 - d], ones))
+        else:
+            phi = np.column_stack((Y[j - 1], Y[j - 2], U[j - 1 - d], U[j - 2 - d], ones))
+        return phi, Y[j], j - self.tail_y.size
+
+    def advance(self, y, u):
+        self.tail_y = np.concatenate((self.tail_y, y))[-self.history:]
+        self.tail_u = np.concatenate((self.tail_u, u))[-self.history:]
+
+    def feed(self, y, u, mask, new_segment):
+        if new_segment:
+            self.reset()
+        for d in range(self.max_dead + 1):
+            phi, target, _ = self.rows(y, u, mask, d)
+            self.A[d] += phi.T @ phi
+            self.b[d] += phi.T @ target
+            if d == 0:
+                self.yy += target @ target
+                self.n += target.size
+        self.advance(y, u)
+
+    def solve(self):
+        """Parametry i suma kwadratów reszt dla każdego opóźnienia."""
+        theta = np.full((self.max_dead + 1, self.params), np.nan)
+        rss = np.full(self.max_dead + 1, np.inf)
+        for d in range(self.max_dead + 1):
+            try:
+                theta[d] = np.linalg.solve(self.A[d], self.b[d])
+            except np.linalg.LinAlgError:
+                continue
+            rss[d] = self.yy - 2.0 * theta[d] @ self.b[d] + theta[d] @ self.A[d] @ theta[d]
+        return theta, np.maximum(rss, 0.0)
+
+
+class _Residuals:
+    """Wariancja i autokorelacja (opóźnienie 1) reszt wybranego modelu."""
+
+    def __init__(self, regression, d, theta):
+        self.regression = regression
+        self.d = d
+        self.theta = theta
+        self.sum_rr = 0.0
+        self.sum_lag = 0.0
+        self.pairs = 0
+        self.n = 0
+        self.last = None       # (indeks w poprzedniej porcji względem jej końca, reszta)
+
+    def feed(self, y, u, mask, new_segment):
+        reg = self.regression
+        if new_segment:
+            reg.reset()
+            self.last = None
+        phi, target, index = reg.rows(y, u, mask, self.d)
+        r = target - phi @ self.theta
+        self.sum_rr += r @ r
+        self.n += r.size
+        if r.size:
+            consecutive = np.diff(index) == 1
+            self.sum_lag += r[1:][consecutive] @ r[:-1][consecutive]
+            self.pairs += int(consecutive.sum())
+            if self.last is not None and index[0] == 0 and self.last[0] == -1:
+                self.sum_lag += self.last[1] * r[0]
+                self.pairs += 1
+            self.last = (index[-1] - y.size, r[-1])
+        else:
+            self.last = None
+        reg.advance(y, u)
+
+    def inflation(self):
+        """Współczynnik zwiększenia wariancji parametrów (reszty AR(1) - efektywna liczba próbek)."""
+        if self.pairs == 0 or self.sum_rr == 0.0:
+            return 1.0
+        rho = float(np.clip(self.sum_lag / self.sum_rr, 0.0, 0.99))
+        return (1.0 + rho) / (1.0 - rho)
+
+
+# --- Parametry ciągłe ---
+
+def _fopdt_params(theta, dt):
+    a, b, c = theta
+    if not 0.0 < a < 1.0:
+        return {"K": math.nan, "T": math.nan, "baza": math.nan}
+    return {"K": b / (1.0 - a), "T": -dt / math.log(a), "baza": c / (1.0 - a)}
+
+
+def _sopdt_params(theta, dt):
+    a1, a2, b1, b2, c = theta
+    gain_den = 1.0 - a1 - a2
+    result = {"K": (b1 + b2) / gain_den if gain_den else math.nan,
+              "T1": math.nan, "T2": math.nan,
+              "baza": c / gain_den if gain_den else math.nan}
+    disc = a1 * a1 + 4.0 * a2
+    if disc < 0.0:
+        return result  # bieguny zespolone - obiekt nie jest szeregiem dwóch inercji
+    poles = sorted(((a1 + math.sqrt(disc)) / 2.0, (a1 - math.sqrt(disc)) / 2.0), reverse=True)
+    if not all(0.0 < p < 1.0 for p in poles):
+        return result
+    result["T1"] = -dt / math.log(poles[0])
+    result["T2"] = -dt / math.log(poles[1])
+    return result
+
+
+PARAMS = {"fopdt": _fopdt_params, "sopdt": _sopdt_params}
+
+
+def _delta_bounds(function, theta, cov, dt):
+    """Połowa szerokości przedziałów ufności parametrów ciągłych (metoda delta)."""
+    base = function(theta, dt)
+    names = list(base)
+    jacobian = np.zeros((len(names), theta.size))
+    for i in range(theta.size):
+        h = 1e-6 * max(abs(theta[i]), 1e-3)
+        plus, minus = theta.copy(), theta.copy()
+        plus[i] += h
+        minus[i] -= h
+        fp, fm = function(plus, dt), function(minus, dt)
+        jacobian[:, i] = [(fp[n] - fm[n]) / (2.0 * h) for n in names]
+    variance = np.einsum("ij,jk,ik->i", jacobian, cov, jacobian)
+    return base, {n: CONFIDENCE_Z * math.sqrt(v) if v >= 0.0 else math.nan for n, v in zip(names, variance)}
+
+
+def identify(paths, dt=None, gap=DEFAULT_GAP_S, max_dead_s=DEFAULT_MAX_DEAD_S, window_s=DEFAULT_WINDOW_S,
+             step_min=DEFAULT_STEP_MIN, source="auto"):
+    """Dopasowuje modele; zwraca słownik wyników (parametry, przedziały, liczniki)."""
+    if dt is None:
+        dt = estimate_dt(paths)
+    max_dead = max(0, int(round(max_dead_s / dt)))
+    regressions = {m: _Regression(m, max_dead) for m in MODELS}
+    excitation = _Excitation(int(window_s / dt), step_min, int(PRBS_MAX_GAP_S / dt))
+    has_output = False
+
+    # Przejście 1: równania normalne dla wszystkich opóźnień
+    for y, u, mask, new_segment in stream(paths, dt, gap, window_s, step_min, source, excitation):
+        for regression in regressions.values():
+            regression.feed(y, u, mask, new_segment)
+    if source != "setpoint":
+        has_output = any(next(read_log(p, 16), (None, None, None, None))[3] is not None for p in paths)
+
+    results = {"dt": dt, "steps": excitation.steps, "prbs": excitation.prbs,
+               "input": "wyjście regulatora" if has_output and source != "setpoint" else "temperatura zadana",
+               "models": {}}
+    chosen = {}
+    for model, regression in regressions.items():
+        if regression.n <= regression.params + 1:
+            raise ValueError("Za mało próbek z pobudzeniem do identyfikacji")
+        theta, rss = regression.solve()
+        d = int(np.argmin(rss))
+        # Profil opóźnienia: N*ln(RSS_d/RSS_min) <= chi2(1)
+        with np.errstate(divide="ignore"):
+            profile = regression.n * np.log(np.maximum(rss, 1e-300) / max(rss[d], 1e-300))
+        accepted = np.flatnonzero(profile <= CHI2_1_95)
+        chosen[model] = (d, theta[d], rss[d], (int(accepted.min()), int(accepted.max())))
+        regression.reset()
+
+    # Przejście 2: autokorelacja reszt wybranych modeli
+    residuals = {m: _Residuals(regressions[m], chosen[m][0], chosen[m][1]) for m in MODELS}
+    for y, u, mask, new_segment in stream(paths, dt, gap, window_s, step_min, source):
+        for r in residuals.values():
+            r.feed(y, u, mask, new_segment)
+
+    for model, regression in regressions.items():
+        d, theta, rss, (d_lo, d_hi) = chosen[model]
+        n, p = regression.n, regression.params
+        sigma2 = rss / (n - p)
+        inflation = residuals[model].inflation()
+        cov = inflation * sigma2 * np.linalg.inv(regression.A[d])
+        values, bounds = _delta_bounds(PARAMS[model], theta, cov, dt)
+        values["L"] = d * dt
+        bounds["L"] = (d_lo * dt, d_hi * dt)
+        results["models"][model] = {"values": values, "bounds": bounds, "samples": n,
+                                    "rms": math.sqrt(rss / n), "inflation": inflation, "theta": theta}
+    return results
+
+
+def _format(value):
+    return "-" if value is None or (isinstance(value, float) and math.isnan(value)) else f"{value:.4g}"
+
+
+def report(results, out=sys.stdout):
+    print(f"# okres próbkowania {results['dt']:.4g} s, wejście: {results['input']}, "
+          f"skoki: {results['steps']}, odcinki PRBS: {results['prbs']}", file=out)
+    for model, fit in results["models"].items():
+        print(f"{model.upper()}: {fit['samples']} próbek, reszty RMS {fit['rms']:.4g}, "
+              f"zwiększenie wariancji x{fit['inflation']:.1f}", file=out)
+        for name, value in fit["values"].items():
+            bound = fit["bounds"][name]
+            if isinstance(bound, tuple):
+                text = f"[{_format(bound[0])}, {_format(bound[1])}]"
+            else:
+                text = f"± {_format(bound)}"
+            print(f"  {name:5s} {_format(value):>10s}  {text}", file=out)
+
+    if results["input"] != "wyjście regulatora":
+        print("# model zamkniętej pętli (brak wyjścia regulatora w dzienniku) - nie do doboru nastaw", file=out)
+        return
+    # Parametry dla Tools/pid_tune (grzałka + inercja czujnika)
+    fopdt = results["models"]["fopdt"]["values"]
+    sopdt = results["models"]["sopdt"]["values"]
+    noise = results["models"]["fopdt"]["rms"]
+    if not math.isnan(fopdt["K"]) and not math.isnan(fopdt["T"]):
+        print(f"pid_tune -K {fopdt['K']:.4g} -T {fopdt['T']:.4g} -s 0.125 -L {fopdt['L']:.4g} "
+              f"-a {fopdt['baza']:.4g} -n {noise:.3g}", file=out)
+    if not math.isnan(sopdt["T1"]):
+        print(f"pid_tune -K {sopdt['K']:.4g} -T {sopdt['T1']:.4g} -s {max(sopdt['T2'], 0.125):.4g} "
+              f"-L {sopdt['L']:.4g} -a {sopdt['baza']:.4g} -n {noise:.3g}", file=out)
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Identyfikacja modelu obiektu z dzienników temperatury")
+    parser.add_argument("logs", nargs="+", help="pliki .csv, .bin lub .ts")
+    parser.add_argument("--dt", type=float, default=None, help="okres przepróbkowania [s] (domyślnie z danych)")
+    parser.add_argument("--gap", type=float, default=DEFAULT_GAP_S, help="przerwa dzieląca odcinki [s]")
+    parser.add_argument("--max-dead", type=float, default=DEFAULT_MAX_DEAD_S, help="największe opóźnienie [s]")
+    parser.add_argument("--window", type=float, default=DEFAULT_WINDOW_S, help="okres po zmianie wejścia [s]")
+    parser.add_argument("--step-min", type=float, default=DEFAULT_STEP_MIN, help="najmniejsza zmiana wejścia")
+    parser.add_argument("--input", choices=("auto", "output", "setpoint"), default="auto",
+                        help="wejście modelu: wyjście regulatora (jeżeli zapisane) lub temperatura zadana")
+    args = parser.parse_args(argv)
+
+    try:
+        results = identify(args.logs, args.dt, args.gap, args.max_dead, args.window, args.step_min, args.input)
+    except (OSError, ValueError) as error:
+        print(error, file=sys.stderr)
+        return 1
+    report(results)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
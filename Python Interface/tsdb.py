@@ -0,0 +1,324 @@
+import mmap
+import os
+import struct
+from bisect import bisect_left
+
+# Kolumnowy format szeregów czasowych z kompresją w stylu Gorilla.
+#
+# Plik: nagłówek z nazwami kanałów, a następnie bloki zapisywane przez dopisywanie; jedynie
+# ostatni, niepełny blok zapisany przy flush(partial=True) jest nadpisywany w miejscu kolejnymi
+# zapisami (dane tylko przybywają, więc nowa wersja zawsze pokrywa starą).
+# Blok zawiera do BLOCK_SAMPLES próbek: czasy (całkowite milisekundy) kodowane różnicą
+# drugiego rzędu, a wartości każdego kanału (float64) kodowane XOR z poprzednią wartością.
+# Każdy blok ma nagłówek z zakresem czasu i długością danych - indeks bloków budowany jest
+# przy otwarciu przez przeskakiwanie nagłówków, a odczyt zakresu dekoduje tylko bloki,
+# które go przecinają. Niepełny ostatni blok (np. po awarii) jest pomijany.
+
+FILE_MAGIC = b"PPTS1\0\0\0"
+BLOCK_MAGIC = b"BLK1"
+BLOCK_HEADER = struct.Struct("<4sIqqI")  # znacznik, liczba próbek, t_pierwsze, t_ostatnie, długość danych
+BLOCK_SAMPLES = 1024
+
+_DOUBLE = struct.Struct("<d")
+_U64 = struct.Struct("<Q")
+
+
+def _float_bits(value):
+    return _U64.unpack(_DOUBLE.pack(value))[0]
+
+
+def _bits_float(bits):
+    return _DOUBLE.unpack(_U64.pack(bits))[0]
+
+
+class _BitWriter:
+    def __init__(self):
+        self.data = bytearray()
+        self.acc = 0
+        self.nbits = 0
+
+    def write(self, value, nbits):
+        self.acc = (self.acc << nbits) | (value & ((1 << nbits) - 1))
+        self.nbits += nbits
+        while self.nbits >= 8:
+            self.nbits -= 8
+            self.data.append((self.acc >> self.nbits) & 0xFF)
+        self.acc &= (1 << self.nbits) - 1
+
+    def getvalue(self):
+        if self.nbits:
+            return bytes(self.data) + bytes([(self.acc << (8 - self.nbits)) & 0xFF])
+        return bytes(self.data)
+
+
+class _BitReader:
+    def __init__(self, data):
+        self.value = int.from_bytes(data, "big")
+        self.total = 8 * len(data)
+        self.pos = 0
+
+    def read(self, nbits):
+        self.pos += nbits
+        return (self.value >> (self.total - self.pos)) & ((1 << nbits) - 1)
+
+
+# Zakresy różnicy drugiego rzędu czasu: (prefiks, długość prefiksu, liczba bitów wartości)
+_DOD_CLASSES = ((0b10, 2, 7), (0b110, 3, 9), (0b1110, 4, 12))
+
+
+def _write_dod(bits, dod):
+    if dod == 0:
+        bits.write(0, 1)
+        return
+    for prefix, plen, nbits in _DOD_CLASSES:
+        if -(1 << (nbits - 1)) <= dod < (1 << (nbits - 1)):
+            bits.write(prefix, plen)
+            bits.write(dod, nbits)
+            return
+    bits.write(0b1111, 4)
+    bits.write(dod, 64)
+
+
+def _signed(value, nbits):
+    return value - (1 << nbits) if value >= (1 << (nbits - 1)) else value
+
+
+def _read_dod(bits):
+    if bits.read(1) == 0:
+        return 0
+    for _, plen, nbits in _DOD_CLASSES:
+        if bits.read(1) == 0:
+            return _signed(bits.read(nbits), nbits)
+    return _signed(bits.read(64), 64)
+
+
+class _ValueEncoder:
+    def __init__(self):
+        self.prev = None
+        self.leading = -1
+        self.trailing = 0
+
+    def write(self, bits, value):
+        current = _float_bits(value)
+        if self.prev is None:
+            bits.write(current, 64)
+            self.prev = current
+            return
+
+        xor = current ^ self.prev
+        self.prev = current
+        if xor == 0:
+            bits.write(0, 1)
+            return
+
+        leading = min(64 - xor.bit_length(), 31)
+        trailing = (xor & -xor).bit_length() - 1
+        if self.leading >= 0 and leading >= self.leading and trailing >= self.trailing:
+            # Znaczące bity mieszczą się w oknie poprzedniej wartości
+            bits.write(0b10, 2)
+            bits.write(xor >> self.trailing, 64 - self.leading - self.trailing)
+        else:
+            length = 64 - leading - trailing
+            bits.write(0b11, 2)
+            bits.write(leading, 5)
+            bits.write(length - 1, 6)
+            bits.write(xor >> trailing, length)
+            self.leading, self.trailing = leading, trailing
+
+
+class _ValueDecoder:
+    def __init__(self):
+        self.prev = None
+        self.leading = 0
+        self.trailing = 0
+
+    def read(self, bits):
+        if self.prev is None:
+            self.prev = bits.read(64)
+        elif bits.read(1):
+            if bits.read(1):
+                self.leading = bits.read(5)
+                length = bits.read(6) + 1
+                self.trailing = 64 - self.leading - length
+            xor = bits.read(64 - self.leading - self.trailing) << self.trailing
+            self.prev ^= xor
+        return _bits_float(self.prev)
+
+
+class _BlockEncoder:
+    def __init__(self, channels):
+        self.bits = _BitWriter()
+        self.values = [_ValueEncoder() for _ in range(channels)]
+        self.count = 0
+        self.t_first = self.t_last = 0
+        self.delta = 0
+
+    def append(self, t, values):
+        if self.count == 0:
+            self.t_first = t
+        else:
+            delta = t - self.t_last
+            _write_dod(self.bits, delta - self.delta)
+            self.delta = delta
+        self.t_last = t
+        for encoder, value in zip(self.values, values):
+            encoder.write(self.bits, value)
+        self.count += 1
+
+    def encode(self):
+        payload = self.bits.getvalue()
+        return BLOCK_HEADER.pack(BLOCK_MAGIC, self.count, self.t_first, self.t_last, len(payload)) + payload
+
+
+def _decode_block(payload, count, t_first, channels):
+    bits = _BitReader(payload)
+    decoders = [_ValueDecoder() for _ in range(channels)]
+    times = []
+    columns = [[] for _ in range(channels)]
+    t = t_first
+    delta = 0
+    for i in range(count):
+        if i:
+            delta += _read_dod(bits)
+            t += delta
+        times.append(t)
+        for decoder, column in zip(decoders, columns):
+            column.append(decoder.read(bits))
+    return times, columns
+
+
+def _encode_header(channels):
+    header = bytearray(FILE_MAGIC)
+    header += struct.pack("<H", len(channels))
+    for name in channels:
+        encoded = name.encode()
+        header += struct.pack("<B", len(encoded)) + encoded
+    return bytes(header)
+
+
+def _decode_header(buffer):
+    if buffer[:len(FILE_MAGIC)] != FILE_MAGIC:
+        raise ValueError("nieprawidłowy nagłówek pliku")
+    pos = len(FILE_MAGIC)
+    (count,) = struct.unpack_from("<H", buffer, pos)
+    pos += 2
+    channels = []
+    for _ in range(count):
+        length = buffer[pos]
+        channels.append(bytes(buffer[pos + 1:pos + 1 + length]).decode())
+        pos += 1 + length
+    return channels, pos
+
+
+class Writer:
+    """Zapis strumieniowy. Czasy w milisekundach (int), kolejne czasy nie mogą maleć.
+
+    W pamięci przechowywany jest co najwyżej jeden niepełny blok; zapisywany jest on po
+    zapełnieniu, a niepełny - przy close() lub flush(partial=True). Niepełny blok zapisany
+    przez flush() jest przy kolejnym zapisie nadpisywany dłuższą wersją, więc zamknięte bloki
+    mają zawsze block_samples próbek, a kompresja nie zależy od częstości flush().
+    """
+
+    def __init__(self, path, channels, block_samples=BLOCK_SAMPLES):
+        self.channels = list(channels)
+        self.block_samples = block_samples
+        # Bez trybu "a" - dopisywanie wymuszone przez system uniemożliwiłoby nadpisanie bloku
+        self.file = os.fdopen(os.open(path, os.O_RDWR | os.O_CREAT, 0o644), "r+b")
+        self.file.seek(0, os.SEEK_END)
+        if self.file.tell() == 0:
+            self.file.write(_encode_header(self.channels))
+        else:
+            with open(path, "rb") as existing:
+                stored, _ = _decode_header(existing.read(4096))
+            if stored != self.channels:
+                raise ValueError(f"{path}: inne kanały w istniejącym pliku: {stored}")
+        self.block = _BlockEncoder(len(self.channels))
+        self.tail_pos = None  # położenie zapisanej wersji bieżącego bloku
+
+    def append(self, t_ms, *values):
+        if len(values) != len(self.channels):
+            raise ValueError("liczba wartości różna od liczby kanałów")
+        self.block.append(int(t_ms), [float(v) for v in values])
+        if self.block.count >= self.block_samples:
+            self._write_block()
+
+    def _write_tail(self):
+        if self.tail_pos is None:
+            self.tail_pos = self.file.tell()
+        else:
+            self.file.seek(self.tail_pos)
+        self.file.write(self.block.encode())
+
+    def _write_block(self):
+        if self.block.count:
+            self._write_tail()
+            self.block = _BlockEncoder(len(self.channels))
+            self.tail_pos = None
+
+    def flush(self, partial=False):
+        if partial and self.block.count:
+            self._write_tail()
+        self.file.flush()
+
+    def tell(self):
+        return self.file.tell()
+
+    def close(self):
+        self._write_block()
+        self.file.close()
+
+
+class Reader:
+    """Odczyt przez mapowanie pliku w pamięci; dekodowane są tylko bloki z zadanego zakresu."""
+
+    def __init__(self, path):
+        self.file = open(path, "rb")
+        size = os.fstat(self.file.fileno()).st_size
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ) if size else b""
+        self.channels, pos = _decode_header(self.map)
+
+        # Indeks bloków: (t_pierwsze, t_ostatnie, przesunięcie danych, liczba próbek, długość)
+        self.index = []
+        while pos + BLOCK_HEADER.size <= size:
+            magic, count, t_first, t_last, length = BLOCK_HEADER.unpack_from(self.map, pos)
+            if magic != BLOCK_MAGIC or pos + BLOCK_HEADER.size + length > size:
+                break
+            self.index.append((t_first, t_last, pos + BLOCK_HEADER.size, count, length))
+            pos += BLOCK_HEADER.size + length
+        self._t_last = [entry[1] for entry in self.index]
+
+    def __len__(self):
+        return sum(entry[3] for entry in self.index)
+
+    def time_range(self):
+        if not self.index:
+            return None
+        return self.index[0][0], self.index[-1][1]
+
+    def read(self, t0=None, t1=None):
+        """Zwraca (czasy [ms], {kanał: wartości}) dla próbek z przedziału [t0, t1]."""
+        times = []
+        columns = [[] for _ in self.channels]
+        start = 0 if t0 is None else bisect_left(self._t_last, t0)
+        for t_first, t_last, offset, count, length in self.index[start:]:
+            if t1 is not None and t_first > t1:
+                break
+            block_times, block_columns = _decode_block(self.map[offset:offset + length], count, t_first,
+                                                       len(self.channels))
+            lo = 0 if t0 is None or t_first >= t0 else bisect_left(block_times, t0)
+            hi = count if t1 is None or t_last <= t1 else bisect_left(block_times, t1 + 1)
+            times.extend(block_times[lo:hi])
+            for column, block_column in zip(columns, block_columns):
+                column.extend(block_column[lo:hi])
+        return times, dict(zip(self.channels, columns))
+
+    def close(self):
+        if isinstance(self.map, mmap.mmap):
+            self.map.close()
+        self.file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
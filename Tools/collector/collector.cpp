@@ -0,0 +1,572 @@
+/**
+ * @file collector.cpp
+ * @brief Kolektor telemetrii: właściciel portu szeregowego z rozgłaszaniem do klientów lokalnych.
+ *
+ * Program otwiera port szeregowy sterownika, dzieli strumień na ramki (linie tekstowe
+ * oraz blok rejestratora "SCOPE <n> <rozmiar> <pre>\n" + dane binarne) i rozsyła każdą
+ * ramkę bez zmian do dowolnej liczby klientów TCP (tylko 127.0.0.1) i gniazda Unix.
+ * Polecenia przesłane przez klientów (linie zakończone '\n') są przekazywane do sterownika,
+ * z wyjątkiem zmiany prędkości ("B...") - prędkość portu ustala opcja -b, klient dostaje "B ERR".
+ *
+ * Odczyt portu odbywa się w osobnym wątku i nigdy nie czeka na klientów: każdy klient ma
+ * własną kolejkę o ograniczonej długości, a przy jej przepełnieniu odrzucane są najstarsze
+ * ramki. Wątek sieciowy obsługuje wszystkie gniazda nieblokująco w pętli poll(); polecenia
+ * klientów trafiają do wspólnego bufora, z którego zapis do portu (osobny deskryptor
+ * nieblokujący) odbywa się w tej samej pętli, więc zablokowany port nie wstrzymuje klientów.
+ *
+ * Budowanie (Linux/macOS):
+ *   g++ -O2 -std=c++17 -pthread -o collector collector.cpp
+ *
+ * Użycie:
+ *   collector -d /dev/ttyACM0 [-b 9600] [-p 5760] [-u /tmp/pp_collector.sock] [-q 4096]
+ */
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Frame = std::shared_ptr<const std::string>;
+
+constexpr size_t MAX_LINE_LEN = 256;        // dłuższe linie traktowane jako śmieci
+constexpr size_t MAX_SCOPE_BYTES = 1 << 20; // ograniczenie rozmiaru bloku rejestratora
+constexpr size_t MAX_COMMAND_LEN = 256;     // CMD_LINE_LEN z Core/Inc/command.h (bez '\n')
+constexpr size_t MAX_SERIAL_OUT = 4096;     // polecenia oczekujące na zapis do portu
+
+std::atomic<bool> running{true};
+
+void on_signal(int)
+{
+    running = false;
+}
+
+speed_t baud_to_speed(long baud)
+{
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+#ifdef B460800
+    case 460800: return B460800;
+#endif
+#ifdef B921600
+    case 921600: return B921600;
+#endif
+#ifdef B2000000
+    case 2000000: return B2000000;
+#endif
+    default: return 0;
+    }
+}
+
+int open_serial(const char *path, long baud)
+{
+    speed_t speed = baud_to_speed(baud);
+    if (speed == 0) {
+        fprintf(stderr, "Nieobsługiwana prędkość: %ld\n", baud);
+        return -1;
+    }
+
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+
+    termios tio{};
+    if (tcgetattr(fd, &tio) != 0) {
+        perror("tcgetattr");
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    // Odczyt kończy się po pierwszym bajcie lub po 100 ms, aby wątek reagował na zakończenie
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 1;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        perror("tcsetattr");
+        close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIFLUSH);
+    return fd;
+}
+
+/**
+ * @brief Otwiera port do zapisu nieblokującego. Ustawienia termios są wspólne z deskryptorem
+ *        odczytu, a O_NONBLOCK dotyczy tylko tego deskryptora (odczyt zostaje z VTIME).
+ */
+int open_serial_writer(const char *path)
+{
+    int fd = open(path, O_WRONLY | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        perror(path);
+    }
+    return fd;
+}
+
+/**
+ * @brief Podział strumienia z portu na ramki.
+ */
+class FrameDecoder {
+public:
+    template <typename Emit>
+    void feed(const char *data, size_t len, Emit &&emit)
+    {
+        for (size_t i = 0; i < len;) {
+            if (scope_remaining_ > 0) {
+                size_t n = std::min(scope_remaining_, len - i);
+                current_.append(data + i, n);
+                scope_remaining_ -= n;
+                i += n;
+                if (scope_remaining_ == 0) {
+                    emit(std::move(current_));
+                    current_.clear();
+                }
+                continue;
+            }
+
+            char c = data[i++];
+            current_.push_back(c);
+            if (c != '\n') {
+                if (current_.size() > MAX_LINE_LEN) {
+                    current_.clear();
+                    garbage_++;
+                }
+                continue;
+            }
+
+            unsigned long count, size, pre;
+            if (current_.compare(0, 6, "SCOPE ") == 0 &&
+                sscanf(current_.c_str() + 6, "%lu %lu %lu", &count, &size, &pre) == 3 &&
+                count * size <= MAX_SCOPE_BYTES) {
+                // Nagłówek i blok binarny rozsyłane jako jedna ramka
+                scope_remaining_ = count * size;
+                if (scope_remaining_ > 0) {
+                    continue;
+                }
+            }
+            emit(std::move(current_));
+            current_.clear();
+        }
+    }
+
+    unsigned long garbage() const { return garbage_; }
+
+private:
+    std::string current_;
+    size_t scope_remaining_ = 0;
+    unsigned long garbage_ = 0;
+};
+
+/**
+ * @brief Klient z kolejką ramek o ograniczonej długości.
+ */
+struct Client {
+    int fd;
+    std::string name;
+    std::deque<Frame> queue;
+    size_t offset = 0;          // bajty pierwszej ramki już wysłane
+    unsigned long dropped = 0;
+    std::string command;        // polecenie w trakcie odbioru
+    bool command_overflow = false; // reszta zbyt długiej linii jest pomijana do '\n'
+};
+
+/**
+ * @brief Wspólny stan wątku odczytu i wątku sieciowego.
+ */
+class Hub {
+public:
+    Hub(size_t queue_limit, int wake_fd) : queue_limit_(queue_limit), wake_fd_(wake_fd) {}
+
+    void add(std::unique_ptr<Client> client)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients_.push_back(std::move(client));
+    }
+
+    void publish(std::string &&data)
+    {
+        Frame frame = std::make_shared<const std::string>(std::move(data));
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            frames_++;
+            for (auto &c : clients_) {
+                // Pierwsza ramka może być w trakcie wysyłania - nie jest usuwana
+                if (c->queue.size() >= queue_limit_ && c->queue.size() > 1) {
+                    c->queue.erase(c->queue.begin() + 1);
+                    c->dropped++;
+                }
+                c->queue.push_back(frame);
+            }
+        }
+        char b = 1;
+        ssize_t unused = write(wake_fd_, &b, 1); // potok nieblokujący; pełny potok = już obudzony
+        (void)unused;
+    }
+
+    std::mutex &mutex() { return mutex_; }
+    std::vector<std::unique_ptr<Client>> &clients() { return clients_; }
+    unsigned long frames() const { return frames_; }
+
+private:
+    size_t queue_limit_;
+    int wake_fd_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Client>> clients_;
+    unsigned long frames_ = 0;
+};
+
+void set_nonblocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+int listen_tcp(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        perror("tcp");
+        close(fd);
+        return -1;
+    }
+    set_nonblocking(fd);
+    return fd;
+}
+
+int listen_unix(const char *path)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(fd, 16) != 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    set_nonblocking(fd);
+    return fd;
+}
+
+void accept_clients(int listen_fd, Hub &hub, const char *kind)
+{
+    for (;;) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        set_nonblocking(fd);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // bez skutku dla gniazd Unix
+
+        auto client = std::make_unique<Client>();
+        client->fd = fd;
+        client->name = std::string(kind) + "#" + std::to_string(fd);
+        fprintf(stderr, "Połączono: %s\n", client->name.c_str());
+        hub.add(std::move(client));
+    }
+}
+
+/**
+ * @brief Wysyła z kolejki klienta tyle, ile przyjmie gniazdo. Zwraca false przy zerwaniu połączenia.
+ */
+bool flush_client(Client &c)
+{
+    while (!c.queue.empty()) {
+        const std::string &frame = *c.queue.front();
+        ssize_t n = send(c.fd, frame.data() + c.offset, frame.size() - c.offset, MSG_NOSIGNAL);
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        c.offset += static_cast<size_t>(n);
+        if (c.offset < frame.size()) {
+            return true;
+        }
+        c.offset = 0;
+        c.queue.pop_front();
+    }
+    return true;
+}
+
+/**
+ * @brief Dopisuje odpowiedź kolektora do kolejki klienta (wywoływać pod blokadą Hub).
+ */
+void reply_client(Client &c, const char *text)
+{
+    c.queue.push_back(std::make_shared<const std::string>(text));
+}
+
+/**
+ * @brief Odbiera polecenia klienta i dopisuje pełne linie do bufora portu. Zwraca false przy rozłączeniu.
+ */
+bool read_client(Client &c, std::string &serial_out)
+{
+    char buf[256];
+    for (;;) {
+        ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n == 0) {
+            return false;
+        }
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            // Sterownik kończy linię także znakiem '\r' - podział musi być ten sam
+            bool end_of_line = (buf[i] == '\n' || buf[i] == '\r');
+            if (c.command_overflow) {
+                c.command_overflow = !end_of_line;
+                continue;
+            }
+            c.command.push_back(buf[i]);
+            if (end_of_line) {
+                // Prędkość portu ustala kolektor (-b): przełączenie sterownika na polecenie
+                // jednego klienta zerwałoby łącze wszystkim
+                if (c.command.size() == 1) {
+                    // Pusta linia (np. '\n' po '\r') - sterownik i tak ją pomija
+                } else if (c.command[0] == 'B') {
+                    fprintf(stderr, "Zmiana prędkości od %s odrzucona\n", c.name.c_str());
+                    reply_client(c, "B ERR\n");
+                } else if (serial_out.size() + c.command.size() <= MAX_SERIAL_OUT) {
+                    // Port nie nadąża lub stoi - polecenie odrzucane w całości, nie w połowie
+                    serial_out += c.command;
+                } else {
+                    fprintf(stderr, "Bufor portu pełny, odrzucono polecenie od %s\n", c.name.c_str());
+                }
+                c.command.clear();
+            } else if (c.command.size() > MAX_COMMAND_LEN) {
+                // Sterownik i tak odrzuciłby linię - odrzucana w całości, z odpowiedzią dla klienta
+                fprintf(stderr, "Polecenie od %s dłuższe niż %zu znaków, odrzucono\n", c.name.c_str(),
+                        MAX_COMMAND_LEN);
+                reply_client(c, "ERR LEN\n");
+                c.command.clear();
+                c.command_overflow = true;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Zapisuje z bufora do portu tyle, ile przyjmie sterownik tty. Zwraca false przy błędzie portu.
+ */
+bool flush_serial(int fd, std::string &out)
+{
+    while (!out.empty()) {
+        ssize_t n = write(fd, out.data(), out.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return true;
+            }
+            perror("write");
+            return false;
+        }
+        out.erase(0, static_cast<size_t>(n));
+    }
+    return true;
+}
+
+void serial_thread(int serial_fd, Hub &hub, FrameDecoder &decoder)
+{
+    char buf[4096];
+    while (running) {
+        ssize_t n = read(serial_fd, buf, sizeof(buf));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("read");
+            running = false;
+            break;
+        }
+        decoder.feed(buf, static_cast<size_t>(n), [&](std::string &&frame) { hub.publish(std::move(frame)); });
+    }
+}
+
+void usage(const char *prog)
+{
+    fprintf(stderr, "Użycie: %s -d <port> [-b <prędkość>] [-p <port TCP>] [-u <gniazdo Unix>] [-q <długość kolejki>]\n",
+            prog);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *device = nullptr;
+    const char *unix_path = "/tmp/pp_collector.sock";
+    long baud = 9600;
+    int tcp_port = 5760;
+    size_t queue_limit = 4096;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:b:p:u:q:h")) != -1) {
+        switch (opt) {
+        case 'd': device = optarg; break;
+        case 'b': baud = strtol(optarg, nullptr, 10); break;
+        case 'p': tcp_port = static_cast<int>(strtol(optarg, nullptr, 10)); break;
+        case 'u': unix_path = optarg[0] ? optarg : nullptr; break;
+        case 'q': queue_limit = std::max(2ul, strtoul(optarg, nullptr, 10)); break;
+        default: usage(argv[0]); return 2;
+        }
+    }
+    if (device == nullptr) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    int serial_fd = open_serial(device, baud);
+    if (serial_fd < 0) {
+        return 1;
+    }
+    int serial_out_fd = open_serial_writer(device);
+    if (serial_out_fd < 0) {
+        return 1;
+    }
+
+    int wake[2];
+    if (pipe(wake) != 0) {
+        perror("pipe");
+        return 1;
+    }
+    set_nonblocking(wake[0]);
+    set_nonblocking(wake[1]);
+
+    int tcp_fd = tcp_port > 0 ? listen_tcp(tcp_port) : -1;
+    int unix_fd = unix_path ? listen_unix(unix_path) : -1;
+    if (tcp_fd < 0 && unix_fd < 0) {
+        fprintf(stderr, "Brak gniazda nasłuchującego\n");
+        return 1;
+    }
+
+    Hub hub(queue_limit, wake[1]);
+    FrameDecoder decoder;
+    std::string serial_out;
+    std::thread reader(serial_thread, serial_fd, std::ref(hub), std::ref(decoder));
+
+    std::vector<pollfd> fds;
+    while (running) {
+        fds.clear();
+        fds.push_back({wake[0], POLLIN, 0});
+        fds.push_back({tcp_fd, POLLIN, 0});
+        fds.push_back({unix_fd, POLLIN, 0});
+        fds.push_back({serial_out_fd, static_cast<short>(serial_out.empty() ? 0 : POLLOUT), 0});
+        {
+            std::lock_guard<std::mutex> lock(hub.mutex());
+            for (auto &c : hub.clients()) {
+                fds.push_back({c->fd, static_cast<short>(POLLIN | (c->queue.empty() ? 0 : POLLOUT)), 0});
+            }
+        }
+
+        if (poll(fds.data(), fds.size(), 200) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            char drain[64];
+            while (read(wake[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+        if (tcp_fd >= 0 && (fds[1].revents & POLLIN)) {
+            accept_clients(tcp_fd, hub, "tcp");
+        }
+        if (unix_fd >= 0 && (fds[2].revents & POLLIN)) {
+            accept_clients(unix_fd, hub, "unix");
+        }
+
+        {
+            // Wysyłanie i odbiór pod blokadą: wywołania są nieblokujące, a wątek odczytu
+            // czeka na blokadę co najwyżej przez jedno przejście po klientach
+            std::lock_guard<std::mutex> lock(hub.mutex());
+            auto &clients = hub.clients();
+            for (size_t i = 0; i < clients.size();) {
+                Client &c = *clients[i];
+                bool alive = read_client(c, serial_out) && flush_client(c);
+                if (alive) {
+                    i++;
+                    continue;
+                }
+                fprintf(stderr, "Rozłączono: %s (odrzucone ramki: %lu)\n", c.name.c_str(), c.dropped);
+                close(c.fd);
+                clients.erase(clients.begin() + static_cast<long>(i));
+            }
+        }
+
+        // Nowe polecenia zapisywane od razu, reszta po zgłoszeniu POLLOUT
+        if (!flush_serial(serial_out_fd, serial_out)) {
+            break;
+        }
+    }
+
+    running = false;
+    reader.join();
+    fprintf(stderr, "Ramki: %lu, odrzucone linie: %lu\n", hub.frames(), decoder.garbage());
+
+    for (auto &c : hub.clients()) {
+        close(c->fd);
+    }
+    if (unix_fd >= 0) {
+        close(unix_fd);
+        unlink(unix_path);
+    }
+    if (tcp_fd >= 0) {
+        close(tcp_fd);
+    }
+    close(serial_out_fd);
+    close(serial_fd);
+    return 0;
+}
@@ -0,0 +1,276 @@
+/**
+ * @file net_tap.c
+ * @brief Uruchomienie stosu sieciowego sterownika (Core/Src/net.c) na Linuksie przez urządzenie TAP.
+ *
+ * Program zastępuje kontroler ETH interfejsem TAP: ramki odczytane z urządzenia trafiają do
+ * NET_Input, a ramki wysyłane przez stos są zapisywane do urządzenia. Pozwala to sprawdzić ARP,
+ * ping, polecenia UDP i telemetrię multicast bez sprzętu. Odpowiedzi ARP i ping wysyłane są,
+ * jak na kontrolerze ETH, z bufora odebranej ramki. Zamiast regulatora działa prosty model
+ * obiektu pierwszego rzędu, a w każdym takcie (125 ms) wysyłana jest ramka telemetrii w formacie
+ * TELEMETRY_Frame. Obsługiwane polecenia: "Z<temperatura>" i "N".
+ *
+ * Budowanie:
+ *   gcc -O2 -Wall -I../../Core/Inc -o net_tap net_tap.c ../../Core/Src/net.c
+ *
+ * Użycie (wymaga CAP_NET_ADMIN):
+ *   net_tap [-i pptap0] [-a 10.0.76.2] [-m 255.255.255.0]
+ *   ip addr add 10.0.76.1/24 dev pptap0 && ip link set pptap0 up
+ *   ping 10.0.76.2
+ *   echo N | nc -u -w1 10.0.76.2 5760
+ *   socat -u UDP4-RECV:5761,ip-add-membership=239.255.76.1:pptap0 - | xxd
+ */
+
+#include "net.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Zgodne z Core/Inc/command.h i Core/Inc/obsluga.h */
+#define CMD_UDP_PORT     5760u
+#define TELEMETRY_GROUP  NET_IP(239, 255, 76, 1)
+#define TELEMETRY_PORT   5761u
+#define TELEMETRY_MAGIC  0x31545050u
+
+#define TICK_MS          125u
+#define DEVICE_ID        0x00C0FFEEu
+
+/* Układ pól jak SCOPE_Sample i TELEMETRY_Frame (little-endian) */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t device;
+    uint32_t seq;
+    uint8_t mode;
+    uint8_t reserved[3];
+    uint32_t tick;
+    float measurement;
+    float setpoint;
+    float p_term;
+    float i_term;
+    float d_term;
+    float output;
+    uint32_t duty;
+    uint32_t isr_cycles;
+} TelemetryFrame;
+
+static volatile sig_atomic_t running = 1;
+static int tap_fd = -1;
+static uint8_t tx_frame[NET_FRAME_MAX];
+
+static float plant_temperature = 22.0f;
+static float plant_setpoint = 22.0f;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    running = 0;
+}
+
+static uint64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static int tap_open(const char *name)
+{
+    struct ifreq ifr;
+    int fd = open("/dev/net/tun", O_RDWR);
+
+    if (fd < 0) {
+        perror("/dev/net/tun");
+        return -1;
+    }
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+    if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+        perror("TUNSETIFF");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static uint8_t *tap_tx_alloc(void *ctx)
+{
+    (void)ctx;
+    return tx_frame;
+}
+
+/* Zapis do urządzenia TAP jest synchroniczny, więc bufor jest wolny od razu po tx_send */
+static NET_Status tap_tx_send(void *ctx, uint8_t *frame, uint16_t len)
+{
+    (void)ctx;
+    return write(tap_fd, frame, len) == (ssize_t)len ? NET_OK : NET_ERROR;
+}
+
+static void tap_tx_release(void *ctx, uint8_t *frame)
+{
+    (void)ctx;
+    (void)frame;
+}
+
+void NET_UdpReceiveCallback(uint32_t src_ip, uint16_t src_port, uint16_t dst_port, const uint8_t *data, uint16_t len)
+{
+    char line[65];
+    char reply[96];
+    const NET_Stats *stats;
+    int n;
+
+    if (dst_port != CMD_UDP_PORT || len == 0) {
+        return;
+    }
+    n = len < sizeof(line) - 1 ? len : (int)sizeof(line) - 1;
+    memcpy(line, data, (size_t)n);
+    line[n] = '\0';
+    line[strcspn(line, "\r\n")] = '\0';
+
+    switch (line[0]) {
+    case 'Z':
+        plant_setpoint = strtof(line + 1, NULL);
+        break;
+    case 'N':
+        stats = NET_GetStats();
+        n = snprintf(reply, sizeof(reply), "N %u.%u.%u.%u UP %08X rx %u/%u tx %u/%u arp %u\n",
+                     NET_GetConfig()->ip >> 24, (NET_GetConfig()->ip >> 16) & 0xFFu,
+                     (NET_GetConfig()->ip >> 8) & 0xFFu, NET_GetConfig()->ip & 0xFFu, DEVICE_ID,
+                     stats->rx_frames, stats->rx_dropped, stats->tx_frames, stats->tx_dropped,
+                     stats->arp_misses);
+        if (NET_UdpSend(src_ip, src_port, CMD_UDP_PORT, (const uint8_t *)reply, (uint16_t)n) != NET_OK) {
+            fprintf(stderr, "reply to N not sent\n");
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void send_telemetry(uint32_t tick)
+{
+    static uint32_t seq = 0;
+    TelemetryFrame *frame;
+
+    // Obiekt pierwszego rzędu ze stałą czasową 20 s, regulator proporcjonalny
+    float output = 4.0f * (plant_setpoint - plant_temperature);
+    output = output < 0.0f ? 0.0f : (output > 25.0f ? 25.0f : output);
+    plant_temperature += (output - (plant_temperature - 20.0f)) * (TICK_MS / 1000.0f) / 20.0f;
+
+    // Jak w firmware: ramka budowana na miejscu w buforze nadawczym
+    frame = (TelemetryFrame *)NET_UdpBegin();
+    if (frame == NULL) {
+        return;
+    }
+    memset(frame, 0, sizeof(*frame));
+    frame->magic = TELEMETRY_MAGIC;
+    frame->device = DEVICE_ID;
+    frame->seq = seq++;
+    frame->tick = tick;
+    frame->measurement = plant_temperature;
+    frame->setpoint = plant_setpoint;
+    frame->p_term = output;
+    frame->output = output;
+    frame->duty = (uint32_t)(output / 25.0f * 144000.0f);
+
+    NET_UdpEnd(TELEMETRY_GROUP, TELEMETRY_PORT, TELEMETRY_PORT, sizeof(*frame));
+}
+
+int main(int argc, char **argv)
+{
+    const char *ifname = "pptap0";
+    struct in_addr addr = {0}, mask = {0};
+    NET_Mac mac = {0};
+    NET_Config config;
+    static uint8_t frame[2048];
+    uint64_t next_tick;
+    uint32_t tick = 0;
+    int opt;
+
+    inet_aton("10.0.76.2", &addr);
+    inet_aton("255.255.255.0", &mask);
+
+    while ((opt = getopt(argc, argv, "i:a:m:")) != -1) {
+        switch (opt) {
+        case 'i':
+            ifname = optarg;
+            break;
+        case 'a':
+            if (!inet_aton(optarg, &addr)) {
+                fprintf(stderr, "bad address %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'm':
+            if (!inet_aton(optarg, &mask)) {
+                fprintf(stderr, "bad netmask %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-i ifname] [-a address] [-m netmask]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    tap_fd = tap_open(ifname);
+    if (tap_fd < 0) {
+        return 1;
+    }
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    // Adres lokalnie administrowany, różny od adresu interfejsu TAP po stronie hosta
+    mac.addr[0] = 0x02;
+    mac.addr[5] = 0x02;
+    mac.tx_alloc = tap_tx_alloc;
+    mac.tx_send = tap_tx_send;
+    mac.tx_release = tap_tx_release;
+    mac.checksum_offload = 0;
+
+    config.ip = ntohl(addr.s_addr);
+    config.netmask = ntohl(mask.s_addr);
+    config.gateway = 0;
+    NET_Init(&mac, &config);
+
+    fprintf(stderr, "%s: %s up, telemetry to 239.255.76.1:%u, commands on port %u\n",
+            argv[0], ifname, TELEMETRY_PORT, CMD_UDP_PORT);
+
+    next_tick = now_ms() + TICK_MS;
+    while (running) {
+        struct pollfd pfd = {tap_fd, POLLIN, 0};
+        uint64_t now = now_ms();
+        int timeout = now >= next_tick ? 0 : (int)(next_tick - now);
+
+        if (poll(&pfd, 1, timeout) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            break;
+        }
+        if (pfd.revents & POLLIN) {
+            ssize_t n = read(tap_fd, frame, sizeof(frame));
+            if (n > 0) {
+                NET_Input(frame, (uint16_t)n);
+            }
+        }
+        if (now_ms() >= next_tick) {
+            next_tick += TICK_MS;
+            send_telemetry(++tick);
+        }
+    }
+
+    close(tap_fd);
+    return 0;
+}
@@ -0,0 +1,566 @@
+/**
+ * @file pid_tune.c
+ * @brief Dobór nastaw regulatora PID na modelu obiektu, z użyciem kodu regulatora sterownika.
+ *
+ * Program symuluje pętlę regulacji dokładnie tak, jak wykonuje ją sterownik w każdym takcie
+ * (125 ms): pomiar z szumem i rozdzielczością czujnika, estymator alfa-beta
+ * (Core/Src/estimator.c), PID_ComputeWithRate (Core/Src/pid.c) i kwantyzacja wypełnienia PWM.
+ * Obiekt to grzałka pierwszego rzędu z opóźnieniem transportowym i inercją czujnika.
+ *
+ * Każda ocena nastaw to seria testów skokowych (różne temperatury początkowe, wielkości
+ * i kierunki skoku, rozrzut parametrów obiektu i szum). Seria jest losowana raz, więc ocena
+ * jest deterministyczna i porównuje nastawy na tych samych testach. Koszt testu:
+ *
+ *   w_iae * IAE/|skok| [s] + w_ovs * przeregulowanie [%] + w_wear * droga sterowania [pełne zakresy]
+ *
+ * (przeregulowanie liczone względem wartości ustalonej w ostatnich 10% obserwacji),
+ * a koszt nastaw to średnia z serii. Minimum szukane jest metodą Neldera-Meada
+ * w przestrzeni log(Kp, Ki, |Kd|) z wielokrotnym startem z losowych punktów; starty
+ * rozdzielane są między wątki. Pierwszy start to moduły nastaw z main.c.
+ *
+ * Kd ma zawsze znak ujemny: pid.c dodaje Kd * (zmiana temperatury), więc tłumienie
+ * (hamowanie grzania przy szybkim wzroście temperatury) wymaga Kd < 0.
+ *
+ * Budowanie:
+ *   gcc -O2 -Wall -pthread -I../../Core/Inc -o pid_tune pid_tune.c ../../Core/Src/pid.c ../../Core/Src/estimator.c -lm
+ *
+ * Użycie:
+ *   pid_tune [-K 1.0] [-T 60] [-s 5] [-L 2] [-a 22] [-n 0.02] [-u 0.2]
+ *            [-S 32] [-D 600] [-w 1,10,0.05] [-r 64] [-i 400] [-j wątki] [-t 5] [-x ziarno]
+ *
+ *   -K  wzmocnienie obiektu [°C na jednostkę wyjścia regulatora 0..25]
+ *   -T  stała czasowa grzałki [s]      -s  stała czasowa czujnika [s]
+ *   -L  opóźnienie transportowe [s]   -a  temperatura otoczenia [°C]
+ *   -n  odchylenie standardowe szumu pomiaru [°C]
+ *   -u  względny rozrzut K, T i L między testami (0.2 = ±20%)
+ *   -S  liczba testów skokowych na ocenę   -D  czas obserwacji po skoku [s]
+ *   -w  wagi kosztu: IAE, przeregulowanie, droga sterowania
+ *   -r  liczba startów    -i  limit ocen na start    -j  liczba wątków
+ *   -t  liczba wypisywanych zestawów nastaw          -x  ziarno losowania testów
+ */
+
+#include "estimator.h"
+#include "pid.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Zgodne z Core/Src/main.c i Core/Src/obsluga.c */
+#define TICK_S          0.125
+#define OUTPUT_MAX      25.0
+#define PWM_PERIOD      144000.0
+#define EST_PROCESS     0.05f
+#define EST_MEAS        0.02f
+#define FW_KP           20.0
+#define FW_KI           0.3
+#define FW_KD           320.0
+#define FW_DELAY        1.0
+#define FW_INTEGRAL_MAX 25.0
+
+#define SENSOR_LSB      0.01        /* rozdzielczość temperatury BMP280 */
+#define SUBSTEPS        5           /* kroki całkowania modelu na takt */
+#define WARMUP_S        180.0       /* ustalenie stanu przed skokiem (bez kosztu) */
+#define MAX_DEAD_TICKS  512
+#define PARAMS          3
+#define COST_UNSTABLE   1e6
+
+typedef struct {
+    double gain;                /* K */
+    double tau;                 /* T */
+    double tau_sensor;          /* s */
+    double dead_time;           /* L */
+    double ambient;
+    double noise;
+    double start;               /* temperatura przed skokiem */
+    double target;              /* temperatura po skoku */
+    uint64_t seed;              /* szum pomiaru */
+} Scenario;
+
+typedef struct {
+    double cost;
+    double iae;                 /* średnie IAE/|skok| [s] */
+    double overshoot;           /* średnie przeregulowanie [%] */
+    double overshoot_max;
+    double wear;                /* średnia droga sterowania [pełne zakresy] */
+} Score;
+
+typedef struct {
+    double gains[PARAMS];
+    Score score;
+    uint32_t evals;
+} Result;
+
+static Scenario *scenarios;
+static int scenario_count = 32;
+static double step_duration = 600.0;
+static double weight_iae = 1.0, weight_ovs = 10.0, weight_wear = 0.05;
+static int max_evals = 400;
+
+/* Granice przeszukiwania modułów nastaw (log) i znaki nastaw (Kd tłumiące = ujemne) */
+static const double gain_min[PARAMS] = {0.1, 1e-3, 0.01};
+static const double gain_max[PARAMS] = {500.0, 20.0, 5000.0};
+static const double gain_sign[PARAMS] = {1.0, 1.0, -1.0};
+
+static pthread_mutex_t work_lock = PTHREAD_MUTEX_INITIALIZER;
+static int next_restart;
+static int restart_count = 64;
+static int restarts_done;
+static Result *results;
+static uint64_t base_seed = 1;
+
+static uint64_t rng_next(uint64_t *s)
+{
+    // xorshift64*
+    *s ^= *s >> 12;
+    *s ^= *s << 25;
+    *s ^= *s >> 27;
+    return *s * 0x2545F4914F6CDD1Dull;
+}
+
+static double rng_uniform(uint64_t *s)
+{
+    return (double)(rng_next(s) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double rng_gauss(uint64_t *s)
+{
+    double u1 = rng_uniform(s), u2 = rng_uniform(s);
+
+    if (u1 < 1e-300) {
+        u1 = 1e-300;
+    }
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/* Jeden test skokowy; zwraca 0, gdy przebieg się rozbiega */
+static int simulate(const double gains[PARAMS], const Scenario *sc, double *iae, double *overshoot, double *wear)
+{
+    PID pid;
+    ESTIMATOR est;
+    double dead[MAX_DEAD_TICKS];
+    uint64_t rng = sc->seed;
+    int dead_ticks = (int)lround(sc->dead_time / TICK_S);
+    int warmup = (int)(WARMUP_S / TICK_S);
+    int ticks = warmup + (int)(step_duration / TICK_S);
+    double u0 = (sc->start - sc->ambient) / sc->gain;
+    double heater = sc->start, sensor = sc->start;
+    double u = u0, u_prev = u0;
+    double step = sc->target - sc->start;
+    double dir = step > 0.0 ? 1.0 : -1.0;
+    double peak = -INFINITY, final = 0.0;
+    int final_from = ticks - (ticks - warmup) / 10;
+    double h = TICK_S / SUBSTEPS;
+
+    if (dead_ticks >= MAX_DEAD_TICKS) {
+        dead_ticks = MAX_DEAD_TICKS - 1;
+    }
+    for (int i = 0; i <= dead_ticks; i++) {
+        dead[i] = u0;
+    }
+
+    PID_Init(&pid, gains[0], gains[1], gains[2], sc->start, FW_DELAY, TICK_S, 0, FW_INTEGRAL_MAX, 0, OUTPUT_MAX);
+    // Integrator w stanie ustalonym dla temperatury początkowej (jak po długiej regulacji)
+    pid.integral = gains[1] > 0.0 ? fmin(fmax(u0 / gains[1], 0.0), FW_INTEGRAL_MAX) : 0.0;
+    pid.prev_input = sc->start;
+    pid.prev_output = u0;
+    ESTIMATOR_InitFromNoise(&est, EST_PROCESS, EST_MEAS, (float)TICK_S);
+    est.x = (float)sc->start;
+    est.v = 0.0f;
+
+    *iae = 0.0;
+    *wear = 0.0;
+
+    for (int k = 0; k < ticks; k++) {
+        double meas, out, applied;
+
+        if (k == warmup) {
+            change_PID_setpoint(&pid, sc->target);
+        }
+
+        // Pomiar: szum i rozdzielczość czujnika
+        meas = sensor + sc->noise * rng_gauss(&rng);
+        meas = round(meas / SENSOR_LSB) * SENSOR_LSB;
+        ESTIMATOR_Update(&est, (float)meas);
+
+        // Regulator i kwantyzacja wypełnienia jak w sterowniku
+        out = PID_ComputeWithRate(&pid, est.x, est.v);
+        applied = round(out / OUTPUT_MAX * PWM_PERIOD) * OUTPUT_MAX / PWM_PERIOD;
+        u = applied;
+
+        // Opóźnienie transportowe (bufor cykliczny o długości dead_ticks + 1)
+        dead[k % (dead_ticks + 1)] = u;
+        applied = dead[(k + 1) % (dead_ticks + 1)];
+
+        for (int i = 0; i < SUBSTEPS; i++) {
+            heater += h * (sc->gain * applied - (heater - sc->ambient)) / sc->tau;
+            sensor += h * (heater - sensor) / sc->tau_sensor;
+        }
+        if (!isfinite(sensor) || fabs(sensor - sc->ambient) > 1000.0) {
+            return 0;
+        }
+
+        if (k >= warmup) {
+            *iae += fabs(sc->target - sensor) * TICK_S;
+            *wear += fabs(u - u_prev);
+            if (dir * sensor > peak) {
+                peak = dir * sensor;
+            }
+            if (k >= final_from) {
+                final += sensor / (ticks - final_from);
+            }
+        }
+        u_prev = u;
+    }
+
+    *iae /= fabs(step);
+    // Przeregulowanie względem wartości końcowej (uchyb ustalony zawiera już IAE)
+    *overshoot = fmax(peak - dir * final, 0.0) / fmax(fabs(final - sc->start), 0.1 * fabs(step)) * 100.0;
+    *wear /= OUTPUT_MAX;
+    return 1;
+}
+
+static void evaluate(const double gains[PARAMS], Score *score)
+{
+    double iae, ovs, wear;
+
+    memset(score, 0, sizeof(*score));
+    for (int i = 0; i < scenario_count; i++) {
+        if (!simulate(gains, &scenarios[i], &iae, &ovs, &wear)) {
+            score->cost = COST_UNSTABLE;
+            return;
+        }
+        score->iae += iae;
+        score->overshoot += ovs;
+        score->wear += wear;
+        if (ovs > score->overshoot_max) {
+            score->overshoot_max = ovs;
+        }
+    }
+    score->iae /= scenario_count;
+    score->overshoot /= scenario_count;
+    score->wear /= scenario_count;
+    score->cost = weight_iae * score->iae + weight_ovs * score->overshoot + weight_wear * score->wear;
+}
+
+/* Punkt w przestrzeni log -> nastawy w granicach */
+static void to_gains(const double x[PARAMS], double gains[PARAMS])
+{
+    for (int i = 0; i < PARAMS; i++) {
+        gains[i] = gain_sign[i] * fmin(fmax(exp(x[i]), gain_min[i]), gain_max[i]);
+    }
+}
+
+static double nm_cost(const double x[PARAMS], Score *score, uint32_t *evals)
+{
+    double gains[PARAMS];
+
+    to_gains(x, gains);
+    evaluate(gains, score);
+    (*evals)++;
+    return score->cost;
+}
+
+/* Nelder-Mead w przestrzeni log(Kp, Ki, |Kd|) */
+static void nelder_mead(const double start[PARAMS], Result *res)
+{
+    double x[PARAMS + 1][PARAMS];
+    double f[PARAMS + 1];
+    Score s[PARAMS + 1];
+    double centroid[PARAMS], xr[PARAMS], xe[PARAMS], xc[PARAMS];
+    double fr, fe, fc;
+    Score sr, se, sc;
+    uint32_t evals = 0;
+
+    for (int i = 0; i <= PARAMS; i++) {
+        for (int j = 0; j < PARAMS; j++) {
+            x[i][j] = start[j] + (i == j + 1 ? 0.5 : 0.0);
+        }
+        f[i] = nm_cost(x[i], &s[i], &evals);
+    }
+
+    while (evals < (uint32_t)max_evals) {
+        int best = 0, worst = 0, second = 0;
+
+        for (int i = 1; i <= PARAMS; i++) {
+            if (f[i] < f[best]) best = i;
+            if (f[i] > f[worst]) worst = i;
+        }
+        second = best;
+        for (int i = 0; i <= PARAMS; i++) {
+            if (i != worst && f[i] > f[second]) second = i;
+        }
+        if (f[worst] - f[best] <= 1e-6 * (fabs(f[best]) + 1e-9)) {
+            break;
+        }
+
+        for (int j = 0; j < PARAMS; j++) {
+            centroid[j] = 0.0;
+            for (int i = 0; i <= PARAMS; i++) {
+                if (i != worst) centroid[j] += x[i][j] / PARAMS;
+            }
+            xr[j] = centroid[j] + (centroid[j] - x[worst][j]);
+        }
+        fr = nm_cost(xr, &sr, &evals);
+
+        if (fr < f[best]) {
+            for (int j = 0; j < PARAMS; j++) {
+                xe[j] = centroid[j] + 2.0 * (centroid[j] - x[worst][j]);
+            }
+            fe = nm_cost(xe, &se, &evals);
+            if (fe < fr) {
+                memcpy(x[worst], xe, sizeof(xe));
+                f[worst] = fe;
+                s[worst] = se;
+            }
+            else {
+                memcpy(x[worst], xr, sizeof(xr));
+                f[worst] = fr;
+                s[worst] = sr;
+            }
+            continue;
+        }
+        if (fr < f[second]) {
+            memcpy(x[worst], xr, sizeof(xr));
+            f[worst] = fr;
+            s[worst] = sr;
+            continue;
+        }
+
+        // Kontrakcja (zewnętrzna lub wewnętrzna)
+        for (int j = 0; j < PARAMS; j++) {
+            xc[j] = (fr < f[worst]) ? centroid[j] + 0.5 * (xr[j] - centroid[j])
+                                    : centroid[j] + 0.5 * (x[worst][j] - centroid[j]);
+        }
+        fc = nm_cost(xc, &sc, &evals);
+        if (fc < fmin(fr, f[worst])) {
+            memcpy(x[worst], xc, sizeof(xc));
+            f[worst] = fc;
+            s[worst] = sc;
+            continue;
+        }
+
+        // Redukcja sympleksu w stronę najlepszego punktu
+        for (int i = 0; i <= PARAMS; i++) {
+            if (i == best) continue;
+            for (int j = 0; j < PARAMS; j++) {
+                x[i][j] = x[best][j] + 0.5 * (x[i][j] - x[best][j]);
+            }
+            f[i] = nm_cost(x[i], &s[i], &evals);
+        }
+    }
+
+    int best = 0;
+    for (int i = 1; i <= PARAMS; i++) {
+        if (f[i] < f[best]) best = i;
+    }
+    to_gains(x[best], res->gains);
+    res->score = s[best];
+    res->evals = evals;
+}
+
+static void *worker(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        double start[PARAMS];
+        uint64_t rng;
+        int n;
+
+        pthread_mutex_lock(&work_lock);
+        n = next_restart++;
+        pthread_mutex_unlock(&work_lock);
+        if (n >= restart_count) {
+            break;
+        }
+
+        if (n == 0) {
+            start[0] = log(FW_KP);
+            start[1] = log(FW_KI);
+            start[2] = log(fabs(FW_KD));
+        }
+        else {
+            rng = base_seed * 0x9E3779B97F4A7C15ull + (uint64_t)n;
+            rng_next(&rng);
+            for (int j = 0; j < PARAMS; j++) {
+                start[j] = log(gain_min[j]) + rng_uniform(&rng) * (log(gain_max[j]) - log(gain_min[j]));
+            }
+        }
+
+        nelder_mead(start, &results[n]);
+
+        pthread_mutex_lock(&work_lock);
+        restarts_done++;
+        fprintf(stderr, "\r%d/%d startów", restarts_done, restart_count);
+        pthread_mutex_unlock(&work_lock);
+    }
+    return NULL;
+}
+
+static int compare_results(const void *a, const void *b)
+{
+    double ca = ((const Result *)a)->score.cost, cb = ((const Result *)b)->score.cost;
+
+    return (ca > cb) - (ca < cb);
+}
+
+static void make_scenarios(double gain, double tau, double tau_sensor, double dead_time,
+                           double ambient, double noise, double spread)
+{
+    uint64_t rng = base_seed | 1u;
+
+    for (int i = 0; i < scenario_count; i++) {
+        Scenario *sc = &scenarios[i];
+        double lo, hi, step;
+
+        sc->gain = gain * (1.0 + spread * (2.0 * rng_uniform(&rng) - 1.0));
+        sc->tau = tau * (1.0 + spread * (2.0 * rng_uniform(&rng) - 1.0));
+        sc->tau_sensor = tau_sensor;
+        sc->dead_time = dead_time * (1.0 + spread * (2.0 * rng_uniform(&rng) - 1.0));
+        sc->ambient = ambient;
+        sc->noise = noise;
+        sc->seed = rng_next(&rng) | 1u;
+
+        // Zakres osiągalny bez nasycenia: 5..85% pełnej mocy
+        lo = ambient + 0.05 * sc->gain * OUTPUT_MAX;
+        hi = ambient + 0.85 * sc->gain * OUTPUT_MAX;
+        sc->start = lo + rng_uniform(&rng) * (hi - lo);
+        step = 1.0 + rng_uniform(&rng) * 7.0;
+        if (rng_uniform(&rng) < 0.5) {
+            step = -step;
+        }
+        sc->target = fmin(fmax(sc->start + step, lo), hi);
+        if (fabs(sc->target - sc->start) < 0.5) {
+            sc->target = sc->start + (sc->start - lo > hi - sc->start ? -1.0 : 1.0);
+        }
+    }
+}
+
+static void print_result(const char *label, const double gains[PARAMS], const Score *s)
+{
+    printf("# %s: koszt %.4f  IAE %.2f s  przeregulowanie %.2f%% (maks. %.2f%%)  droga %.2f\n",
+           label, s->cost, s->iae, s->overshoot, s->overshoot_max, s->wear);
+    printf("PID_Init(&regulator, %.6g, %.6g, %.6g,temperatura_zadana,%.1f,%.3f,0,%.0f,0,%.0f);\n",
+           gains[0], gains[1], gains[2], FW_DELAY, TICK_S, FW_INTEGRAL_MAX, OUTPUT_MAX);
+}
+
+int main(int argc, char **argv)
+{
+    double gain = 1.0, tau = 60.0, tau_sensor = 5.0, dead_time = 2.0;
+    double ambient = 22.0, noise = 0.02, spread = 0.2;
+    const double fw_gains[PARAMS] = {FW_KP, FW_KI, FW_KD};
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int top = 5, printed = 0;
+    pthread_t *tid;
+    Score fw_score;
+    struct timespec t0, t1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "K:T:s:L:a:n:u:S:D:w:r:i:j:t:x:")) != -1) {
+        switch (opt) {
+        case 'K': gain = atof(optarg); break;
+        case 'T': tau = atof(optarg); break;
+        case 's': tau_sensor = atof(optarg); break;
+        case 'L': dead_time = atof(optarg); break;
+        case 'a': ambient = atof(optarg); break;
+        case 'n': noise = atof(optarg); break;
+        case 'u': spread = atof(optarg); break;
+        case 'S': scenario_count = atoi(optarg); break;
+        case 'D': step_duration = atof(optarg); break;
+        case 'w':
+            if (sscanf(optarg, "%lf,%lf,%lf", &weight_iae, &weight_ovs, &weight_wear) != 3) {
+                fprintf(stderr, "bad weights %s (expected iae,overshoot,wear)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'r': restart_count = atoi(optarg); break;
+        case 'i': max_evals = atoi(optarg); break;
+        case 'j': threads = atol(optarg); break;
+        case 't': top = atoi(optarg); break;
+        case 'x': base_seed = strtoull(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "usage: %s [-K gain] [-T tau] [-s sensor_tau] [-L dead_time] [-a ambient] [-n noise]\n"
+                            "       [-u spread] [-S scenarios] [-D duration] [-w iae,ovs,wear] [-r restarts]\n"
+                            "       [-i evals] [-j threads] [-t top] [-x seed]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (gain <= 0.0 || tau <= 0.0 || tau_sensor <= 0.0 || dead_time < 0.0 || scenario_count < 1
+        || step_duration <= 0.0 || restart_count < 1 || max_evals < PARAMS + 1) {
+        fprintf(stderr, "invalid parameters\n");
+        return 1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    scenarios = calloc((size_t)scenario_count, sizeof(*scenarios));
+    results = calloc((size_t)restart_count, sizeof(*results));
+    tid = calloc((size_t)threads, sizeof(*tid));
+    if (!scenarios || !results || !tid) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    make_scenarios(gain, tau, tau_sensor, dead_time, ambient, noise, spread);
+
+    evaluate(fw_gains, &fw_score);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long i = 0; i < threads; i++) {
+        pthread_create(&tid[i], NULL, worker, NULL);
+    }
+    for (long i = 0; i < threads; i++) {
+        pthread_join(tid[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    uint64_t evals = 0;
+    for (int i = 0; i < restart_count; i++) {
+        evals += results[i].evals;
+    }
+    fprintf(stderr, "\n%llu ocen, %llu testów skokowych, %.1f s, %ld wątków\n",
+            (unsigned long long)evals, (unsigned long long)evals * (uint64_t)scenario_count,
+            (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) * 1e-9, threads);
+
+    printf("# obiekt: K %.3g  T %.3g s  czujnik %.3g s  L %.3g s  otoczenie %.3g  szum %.3g  rozrzut %.0f%%\n",
+           gain, tau, tau_sensor, dead_time, ambient, noise, spread * 100.0);
+    printf("# koszt: %.3g*IAE + %.3g*przeregulowanie + %.3g*droga, %d testów po %.0f s\n",
+           weight_iae, weight_ovs, weight_wear, scenario_count, step_duration);
+    printf("# Kd < 0 - pid.c dodaje Kd*(zmiana temperatury), tłumienie wymaga ujemnego Kd\n");
+    print_result("obecne nastawy", fw_gains, &fw_score);
+
+    // Najlepsze wyniki różnych startów; starty zbieżne do tego samego minimum pomijane
+    qsort(results, (size_t)restart_count, sizeof(*results), compare_results);
+    for (int i = 0; i < restart_count && printed < top; i++) {
+        int duplicate = 0;
+        char label[32];
+
+        if (results[i].score.cost >= COST_UNSTABLE) {
+            break;
+        }
+        for (int k = 0; k < i && !duplicate; k++) {
+            double d = 0.0;
+            for (int j = 0; j < PARAMS; j++) {
+                double e = log(fabs(results[i].gains[j])) - log(fabs(results[k].gains[j]));
+                d += e * e;
+            }
+            duplicate = d < 0.05 * 0.05;
+        }
+        if (duplicate) {
+            continue;
+        }
+        snprintf(label, sizeof(label), "zestaw %d", ++printed);
+        print_result(label, results[i].gains, &results[i].score);
+    }
+
+    free(tid);
+    free(results);
+    free(scenarios);
+    return 0;
+}